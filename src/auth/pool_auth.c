@@ -67,6 +67,8 @@ static int	do_md5_single_backend(POOL_CONNECTION * backend, POOL_CONNECTION * fr
 static void send_md5auth_request(POOL_CONNECTION * frontend, int protoMajor, char *salt);
 static int	read_password_packet(POOL_CONNECTION * frontend, int protoMajor, char *password, int *pwdSize);
 static int	send_password_packet(POOL_CONNECTION * backend, int protoMajor, char *password);
+static void write_password_packet(POOL_CONNECTION * backend, int protoMajor, char *password);
+static int	read_password_response(POOL_CONNECTION * backend, int protoMajor);
 static int	send_auth_ok(POOL_CONNECTION * frontend, int protoMajor);
 static void sendAuthRequest(POOL_CONNECTION * frontend, int protoMajor, int32 auth_req_type, char *extradata, int extralen);
 static long PostmasterRandom(void);
@@ -83,20 +85,30 @@ static bool get_auth_password(POOL_CONNECTION * backend, POOL_CONNECTION * front
 				  char **password, PasswordType *passwordType);
 
 /*
- * Do authentication. Assuming the only caller is
- * make_persistent_db_connection().
+ * Do authentication. Assuming the only callers are
+ * make_persistent_db_connection() and
+ * make_persistent_db_connections_noerror().
  */
 void
 connection_do_auth(POOL_CONNECTION_POOL_SLOT * cp, char *password)
+{
+	connection_finish_auth(cp, connection_start_auth(cp, password));
+}
+
+/*
+ * First half of connection_do_auth(). Read the authentication request and
+ * send the password without waiting for the reply, so that the caller can
+ * send passwords to all the backends before reading any reply. Returns the
+ * authentication method whose reply is still to be read by
+ * connection_finish_auth(), or AUTH_REQ_OK if there's none. SCRAM needs
+ * several round trips and is completed here.
+ */
+int
+connection_start_auth(POOL_CONNECTION_POOL_SLOT * cp, char *password)
 {
 	char		kind;
 	int			length;
 	int			auth_kind;
-	char		state;
-	char	   *p;
-	int			pid,
-				key;
-	bool		keydata_done;
 
 	/*
 	 * read kind expecting 'R' packet (authentication response)
@@ -142,17 +154,12 @@ connection_do_auth(POOL_CONNECTION_POOL_SLOT * cp, char *password)
 
 	if (auth_kind == AUTH_REQ_OK)	/* trust authentication? */
 	{
-		cp->con->auth_kind = AUTH_REQ_OK;
+		return AUTH_REQ_OK;
 	}
 	else if (auth_kind == AUTH_REQ_PASSWORD)	/* clear text password? */
 	{
-		kind = send_password_packet(cp->con, PROTO_MAJOR_V3, password);
-		if (kind != AUTH_REQ_OK)
-			ereport(ERROR,
-					(errmsg("password authentication failed for user:%s", cp->sp->user),
-					 errdetail("backend replied with invalid kind")));
-
-		cp->con->auth_kind = AUTH_REQ_OK;
+		write_password_packet(cp->con, PROTO_MAJOR_V3, password);
+		return AUTH_REQ_PASSWORD;
 	}
 	else if (auth_kind == AUTH_REQ_CRYPT)	/* crypt password? */
 	{
@@ -168,14 +175,9 @@ connection_do_auth(POOL_CONNECTION_POOL_SLOT * cp, char *password)
 					(errmsg("crypt authentication failed for user:%s", cp->sp->user),
 					 errdetail("failed to encrypt the password")));
 
-		/* Send password packet to backend and receive auth response */
-		kind = send_password_packet(cp->con, PROTO_MAJOR_V3, crypt_password);
-		if (kind != AUTH_REQ_OK)
-			ereport(ERROR,
-					(errmsg("crypt authentication failed for user:%s", cp->sp->user),
-					 errdetail("backend replied with invalid kind")));
-
-		cp->con->auth_kind = AUTH_REQ_OK;
+		/* Send password packet to backend */
+		write_password_packet(cp->con, PROTO_MAJOR_V3, crypt_password);
+		return AUTH_REQ_CRYPT;
 	}
 	else if (auth_kind == AUTH_REQ_MD5) /* md5 password? */
 	{
@@ -202,15 +204,10 @@ connection_do_auth(POOL_CONNECTION_POOL_SLOT * cp, char *password)
 		pool_md5_encrypt(buf1, salt, 4, buf + 3);
 		memcpy(buf, "md5", 3);
 
-		/* Send password packet to backend and receive auth response */
-		kind = send_password_packet(cp->con, PROTO_MAJOR_V3, buf);
+		/* Send password packet to backend */
+		write_password_packet(cp->con, PROTO_MAJOR_V3, buf);
 		pfree(buf);
-		if (kind != AUTH_REQ_OK)
-			ereport(ERROR,
-					(errmsg("md5 authentication failed for user:%s", cp->sp->user),
-					 errdetail("backend replied with invalid kind")));
-
-		cp->con->auth_kind = AUTH_REQ_OK;
+		return AUTH_REQ_MD5;
 	}
 	else if (auth_kind == AUTH_REQ_SASL)
 	{
@@ -222,14 +219,42 @@ connection_do_auth(POOL_CONNECTION_POOL_SLOT * cp, char *password)
 		}
 		ereport(DEBUG1,
 				(errmsg("SCRAM authentication successful for user:%s", cp->sp->user)));
-		cp->con->auth_kind = AUTH_REQ_OK;
+		return AUTH_REQ_OK;
 	}
-	else
+
+	ereport(ERROR,
+			(errmsg("failed to authenticate"),
+			 errdetail("auth kind %d is not yet supported", auth_kind)));
+	return AUTH_REQ_OK;			/* keep compiler quiet */
+}
+
+/*
+ * Second half of connection_do_auth(). auth_kind is the return value of
+ * connection_start_auth(). Read the reply to the password if any, then the
+ * backend key data and wait until Ready for query arrives.
+ */
+void
+connection_finish_auth(POOL_CONNECTION_POOL_SLOT * cp, int auth_kind)
+{
+	char		kind;
+	int			length;
+	char		state;
+	char	   *p;
+	int			pid,
+				key;
+	bool		keydata_done;
+
+	if (auth_kind != AUTH_REQ_OK &&
+		read_password_response(cp->con, PROTO_MAJOR_V3) != AUTH_REQ_OK)
 	{
+		const char *method = auth_kind == AUTH_REQ_CRYPT ? "crypt" :
+		auth_kind == AUTH_REQ_MD5 ? "md5" : "password";
+
 		ereport(ERROR,
-				(errmsg("failed to authenticate"),
-				 errdetail("auth kind %d is not yet supported", auth_kind)));
+				(errmsg("%s authentication failed for user:%s", method, cp->sp->user),
+				 errdetail("backend replied with invalid kind")));
 	}
+	cp->con->auth_kind = AUTH_REQ_OK;
 
 	/*
 	 * Read backend key data and wait until Ready for query arriving or error
@@ -1934,18 +1959,37 @@ read_password_packet(POOL_CONNECTION * frontend, int protoMajor, char *password,
  */
 static int
 send_password_packet(POOL_CONNECTION * backend, int protoMajor, char *password)
+{
+	write_password_packet(backend, protoMajor, password);
+	return read_password_response(backend, protoMajor);
+}
+
+/*
+ * Send password packet to backend.
+ */
+static void
+write_password_packet(POOL_CONNECTION * backend, int protoMajor, char *password)
 {
 	int			size;
-	int			len;
-	int			kind;
-	char		response;
 
-	/* Send password packet to backend */
 	if (protoMajor == PROTO_MAJOR_V3)
 		pool_write(backend, "p", 1);
 	size = htonl(sizeof(size) + strlen(password) + 1);
 	pool_write(backend, &size, sizeof(size));
 	pool_write_and_flush(backend, password, strlen(password) + 1);
+}
+
+/*
+ * Receive authentication response packet to the password sent by
+ * write_password_packet(). Return value is the last field of the
+ * response.
+ */
+static int
+read_password_response(POOL_CONNECTION * backend, int protoMajor)
+{
+	int			len;
+	int			kind;
+	char		response;
 
 	pool_read(backend, &response, sizeof(response));
 
@@ -2304,6 +2304,14 @@ char *pool_flag_to_str(unsigned short flag)
 			snprintf(buf+strlen(buf), sizeof(buf), "|ALWAYS_MASTER");
 	}
 
+	if (POOL_ANALYTICS & flag)
+	{
+		if (*buf == '\0')
+			snprintf(buf, sizeof(buf), "ANALYTICS");
+		else
+			snprintf(buf+strlen(buf), sizeof(buf), "|ANALYTICS");
+	}
+
 	return buf;
 }
 
@@ -245,6 +245,18 @@ static const struct config_enum_entry syslog_facility_options[] = {
 	{NULL, 0, false}
 };
 
+static const struct config_enum_entry process_management_mode_options[] = {
+	{"static", PM_STATIC, false},
+	{"dynamic", PM_DYNAMIC, false},
+	{NULL, 0, false}
+};
+
+static const struct config_enum_entry health_check_mode_options[] = {
+	{"per_node", HC_PER_NODE, false},
+	{"multiplexed", HC_MULTIPLEXED, false},
+	{NULL, 0, false}
+};
+
 static const struct config_enum_entry disable_load_balance_on_write_options[] = {
 	{"off", DLBOW_OFF, false},
 	{"transaction", DLBOW_TRANSACTION, false},
@@ -259,6 +271,27 @@ static const struct config_enum_entry relcache_query_target_options[] = {
 	{NULL, 0, false}
 };
 
+static const struct config_enum_entry huge_pages_options[] = {
+	{"off", HUGE_PAGES_OFF, false},
+	{"on", HUGE_PAGES_ON, false},
+	{"try", HUGE_PAGES_TRY, false},
+	{NULL, 0, false}
+};
+
+static const struct config_enum_entry shared_memory_numa_policy_options[] = {
+	{"default", SHMEM_NUMA_DEFAULT, false},
+	{"interleave", SHMEM_NUMA_INTERLEAVE, false},
+	{"local", SHMEM_NUMA_LOCAL, false},
+	{NULL, 0, false}
+};
+
+static const struct config_enum_entry load_balance_policy_options[] = {
+	{"weight", LBPOLICY_WEIGHT, false},	/* random with backend_weight */
+	{"least_loaded", LBPOLICY_LEAST_LOADED, false},	/* least loaded node */
+	{"power_of_two", LBPOLICY_POWER_OF_TWO, false},	/* less loaded of two random nodes */
+	{NULL, 0, false}
+};
+
 static const struct config_enum_entry check_temp_table_options[] = {
 	{"catalog", CHECK_TEMP_CATALOG, false},	/* search system catalogs */
 	{"trace", CHECK_TEMP_TRACE, false},		/* tracing temp tables */
@@ -559,7 +592,7 @@ static struct config_bool ConfigureNamesBool[] =
 
 	{
 		{"enable_shared_relcache", CFGCXT_INIT, CACHE_CONFIG,
-			"relation cache stored in memory cache.",
+			"relation cache is shared among child processes.",
 			CONFIG_VAR_TYPE_BOOL, false, 0
 		},
 		&g_pool_config.enable_shared_relcache,
@@ -577,6 +610,16 @@ static struct config_bool ConfigureNamesBool[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"memqcache_admission_filter", CFGCXT_RELOAD, CACHE_CONFIG,
+			"Admit a new cache item only if it is used more frequently than the item to be evicted.",
+			CONFIG_VAR_TYPE_BOOL, false, 0
+		},
+		&g_pool_config.memqcache_admission_filter,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"allow_sql_comments", CFGCXT_SESSION, LOAD_BALANCE_CONFIG,
 			"Ignore SQL comments, while judging if load balance or query cache is possible.",
@@ -606,6 +649,16 @@ static struct config_bool ConfigureNamesBool[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"read_your_writes", CFGCXT_RELOAD, LOAD_BALANCE_CONFIG,
+			"Do not load balance reads to standbys not caught up with the session's writes",
+			CONFIG_VAR_TYPE_BOOL, false, 0
+		},
+		&g_pool_config.read_your_writes,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"auto_failback", CFGCXT_RELOAD, FAILOVER_CONFIG,
 			"Enables nodes automatically reattach, when dettached node continue streaming replication.",
@@ -1101,6 +1154,16 @@ static struct config_string ConfigureNamesString[] =
 		NULL, NULL, NULL, NULL
 	},
 
+	{
+		{"memqcache_snapshot_file", CFGCXT_INIT, CACHE_CONFIG,
+			"File to save shared memory query cache at shutdown.",
+			CONFIG_VAR_TYPE_STRING, false, 0
+		},
+		&g_pool_config.memqcache_snapshot_file,
+		"",
+		NULL, NULL, NULL, NULL
+	},
+
 	{
 		{"memqcache_memcached_host", CFGCXT_INIT, CACHE_CONFIG,
 			"Hostname or IP address of memcached.",
@@ -1235,6 +1298,17 @@ static struct config_long ConfigureNamesLong[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"delay_weight_scale", CFGCXT_RELOAD, STREAMING_REPLICATION_CONFIG,
+			"standby delay at which load balance weight is halved.",
+			CONFIG_VAR_TYPE_LONG, false, 0
+		},
+		&g_pool_config.delay_weight_scale,
+		0,
+		0, LONG_MAX,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"relcache_expire", CFGCXT_INIT, CACHE_CONFIG,
 			"Relation cache expiration time in seconds.",
@@ -1639,6 +1713,28 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"min_spare_children", CFGCXT_RELOAD, CONNECTION_POOL_CONFIG,
+			"Minimum number of spare child processes in dynamic process management mode.",
+			CONFIG_VAR_TYPE_INT, false, 0
+		},
+		&g_pool_config.min_spare_children,
+		5,
+		1, INT_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"max_spare_children", CFGCXT_RELOAD, CONNECTION_POOL_CONFIG,
+			"Maximum number of spare child processes in dynamic process management mode.",
+			CONFIG_VAR_TYPE_INT, false, 0
+		},
+		&g_pool_config.max_spare_children,
+		10,
+		1, INT_MAX,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"reserved_connections", CFGCXT_INIT, CONNECTION_POOL_CONFIG,
 			"Number of reserved connections.",
@@ -1727,6 +1823,17 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"prewarm_connections", CFGCXT_RELOAD, CONNECTION_POOL_CONFIG,
+			"Number of frequently used connection pools an idle child process opens in advance.",
+			CONFIG_VAR_TYPE_INT, false, 0
+		},
+		&g_pool_config.prewarm_connections,
+		0,
+		0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"sr_check_period", CFGCXT_RELOAD, STREAMING_REPLICATION_CONFIG,
 			"Time interval in seconds between the streaming replication delay checks.",
@@ -1738,6 +1845,50 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"sr_check_sampling_interval", CFGCXT_RELOAD, STREAMING_REPLICATION_CONFIG,
+			"Time interval in milliseconds between the replication delay samples taken between the checks.",
+			CONFIG_VAR_TYPE_INT, false, 0
+		},
+		&g_pool_config.sr_check_sampling_interval,
+		0,
+		0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"health_check_probe_interval", CFGCXT_RELOAD, HEALTH_CHECK_CONFIG,
+			"Time interval in milliseconds between the probes in multiplexed health check mode.",
+			CONFIG_VAR_TYPE_INT, false, 0
+		},
+		&g_pool_config.health_check_probe_interval,
+		0,
+		0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"health_check_latency_weight_scale", CFGCXT_RELOAD, HEALTH_CHECK_CONFIG,
+			"Health check latency in milliseconds at which the load balance weight is halved.",
+			CONFIG_VAR_TYPE_INT, false, 0
+		},
+		&g_pool_config.health_check_latency_weight_scale,
+		0,
+		0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"follow_master_parallelism", CFGCXT_RELOAD, FAILOVER_CONFIG,
+			"Maximum number of follow master commands executed concurrently.",
+			CONFIG_VAR_TYPE_INT, false, 0
+		},
+		&g_pool_config.follow_master_parallelism,
+		1,
+		1, MAX_NUM_BACKENDS,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"recovery_timeout", CFGCXT_RELOAD, RECOVERY_CONFIG,
 			"Maximum time in seconds to wait for the recovering PostgreSQL node.",
@@ -1859,6 +2010,39 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"heavy_query_time_threshold", CFGCXT_RELOAD, LOAD_BALANCE_CONFIG,
+			"Execution time in milliseconds from which SELECT is regarded as heavy.",
+			CONFIG_VAR_TYPE_INT, false, 0
+		},
+		&g_pool_config.heavy_query_time_threshold,
+		0,
+		0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"heavy_query_rows_threshold", CFGCXT_RELOAD, LOAD_BALANCE_CONFIG,
+			"Number of rows from which SELECT is regarded as heavy.",
+			CONFIG_VAR_TYPE_INT, false, 0
+		},
+		&g_pool_config.heavy_query_rows_threshold,
+		0,
+		0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"shared_relcache_size", CFGCXT_INIT, CACHE_CONFIG,
+			"Number of shared relation cache entry.",
+			CONFIG_VAR_TYPE_INT, false, 0
+		},
+		&g_pool_config.shared_relcache_size,
+		1024,
+		1, INT_MAX / 2048,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"memqcache_memcached_port", CFGCXT_INIT, CACHE_CONFIG,
 			"Port number of Memcached server.",
@@ -1903,6 +2087,17 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"memqcache_compress_threshold", CFGCXT_RELOAD, CACHE_CONFIG,
+			"Minimum SELECT result size in bytes to be compressed in the cache.",
+			CONFIG_VAR_TYPE_INT, false, 0
+		},
+		&g_pool_config.memqcache_compress_threshold,
+		0,
+		0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"memqcache_cache_block_size", CFGCXT_INIT, CACHE_CONFIG,
 			"Cache block size in bytes.",
@@ -2021,6 +2216,28 @@ static struct config_enum ConfigureNamesEnum[] =
 		NULL, NULL, NULL, NULL
 	},
 
+	{
+		{"process_management_mode", CFGCXT_INIT, CONNECTION_POOL_CONFIG,
+			"How to manage the number of child processes.",
+			CONFIG_VAR_TYPE_ENUM, false, 0
+		},
+		(int *) &g_pool_config.process_management_mode,
+		PM_STATIC,
+		process_management_mode_options,
+		NULL, NULL, NULL, NULL
+	},
+
+	{
+		{"health_check_mode", CFGCXT_INIT, HEALTH_CHECK_CONFIG,
+			"Whether to run one health check process per node or one for all nodes.",
+			CONFIG_VAR_TYPE_ENUM, false, 0
+		},
+		(int *) &g_pool_config.health_check_mode,
+		HC_PER_NODE,
+		health_check_mode_options,
+		NULL, NULL, NULL, NULL
+	},
+
 	{
 		{"disable_load_balance_on_write", CFGCXT_RELOAD, LOAD_BALANCE_CONFIG,
 			"Load balance behavior when write query is received.",
@@ -2043,6 +2260,39 @@ static struct config_enum ConfigureNamesEnum[] =
 		NULL, NULL, NULL, NULL
 	},
 
+	{
+		{"huge_pages", CFGCXT_INIT, GENERAL_CONFIG,
+			"Use huge pages for large shared memory areas.",
+			CONFIG_VAR_TYPE_ENUM, false, 0
+		},
+		(int *) &g_pool_config.huge_pages,
+		HUGE_PAGES_TRY,
+		huge_pages_options,
+		NULL, NULL, NULL, NULL
+	},
+
+	{
+		{"shared_memory_numa_policy", CFGCXT_INIT, GENERAL_CONFIG,
+			"NUMA memory policy of large shared memory areas.",
+			CONFIG_VAR_TYPE_ENUM, false, 0
+		},
+		(int *) &g_pool_config.shared_memory_numa_policy,
+		SHMEM_NUMA_DEFAULT,
+		shared_memory_numa_policy_options,
+		NULL, NULL, NULL, NULL
+	},
+
+	{
+		{"load_balance_policy", CFGCXT_RELOAD, LOAD_BALANCE_CONFIG,
+			"How to select load balancing node.",
+			CONFIG_VAR_TYPE_ENUM, false, 0
+		},
+		(int *) &g_pool_config.load_balance_policy,
+		LBPOLICY_WEIGHT,
+		load_balance_policy_options,
+		NULL, NULL, NULL, NULL
+	},
+
 	{
 		{"check_temp_table", CFGCXT_RELOAD, GENERAL_CONFIG,
 			"Enables temporary table check.",
@@ -3907,6 +4157,11 @@ BackendFlagsAssignFunc(ConfigContext context, char *newval, int index, int eleve
 			flag |= POOL_ALWAYS_MASTER;
 		}
 
+		else if ((!strcmp(flags[i], "ANALYTICS")))
+		{
+			flag |= POOL_ANALYTICS;
+		}
+
 		else
 		{
 			ereport(elevel,
@@ -4464,6 +4719,15 @@ config_post_processor(ConfigContext context, int elevel)
 	}
 
 
+	if (pool_config->process_management_mode == PM_DYNAMIC &&
+		pool_config->min_spare_children > pool_config->max_spare_children)
+	{
+		ereport(elevel,
+				(errmsg("invalid configuration, min_spare_children (%d) must not be greater than max_spare_children (%d)",
+						pool_config->min_spare_children, pool_config->max_spare_children)));
+		return false;
+	}
+
 	if (strcmp(pool_config->recovery_1st_stage_command, "") ||
 		strcmp(pool_config->recovery_2nd_stage_command, ""))
 	{
@@ -144,6 +144,7 @@ pool_start_query(POOL_QUERY_CONTEXT * query_context, char *query, int len, Node
 		query_context->original_query = pstrdup(query);
 		query_context->rewritten_query = NULL;
 		query_context->parse_tree = node;
+		query_context->select_analysis = NULL;
 		query_context->virtual_master_node_id = my_master_node_id;
 		query_context->load_balance_node_id = my_master_node_id;
 		query_context->is_cache_safe = false;
@@ -152,6 +153,7 @@ pool_start_query(POOL_QUERY_CONTEXT * query_context, char *query, int len, Node
 			query_context->temp_cache = pool_create_temp_query_cache(query);
 		pool_set_query_in_progress();
 		query_context->skip_cache_commit = false;
+		gettimeofday(&query_context->start_time, NULL);
 		session_context->query_context = query_context;
 		MemoryContextSwitchTo(old_context);
 	}
@@ -532,6 +534,16 @@ pool_where_to_send(POOL_QUERY_CONTEXT * query_context, char *query, Node *node)
 					 * Load balance if possible
 					 */
 
+					/*
+					 * Collect all the facts checked below by a single walk
+					 * over the parse tree.
+					 */
+					pool_analyze_select_stmt(node,
+											 POOL_SELECT_SYSTEM_CATALOG |
+											 (pool_config->check_temp_table ? POOL_SELECT_TEMP_TABLE : 0) |
+											 (pool_config->check_unlogged_table ? POOL_SELECT_UNLOGGED_TABLE : 0) |
+											 POOL_SELECT_FUNCTION_CALL);
+
 					/*
 					 * If replication delay is too much, we prefer to send to
 					 * the primary.
@@ -547,6 +559,22 @@ pool_where_to_send(POOL_QUERY_CONTEXT * query_context, char *query, Node *node)
 						pool_set_node_to_be_sent(query_context, PRIMARY_NODE_ID);
 					}
 
+					/*
+					 * If the load balance node has not replayed the writes of
+					 * this session yet, send to the primary to avoid stale
+					 * reads. With statement level load balancing such a node
+					 * is never selected.
+					 */
+					else if (!pool_config->statement_level_load_balance &&
+							 !node_replayed_session_writes(session_context->load_balance_node_id))
+					{
+						ereport(DEBUG1,
+								(errmsg("could not load balance because the load balance node has not replayed writes of the session"),
+								 errdetail("destination = %d for query= \"%s\"", dest, query)));
+
+						pool_set_node_to_be_sent(query_context, PRIMARY_NODE_ID);
+					}
+
 					/*
 					 * If system catalog is used in the SELECT, we prefer to
 					 * send to the primary. Example: SELECT * FROM pg_class
@@ -613,7 +641,16 @@ pool_where_to_send(POOL_QUERY_CONTEXT * query_context, char *query, Node *node)
 					}
 					else
 					{
-						if (pool_config->statement_level_load_balance)
+						/*
+						 * Route heavy queries to ANALYTICS nodes and the
+						 * others to the rest.
+						 */
+						if (pool_config->statement_level_load_balance &&
+							(pool_config->heavy_query_time_threshold > 0 ||
+							 pool_config->heavy_query_rows_threshold > 0))
+							session_context->load_balance_node_id =
+								select_load_balancing_node_by_cost(stat_is_heavy_query(stat_query_fingerprint(query)));
+						else if (pool_config->statement_level_load_balance)
 							session_context->load_balance_node_id = select_load_balancing_node();
 
 						session_context->query_context->load_balance_node_id = session_context->load_balance_node_id;
@@ -754,6 +791,7 @@ pool_send_and_wait(POOL_QUERY_CONTEXT * query_context,
 	int			i;
 	int			len;
 	char	   *string;
+	struct timeval sent_time[MAX_NUM_BACKENDS];
 
 	session_context = pool_get_session_context(false);
 	frontend = session_context->frontend;
@@ -833,6 +871,8 @@ pool_send_and_wait(POOL_QUERY_CONTEXT * query_context,
 
 		per_node_statement_log(backend, i, string);
 		stat_count_up(i, query_context->parse_tree);
+		gettimeofday(&sent_time[i], NULL);
+		stat_query_sent(i);
 		send_simplequery_message(CONNECTION(backend, i), len, string, MAJOR(backend));
 	}
 
@@ -871,6 +911,7 @@ pool_send_and_wait(POOL_QUERY_CONTEXT * query_context,
 												   MAJOR(backend),
 												   MASTER_CONNECTION(backend)->pid,
 												   MASTER_CONNECTION(backend)->key);
+		stat_query_responded(i, &sent_time[i]);
 
 		/*
 		 * Check if some error detected.  If so, emit log. This is useful when
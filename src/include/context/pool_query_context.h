@@ -90,6 +90,12 @@ typedef struct
 									 * extended query, do not commit cache if
 									 * this flag is true. */
 
+	struct SelectContext *select_analysis;	/* facts collected from
+											 * parse_tree by
+											 * pool_analyze_select_stmt() */
+
+	struct timeval start_time;	/* time when the query was sent to backend */
+
 	MemoryContext memory_context;	/* memory context for query context */
 }			POOL_QUERY_CONTEXT;
 
@@ -278,6 +278,13 @@ typedef struct
 	 */
 	List	   *temp_tables;
 
+	/*
+	 * WAL location of the primary after the last write transaction of this
+	 * session. Used by read_your_writes.
+	 */
+	bool		write_lsn_pending;	/* wrote but write_lsn is not updated yet */
+	uint64		write_lsn;
+
 #ifdef NOT_USED
 	/* Preferred "master" node id. Only used for SimpleForwardToFrontend. */
 	int			preferred_master_node_id;
@@ -92,11 +92,19 @@ typedef struct
 	bool		quarantine;		/* true if node is CON_DOWN because of
 								 * quarantine */
 	uint64		standby_delay;	/* The replication delay against the primary */
+	uint64		replay_lsn;		/* Last replayed WAL location of standby,
+								 * current WAL location of primary */
 	SERVER_ROLE role;			/* Role of server. used by pcp_node_info and
 								 * failover() to keep track of quarantined
 								 * primary node */
 	char		replication_state [NAMEDATALEN];	/* "state" from pg_stat_replication */
 	char		replication_sync_state [NAMEDATALEN];	/* "sync_state" from pg_stat_replication */
+	uint64		health_check_latency;	/* 99th percentile of the recent health
+										 * check latency in microseconds. Only
+										 * used by pcp_node_info */
+	uint64		health_check_jitter;	/* jitter of the recent health check
+										 * latency in microseconds. Only used
+										 * by pcp_node_info */
 }			BackendInfo;
 
 typedef struct
@@ -155,6 +163,11 @@ typedef struct
 									 * soon as current session ends. Typical
 									 * case this flag being set is failback a
 									 * node in streaming replication mode. */
+	char		wait_for_connect;	/* If non 0, the child is waiting for a
+									 * new client connection */
+	char		exit_if_idle;	/* If non 0, exit this child process when it
+								 * is idle. Set by pgpool main to retire
+								 * spare children. */
 }			ProcessInfo;
 
 /*
@@ -192,6 +205,7 @@ typedef struct
 	char		select[POOLCONFIG_MAXWEIGHTLEN + 1];
 	char		load_balance_node[POOLCONFIG_MAXWEIGHTLEN + 1];
 	char		delay[POOLCONFIG_MAXWEIGHTLEN + 1];
+	char		delay_peak[POOLCONFIG_MAXWEIGHTLEN + 1];
 	char		rep_state[POOLCONFIG_MAXWEIGHTLEN + 1];
 	char		rep_sync_state[POOLCONFIG_MAXWEIGHTLEN + 1];
 	char		last_status_change[POOLCONFIG_MAXDATELEN];
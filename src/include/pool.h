@@ -122,6 +122,9 @@ typedef enum
 /* Cancel packet proto major */
 #define PROTO_CANCEL	80877102
 
+/* Major/minor codes to negotiate SSL prior to startup packet */
+#define NEGOTIATE_SSL_CODE ( 1234<<16 | 5679 )
+
 /*
  * In protocol 3.0 and later, the startup packet length is not fixed, but
  * we set an arbitrary limit on it anyway.	This is just to prevent simple
@@ -456,13 +459,15 @@ typedef enum
 #define NO_LOAD_BALANCE "/*NO LOAD BALANCE*/"
 #define NO_LOAD_BALANCE_COMMENT_SZ (sizeof(NO_LOAD_BALANCE)-1)
 
-#define MAX_NUM_SEMAPHORES		6
+#define MAX_NUM_SEMAPHORES		8
 #define CONN_COUNTER_SEM		0
 #define REQUEST_INFO_SEM		1
 #define SHM_CACHE_SEM			2
 #define QUERY_CACHE_STATS_SEM	3
 #define PCP_REQUEST_SEM			4
 #define ACCEPT_FD_SEM			5
+#define SHARED_RELCACHE_SEM		6
+#define STARTUP_PACKET_STATS_SEM	7
 #define MAX_REQUEST_QUEUE_SIZE	10
 
 #define MAX_SEC_WAIT_FOR_CLUSTER_TRANSATION 10	/* time in seconds to keep
@@ -526,6 +531,108 @@ typedef struct
 								 * progress */
 }			POOL_REQUEST_INFO;
 
+/*
+ * Replication delay samples of a backend taken by the worker process.
+ * Placed on shared memory area.
+ */
+#define REPLICATION_LAG_HISTORY_SIZE 32
+
+typedef struct
+{
+	struct timeval sample_time; /* when the sample was taken */
+	uint64		delay;			/* replication delay in bytes */
+}			ReplicationLagSample;
+
+typedef struct
+{
+	int			next;			/* slot to be used by the next sample */
+	ReplicationLagSample samples[REPLICATION_LAG_HISTORY_SIZE];
+}			ReplicationLagHistory;
+
+/*
+ * Startup packets frequently sent by clients. Idle child processes use them
+ * to open backend connections in advance (prewarm_connections). Placed on
+ * shared memory area and indexed by the hash value of the startup packet.
+ */
+#define STARTUP_PACKET_STATS_SIZE 64
+#define STARTUP_PACKET_STATS_PACKET_LEN 1024
+#define STARTUP_PACKET_STATS_NAME_LEN 128
+
+typedef struct
+{
+	uint32		hash;			/* hash value of the packet. 0 if unused */
+	int			count;			/* how often the packet was used recently */
+	int			auth_kind;		/* authentication method of the backend */
+	int			len;			/* length of the startup packet */
+	int			application_name;	/* offset of application name in the
+									 * packet. -1 if not specified */
+	char		user[STARTUP_PACKET_STATS_NAME_LEN];
+	char		database[STARTUP_PACKET_STATS_NAME_LEN];
+	char		packet[STARTUP_PACKET_STATS_PACKET_LEN];
+}			StartupPacketStat;
+
+/*
+ * Number of child processes allowed to prewarm connections per second
+ * right after they are started. Children started at once, e.g. after
+ * failover, would otherwise authenticate to the backends all at the same
+ * time.
+ */
+#define PREWARM_STARTUP_PER_SECOND 4
+
+typedef struct
+{
+	time_t		second;			/* when the children below started prewarming */
+	int			count;			/* # of children started prewarming in the
+								 * second */
+}			PrewarmStartupLimit;
+
+/*
+ * Health check statistics of a backend. The latency of the recent probes is
+ * kept in a ring buffer so that percentiles and jitter can be computed. A
+ * failed probe is recorded with negative latency. Placed on shared memory
+ * area and only updated by the health check process.
+ */
+#define HEALTH_CHECK_STATS_SAMPLES 64
+
+typedef struct
+{
+	time_t		time;			/* when the probe finished */
+	int64		latency;		/* connect and authentication time of the
+								 * probe in microseconds. -1 if failed */
+}			HealthCheckSample;
+
+typedef struct
+{
+	uint64		probes;			/* # of successful probes */
+	uint64		failures;		/* # of failed probes */
+	int			next;			/* next slot of samples to be used */
+	int64		p90;			/* 90th percentile latency of the samples in
+								 * microseconds, updated at each probe. 0 if
+								 * there's no successful sample */
+	HealthCheckSample samples[HEALTH_CHECK_STATS_SAMPLES];
+}			HealthCheckStats;
+
+/*
+ * Summary of the health check statistics computed from HealthCheckStats.
+ * Latencies are in microseconds.
+ */
+typedef struct
+{
+	uint64		probes;
+	uint64		failures;
+	int			nsamples;		/* # of successful probes in the ring */
+	time_t		last_time;		/* when the last probe finished. 0 if none */
+	int64		last;			/* latency of the last probe. -1 if failed */
+	int64		min;
+	int64		max;
+	int64		avg;
+	int64		p50;
+	int64		p90;
+	int64		p99;
+	int64		jitter;			/* mean difference of the latency between
+								 * consecutive successful probes */
+}			HealthCheckStatsSummary;
+
 /* description of row. corresponding to RowDescription message */
 typedef struct
 {
@@ -629,6 +736,12 @@ extern ProcessInfo * process_info;	/* shmem process information table */
 extern ConnectionInfo * con_info;	/* shmem connection info table */
 extern POOL_REQUEST_INFO * Req_info;
 extern volatile sig_atomic_t *InRecovery;
+extern ReplicationLagHistory * replication_lag_history;	/* per node */
+extern HealthCheckStats * health_check_stats;	/* per node */
+extern StartupPacketStat * startup_packet_stats;	/* frequently used startup
+													 * packets */
+extern PrewarmStartupLimit * prewarm_startup_limit;	/* rate limit of
+													 * prewarming at start up */
 extern char remote_ps_data[];	/* used for set_ps_display */
 extern volatile sig_atomic_t got_sighup;
 extern volatile sig_atomic_t exit_request;
@@ -656,12 +769,16 @@ extern char *get_hba_file_name(void);
 extern void do_child(int *fds);
 extern void pcp_main(int unix_fd, int inet_fd);
 extern int	select_load_balancing_node(void);
+extern int	select_load_balancing_node_by_cost(bool heavy);
+extern bool node_replayed_session_writes(int node_id);
 extern int	pool_init_cp(void);
 extern POOL_STATUS pool_process_query(POOL_CONNECTION * frontend,
 									  POOL_CONNECTION_POOL * backend,
 									  int reset_request);
 
 extern void connection_do_auth(POOL_CONNECTION_POOL_SLOT * cp, char *password);
+extern int	connection_start_auth(POOL_CONNECTION_POOL_SLOT * cp, char *password);
+extern void connection_finish_auth(POOL_CONNECTION_POOL_SLOT * cp, int auth_kind);
 extern int	pool_do_auth(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend);
 extern int	pool_do_reauth(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * cp);
 extern void authenticate_frontend(POOL_CONNECTION * frontend);
@@ -671,6 +788,8 @@ extern bool is_backend_cache_empty(POOL_CONNECTION_POOL * backend);
 /* SSL functionality */
 extern void pool_ssl_negotiate_serverclient(POOL_CONNECTION * cp);
 extern void pool_ssl_negotiate_clientserver(POOL_CONNECTION * cp);
+extern bool pool_ssl_request_clientserver(POOL_CONNECTION * cp);
+extern void pool_ssl_complete_clientserver(POOL_CONNECTION * cp);
 extern void pool_ssl_close(POOL_CONNECTION * cp);
 extern int	pool_ssl_read(POOL_CONNECTION * cp, void *buf, int size);
 extern int	pool_ssl_write(POOL_CONNECTION * cp, const void *buf, int size);
@@ -755,6 +874,7 @@ extern POOL_CONNECTION_POOL_SLOT * make_persistent_db_connection(
 																 int db_node_id, char *hostname, int port, char *dbname, char *user, char *password, bool retry);
 extern POOL_CONNECTION_POOL_SLOT * make_persistent_db_connection_noerror(
 																		 int db_node_id, char *hostname, int port, char *dbname, char *user, char *password, bool retry);
+extern void make_persistent_db_connections_noerror(POOL_CONNECTION_POOL_SLOT * *slots, char *dbname, char *user, char *password);
 extern void discard_persistent_db_connection(POOL_CONNECTION_POOL_SLOT * cp);
 
 /* define pool_system.c */
@@ -820,6 +940,8 @@ extern char *get_pool_key(void);
 
 /* pool_worker_child.c */
 extern void do_worker_child(void);
+extern unsigned long long int text_to_lsn(char *text);
+extern uint64 get_replication_lag_peak(int node_id);
 extern int	get_query_result(POOL_CONNECTION_POOL_SLOT * *slots, int backend_id, char *query, POOL_SELECT_RESULT * *res);
 
 /* md5.c */
@@ -837,7 +959,14 @@ extern int	connect_inet_domain_socket(int slot, bool retry);
 extern int	connect_unix_domain_socket(int slot, bool retry);
 extern int	connect_inet_domain_socket_by_port(char *host, int port, bool retry);
 extern int	connect_unix_domain_socket_by_port(int port, char *socket_dir, bool retry);
+extern void connect_inet_domain_sockets_in_parallel(int *fds);
+
+/* fds[i] set by connect_inet_domain_sockets_in_parallel() on a failure */
+#define POOL_CONNECT_FAILED	(-2)
 extern int	pool_pool_index(void);
+extern void pool_record_startup_packet(POOL_CONNECTION_POOL * backend);
+extern int	pool_get_frequent_startup_packets(StartupPacketStat * stats, int max);
+extern bool pool_prewarm_startup_allowed(void);
 
 /* utils/statistics.c */
 size_t		stat_shared_memory_size(void);
@@ -845,6 +974,14 @@ void		stat_set_stat_area(void *address);
 void		stat_init_stat_area(void);
 void		stat_count_up(int backend_node_id, Node *parsetree);
 uint64		stat_get_select_count(int backend_node_id);
+void		stat_query_sent(int backend_node_id);
+void		stat_query_responded(int backend_node_id, struct timeval *sent_time);
+void		stat_reset_outstanding_queries(void);
+int			stat_get_outstanding_queries(int backend_node_id);
+double		stat_get_query_latency(int backend_node_id);
+uint64		stat_query_fingerprint(const char *query);
+void		stat_record_query_cost(uint64 fingerprint, double time, uint64 rows);
+bool		stat_is_heavy_query(uint64 fingerprint);
 
 extern int	PgpoolMain(bool discard_status, bool clear_memcache_oidmaps);
 
@@ -862,6 +999,8 @@ extern int	pool_frontend_exists(void);
 extern pid_t pool_waitpid(int *status);
 extern int	write_status_file(void);
 extern void do_health_check_child(int *node_id);
+extern void do_multiplexed_health_check_child(void *params);
+extern void health_check_stats_summary(int node, HealthCheckStatsSummary * summary);
 extern POOL_NODE_STATUS * verify_backend_node_status(POOL_CONNECTION_POOL_SLOT * *slots);
 extern POOL_NODE_STATUS * pool_get_node_status(void);
 extern void pool_set_backend_status_changed_time(int backend_id);
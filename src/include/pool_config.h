@@ -99,6 +99,39 @@ typedef enum RELQTARGET_OPTION
 	RELQTARGET_LOAD_BALANCE_NODE
 }			RELQTARGET_OPTION;
 
+typedef enum LBPOLICY_OPTION
+{
+	LBPOLICY_WEIGHT = 1,
+	LBPOLICY_LEAST_LOADED,
+	LBPOLICY_POWER_OF_TWO
+}			LBPOLICY_OPTION;
+
+typedef enum PROCESS_MANAGEMENT_MODE
+{
+	PM_STATIC = 1,
+	PM_DYNAMIC
+}			PROCESS_MANAGEMENT_MODE;
+
+typedef enum HEALTH_CHECK_MODE
+{
+	HC_PER_NODE = 1,
+	HC_MULTIPLEXED
+}			HEALTH_CHECK_MODE;
+
+typedef enum HUGE_PAGES_OPTION
+{
+	HUGE_PAGES_OFF = 1,
+	HUGE_PAGES_ON,
+	HUGE_PAGES_TRY
+}			HUGE_PAGES_OPTION;
+
+typedef enum SHMEM_NUMA_POLICY
+{
+	SHMEM_NUMA_DEFAULT = 1,
+	SHMEM_NUMA_INTERLEAVE,
+	SHMEM_NUMA_LOCAL
+}			SHMEM_NUMA_POLICY;
+
 typedef enum CHECK_TEMP_TABLE_OPTION
 {
 	CHECK_TEMP_CATALOG = 1,
@@ -113,6 +146,7 @@ typedef enum CHECK_TEMP_TABLE_OPTION
  */
 #define POOL_FAILOVER	(1 << 0)	/* allow or disallow failover */
 #define POOL_ALWAYS_MASTER	(1 << 1)	/* this backend is always master */
+#define POOL_ANALYTICS	(1 << 2)	/* heavy read queries go to this backend */
 #define POOL_DISALLOW_TO_FAILOVER(x) ((unsigned short)(x) & POOL_FAILOVER)
 #define POOL_ALLOW_TO_FAILOVER(x) (!(POOL_DISALLOW_TO_FAILOVER(x)))
 
@@ -174,6 +208,12 @@ typedef struct
 	char	   *wd_ipc_socket_dir;	/* watchdog command IPC socket directory */
 	char	   *pcp_socket_dir; /* PCP socket directory */
 	int			num_init_children;	/* # of children initially pre-forked */
+	PROCESS_MANAGEMENT_MODE process_management_mode;	/* how to manage the
+														 * number of children */
+	int			min_spare_children; /* minimum # of idle children in dynamic
+									 * mode */
+	int			max_spare_children; /* maximum # of idle children in dynamic
+									 * mode */
 	int			listen_backlog_multiplier;	/* determines the size of the
 											 * connection queue */
 	int			reserved_connections;	/* # of reserved connections */
@@ -197,6 +237,8 @@ typedef struct
 	int			authentication_timeout; /* maximum time in seconds to complete
 										 * client authentication */
 	int			max_pool;		/* max # of connection pool per child */
+	int			prewarm_connections;	/* # of connection pools an idle
+										 * child opens in advance */
 	char	   *logdir;			/* logging directory */
 	char	   *log_destination_str;	/* log destination: stderr and/or
 										 * syslog */
@@ -259,6 +301,10 @@ typedef struct
 									 * that health_check_period required to be
 									 * greater than 0 to enable the
 									 * functionality. */
+	int64		delay_weight_scale;	/* If greater than 0, the load balance
+									 * weight of a standby is multiplied by
+									 * delay_weight_scale / (delay_weight_scale
+									 * + standby delay). The unit is in bytes. */
 	LogStandbyDelayModes log_standby_delay; /* how to log standby lag */
 	bool		connection_cache;	/* cache connection pool? */
 	int			health_check_timeout;	/* health check timeout */
@@ -274,7 +320,19 @@ typedef struct
 									 * connecting to backend */
 	HealthCheckParams *health_check_params; /* per node health check
 											 * parameters */
+	HEALTH_CHECK_MODE health_check_mode;	/* one health check process per
+											 * node or one for all nodes */
+	int			health_check_probe_interval;	/* interval between probes in
+												 * milliseconds in multiplexed
+												 * health check mode */
+	int			health_check_latency_weight_scale;	/* If greater than 0, the
+														 * load balance weight is
+														 * scaled by the health
+														 * check latency in
+														 * milliseconds */
 	int			sr_check_period;	/* streaming replication check period */
+	int			sr_check_sampling_interval;	/* replication delay sampling
+											 * interval in milliseconds */
 	char	   *sr_check_user;	/* PostgreSQL user name for streaming
 								 * replication check */
 	char	   *sr_check_password;	/* password for sr_check_user */
@@ -283,6 +341,8 @@ typedef struct
 	char	   *failover_command;	/* execute command when failover happens */
 	char	   *follow_master_command;	/* execute command when failover is
 										 * ended */
+	int			follow_master_parallelism;	/* max # of follow master commands
+											 * executed concurrently */
 	char	   *failback_command;	/* execute command when failback happens */
 
 	bool		failover_on_backend_error; /* If true, trigger fail over when
@@ -360,8 +420,13 @@ typedef struct
 	int			relcache_size;	/* number of relation cache life entry */
 	CHECK_TEMP_TABLE_OPTION		check_temp_table;	/* how to check temporary table */
 	bool		check_unlogged_table;	/* enable unlogged table check */
-	bool		enable_shared_relcache;	/* If true, relation cache stored in memory cache */
+	bool		enable_shared_relcache;	/* If true, relation cache is shared among
+										 * child processes */
+	int			shared_relcache_size;	/* number of shared relation cache entry */
 	RELQTARGET_OPTION	relcache_query_target;	/* target node to send relcache queries */
+	HUGE_PAGES_OPTION huge_pages;	/* use huge pages for shared memory */
+	SHMEM_NUMA_POLICY shared_memory_numa_policy;	/* NUMA memory policy of
+													 * shared memory */
 
 	/*
 	 * followings are for regex support and do not exist in the configuration
@@ -401,11 +466,21 @@ typedef struct
 													 * corresponding */
 	/* DDL/DML/DCL(and memqcache_expire).  If false, it is only triggered */
 	/* by memqcache_expire.  True by default. */
+	bool		memqcache_admission_filter;	/* If true, a new cache item
+												 * which requires eviction
+												 * is admitted only when it
+												 * is accessed more frequently
+												 * than the victim. */
 	int			memqcache_maxcache; /* Maximum SELECT result size in bytes. */
+	int			memqcache_compress_threshold;	/* SELECT results larger than
+												 * this are compressed. 0
+												 * disables compression. */
 	int			memqcache_cache_block_size; /* Cache block size in bytes. 8192
 											 * by default */
 	char	   *memqcache_oiddir;	/* Temporary work directory to record
 									 * table oids */
+	char	   *memqcache_snapshot_file;	/* File to save shmem query cache
+											 * at shutdown */
 	char	  **white_memqcache_table_list; /* list of tables to memqcache */
 	char	  **black_memqcache_table_list; /* list of tables not to memqcache */
 
@@ -465,6 +540,15 @@ typedef struct
 												 * until the session ends. */
 
 	bool		statement_level_load_balance; /* if on, select load balancing node per statement */
+	bool		read_your_writes;	/* if on, do not send reads to standbys
+									 * which have not replayed the last write
+									 * of the session */
+	LBPOLICY_OPTION load_balance_policy;	/* how to select load balancing
+											 * node */
+	int			heavy_query_time_threshold;	/* SELECT taking longer than this
+											 * in milliseconds is heavy */
+	int			heavy_query_rows_threshold;	/* SELECT returning more rows than
+											 * this is heavy */
 
 	/*
 	 * add for watchdog
@@ -104,8 +104,69 @@ typedef struct
 	unsigned int total_length;	/* total length in bytes including myself */
 	time_t		timestamp;		/* cache creation time */
 	int			expire;			/* cache expire	*/
+	int			num_generations;	/* number of table generations following
+									 * the header */
+	unsigned int num_hits;		/* number of cache hits */
+	unsigned int raw_length;	/* length of the data before compression. 0
+								 * if the data is not compressed */
 }			POOL_CACHE_ITEM_HEADER;
 
+/*
+ * Table generation recorded in a cache item on shmem. Cache item header
+ * is followed by num_generations of these, then the cached data.
+ */
+typedef struct
+{
+	uint32		slot;			/* index in the table generation array */
+	uint32		generation;		/* generation when the item was cached */
+}			POOL_CACHE_TABLE_GENERATION;
+
+/*
+ * Number of slots in the table generation array on shmem. Must be power
+ * of 2.
+ */
+#define POOL_TABLE_GENERATION_SLOTS 65536
+
+/*
+ * Offset of the cached data from the beginning of cache item header
+ */
+#define POOL_CACHE_ITEM_DATA_OFFSET(cih) (sizeof(POOL_CACHE_ITEM_HEADER) + \
+	(cih)->num_generations * sizeof(POOL_CACHE_TABLE_GENERATION))
+
+/*
+ * Frequency sketch used by the cache admission filter. The sketch is a
+ * count-min sketch having POOL_FREQUENCY_SKETCH_DEPTH rows of 4 bit
+ * saturating counters (stored in bytes). All counters are halved when
+ * the number of recorded accesses reaches POOL_FREQUENCY_SKETCH_SAMPLE
+ * times the width so that old popularity fades away.
+ */
+#define POOL_FREQUENCY_SKETCH_DEPTH 4
+#define POOL_FREQUENCY_SKETCH_MAX_COUNT 15
+#define POOL_FREQUENCY_SKETCH_SAMPLE 10
+
+typedef struct
+{
+	uint32		width;			/* number of counters in a row. power of 2 */
+	uint32		num_accesses;	/* number of accesses since last aging */
+	unsigned char counters[1];	/* depth * width counters follow */
+}			POOL_FREQUENCY_SKETCH;
+
+/*
+ * Per cache entry statistics for SHOW POOL_CACHE_ENTRIES
+ */
+typedef struct
+{
+	POOL_CACHEID cacheid;		/* block id and item id */
+	char		query_hash[POOL_MD5_HASHKEYLEN + 1];	/* md5 hashed query */
+	unsigned int size;			/* total length in bytes */
+	unsigned int raw_size;		/* length of the data before compression. 0
+								 * if the data is not compressed */
+	unsigned int num_hits;		/* number of cache hits */
+	int			frequency;		/* estimated access frequency */
+	time_t		timestamp;		/* cache creation time */
+	int			expire;			/* cache expire	*/
+}			POOL_CACHE_ENTRY_STATS;
+
 typedef struct
 {
 	POOL_CACHE_ITEM_HEADER header;	/* cache item header */
@@ -239,7 +300,7 @@ extern POOL_STATUS pool_fetch_from_memory_cache(POOL_CONNECTION * frontend,
 												char *contents, bool *foundp);
 
 extern int pool_fetch_cache(POOL_CONNECTION_POOL * backend, const char *query, char **buf, size_t *len);
-extern int pool_catalog_commit_cache(POOL_CONNECTION_POOL * backend, char *query, char *data, size_t datalen);
+extern char *pool_get_bind_cache_key(const char *query, const char *params, int len);
 
 extern bool pool_is_likely_select(char *query);
 extern bool pool_is_table_in_black_list(const char *table_name);
@@ -256,7 +317,16 @@ extern int	pool_init_memory_cache(size_t size);
 extern void pool_clear_memory_cache(void);
 extern size_t pool_shared_memory_fsmm_size(void);
 extern int	pool_init_fsmm(size_t size);
+extern size_t pool_shared_memory_table_generation_size(void);
+extern int	pool_init_table_generation(size_t size);
+extern size_t pool_shared_memory_frequency_sketch_size(void);
+extern int	pool_init_frequency_sketch(size_t size);
 extern void pool_allocate_fsmm_clock_hand(void);
+extern void pool_save_memqcache_snapshot(void);
+extern bool pool_prepare_memqcache_snapshot(bool discard);
+extern void pool_load_memqcache_snapshot(void);
+extern bool pool_is_memqcache_loading(void);
+extern void pool_abort_memqcache_loading(void);
 
 extern POOL_QUERY_CACHE_ARRAY * pool_create_query_cache_array(void);
 extern void pool_discard_query_cache_array(POOL_QUERY_CACHE_ARRAY * cache_array);
@@ -273,6 +343,7 @@ extern long long int pool_tmp_stats_count_up_num_selects(void);
 extern long long int pool_tmp_stats_get_num_selects(void);
 extern void pool_tmp_stats_reset_num_selects(void);
 extern POOL_SHMEM_STATS * pool_get_shmem_storage_stats(void);
+extern POOL_CACHE_ENTRY_STATS * pool_get_shmem_cache_entries(int *nrows);
 
 extern POOL_TEMP_QUERY_CACHE * pool_get_current_cache(void);
 extern POOL_TEMP_QUERY_CACHE * pool_get_current_cache(void);
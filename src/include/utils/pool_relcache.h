@@ -36,14 +36,31 @@
 
 typedef void *(*func_ptr) ();
 
+/*
+ * Database name shared by cache entries. Entries of the same database
+ * point to the same string, so that database names can be compared by
+ * address.
+ */
+typedef struct PoolRelCacheDbName
+{
+	struct PoolRelCacheDbName *next;	/* next database name */
+	char		name[1];		/* database name, variable length */
+}			PoolRelCacheDbName;
+
 typedef struct
 {
-	char		dbname[MAX_ITEM_LENGTH];	/* database name */
-	char		relname[MAX_ITEM_LENGTH];	/* table name */
+	char	   *dbname;			/* database name (interned) */
+	char	   *relname;		/* table name, NULL if the entry is free */
+	uint32		hashval;		/* hash value of dbname, relname and session */
+	int			next;			/* next entry in the hash chain or the free
+								 * list, -1 if none */
+	int			lru_prev;		/* more recently used entry, -1 if none */
+	int			lru_next;		/* less recently used entry, -1 if none */
 	void	   *data;			/* user data */
-	int			refcnt;			/* reference count */
 	int			session_id;		/* LocalSessionId */
 	time_t		expire;			/* cache expiration absolute time in seconds */
+	uint32		generation;		/* shared relation cache generation when the
+								 * data was obtained */
 }			PoolRelCache;
 
 typedef struct
@@ -68,14 +85,71 @@ typedef struct
 	bool		no_cache_if_zero;	/* if register func returns 0, do not
 									 * cache the data */
 	PoolRelCache *cache;		/* cache data */
+	int			nbuckets;		/* number of hash buckets, power of 2 */
+	int		   *buckets;		/* first entry of each hash chain, -1 if
+								 * empty */
+	int			free_list;		/* first free entry, -1 if none */
+	int			lru_head;		/* most recently used entry, -1 if none */
+	int			lru_tail;		/* least recently used entry, -1 if none */
+	PoolRelCacheDbName *dbnames;	/* interned database names */
 }			POOL_RELCACHE;
 
+/* ------------------------
+ * Shared relation cache structure
+ *-------------------------
+ */
+#define SHARED_RELCACHE_KEYLEN	32	/* md5 of database name and query */
+#define SHARED_RELCACHE_DATALEN	1024	/* max size of serialized query result */
+#define SHARED_RELCACHE_GENERATION_SLOTS	256	/* number of per database
+												 * generations, power of 2 */
+
+typedef struct
+{
+	char		key[SHARED_RELCACHE_KEYLEN + 1];	/* cache key, empty if the
+													 * entry is free */
+	char		dbname[NAMEDATALEN];	/* database name */
+	char		relname[NAMEDATALEN];	/* normalized table name */
+	int			next;			/* next entry in the hash chain or the free
+								 * list, -1 if none */
+	time_t		expire;			/* cache expiration absolute time in seconds */
+	int			data_len;		/* length of data */
+	char		data[SHARED_RELCACHE_DATALEN];	/* serialized query result */
+}			PoolSharedRelCacheEntry;
+
+typedef struct
+{
+	int			num_entries;	/* number of entries */
+	int			nbuckets;		/* number of hash buckets, power of 2 */
+	int			free_list;		/* first free entry, -1 if none */
+	int			clock_hand;		/* next entry to be evicted */
+	uint32		generations[SHARED_RELCACHE_GENERATION_SLOTS];	/* incremented at
+																 * each invalidation
+																 * of the databases
+																 * hashed to the slot
+																 * so that local
+																 * caches of all the
+																 * processes can
+																 * notice it */
+	uint32		function_generation;	/* incremented when functions may
+										 * have been changed */
+}			PoolSharedRelCacheHeader;
+
 extern POOL_RELCACHE * pool_create_relcache(int cachesize, char *sql,
 											func_ptr register_func, func_ptr unregister_func,
 											bool issessionlocal);
 extern void pool_discard_relcache(POOL_RELCACHE * relcache);
 extern void *pool_search_relcache(POOL_RELCACHE * relcache, POOL_CONNECTION_POOL * backend, char *table);
+extern int	pool_relcache_query_node(POOL_CONNECTION_POOL * backend, char **dbname);
+extern bool pool_relcache_contains(POOL_RELCACHE * relcache, POOL_CONNECTION_POOL * backend, char *table);
+extern void pool_add_relcache(POOL_RELCACHE * relcache, POOL_CONNECTION_POOL * backend, char *table, char *value,
+				  uint32 generation);
 extern char *remove_quotes_and_schema_from_relname(char *table);
+extern size_t pool_shared_relcache_size(void);
+extern void pool_init_shared_relcache(void);
+extern uint32 pool_shared_relcache_generation(char *dbname);
+extern uint32 pool_shared_function_generation(void);
+extern void pool_invalidate_shared_relcache(char *dbname, char *relname);
+extern void pool_shared_relcache_handle_stmt(POOL_CONNECTION_POOL * backend, Node *node);
 extern void *int_register_func(POOL_SELECT_RESULT * res);
 extern void *int_unregister_func(void *data);
 extern void *string_register_func(POOL_SELECT_RESULT * res);
@@ -34,8 +34,24 @@
 #define POOL_MAX_SELECT_OIDS 128
 #define POOL_NAMEDATALEN 64		/* from NAMEDATALEN of PostgreSQL */
 
-typedef struct
+/*
+ * Facts to be collected by pool_analyze_select_stmt().
+ */
+#define POOL_SELECT_SYSTEM_CATALOG		0x0001
+#define POOL_SELECT_TEMP_TABLE			0x0002
+#define POOL_SELECT_UNLOGGED_TABLE		0x0004
+#define POOL_SELECT_VIEW				0x0008
+#define POOL_SELECT_FUNCTION_CALL		0x0010
+#define POOL_SELECT_TERMINATE_BACKEND	0x0020
+#define POOL_SELECT_NON_IMMUTABLE_FUNCTION	0x0040
+#define POOL_SELECT_INSERTINTO_OR_LOCKING	0x0080
+#define POOL_SELECT_TABLE_OIDS			0x0100
+
+typedef struct SelectContext
 {
+	Node	   *node;			/* parse tree analyzed */
+	int			analyzed;		/* POOL_SELECT_* facts already collected */
+	int			requested;		/* POOL_SELECT_* facts being collected */
 	bool		has_system_catalog; /* True if system catalog table is used */
 	bool		has_temp_table; /* True if temporary table is used */
 	bool		has_unlogged_table; /* True if unlogged table is used */
@@ -54,9 +70,12 @@ typedef struct
 	char		table_names[POOL_MAX_SELECT_OIDS][POOL_NAMEDATALEN];	/* table names */
 }			SelectContext;
 
+extern SelectContext * pool_analyze_select_stmt(Node *node, int flags);
 extern int	pool_get_terminate_backend_pid(Node *node);
 extern bool pool_has_function_call(Node *node);
 extern bool pool_has_non_immutable_function_call(Node *node);
+extern void pool_discard_immutable_function_maps(void);
+extern bool pool_is_function_ddl(Node *node);
 extern bool pool_has_system_catalog(Node *node);
 extern bool pool_has_temp_table(Node *node);
 extern void discard_temp_table_relcache(void);
@@ -746,6 +746,20 @@ process_node_info_response(PCPConnInfo * pcpConn, char *buf, int len)
 		index++;
 		backend_info->status_changed_time = atol(index);
 
+		index = (char *) memchr(index, '\0', len);
+		if (index == NULL)
+			goto INVALID_RESPONSE;
+
+		index++;
+		backend_info->health_check_latency = atol(index);
+
+		index = (char *) memchr(index, '\0', len);
+		if (index == NULL)
+			goto INVALID_RESPONSE;
+
+		index++;
+		backend_info->health_check_jitter = atol(index);
+
 		index = (char *) memchr(index, '\0', len);
 		if (index == NULL)
 			goto INVALID_RESPONSE;
@@ -73,6 +73,50 @@ static RETSIGTYPE reload_config_handler(int sig);
 static void reload_config(void);
 static RETSIGTYPE health_check_timer_handler(int sig);
 
+/*
+ * State of a probe in multiplexed health check mode.
+ */
+typedef enum
+{
+	PROBE_IDLE,					/* waiting for the next probe time */
+	PROBE_CONNECTING,			/* non blocking connect(2) is in progress */
+	PROBE_WAIT_SSL,				/* SSL request sent, waiting for 'S' or 'N' */
+	PROBE_WAIT_RESPONSE			/* startup packet sent, waiting for the first
+								 * response from the backend */
+}			ProbeState;
+
+typedef struct
+{
+	ProbeState	state;
+	int			fd;				/* socket to the backend */
+	int64		start;			/* when the probe started (ms) */
+	int64		start_usec;		/* when the probe started (us) */
+	int64		next;			/* when the next probe starts (ms) */
+	int			retries;		/* # of retries of the current check */
+	bool		check_failback; /* probing a down node for auto_failback */
+	int64		auto_failback_time; /* resume time of auto_failback (ms) */
+	int			resplen;		/* # of bytes in resp */
+	char		resp[9];		/* first response message: kind, length and
+								 * authentication request code */
+}			HealthCheckProbe;
+
+static HealthCheckProbe probes[MAX_NUM_BACKENDS];
+
+static int64 current_time_ms(void);
+static int64 current_time_usec(void);
+static int	probe_interval(int node);
+static bool probe_needed(int node, int64 now);
+static void start_probe(int node, int64 now);
+static void send_probe_first_packet(int node);
+static void send_probe_startup_packet(int node);
+static void read_probe_ssl_response(int node, int64 now);
+static void read_probe_response(int node, int64 now);
+static void probe_with_connection(int node, int64 now);
+static void finish_probe(int node, bool success, bool timed_out, int64 now);
+static void close_probe(int node);
+static void record_health_check_sample(int node, int64 latency);
+static int	compare_latency(const void *a, const void *b);
+
 #ifdef HEALTHCHECK_OPTS
 #if HEALTHCHECK_OPTS > 0
 #define HEALTHCHECK_DEBUG
@@ -239,6 +283,7 @@ establish_persistent_connection(int node)
 	static time_t auto_failback_interval = 0; /* resume time of auto_failback */
 	bool		check_failback = false;
 	time_t		now;
+	int64		start;
 
 	bkinfo = pool_get_node_info(node);
 
@@ -296,12 +341,15 @@ establish_persistent_connection(int node)
 				health_check_timer_expired = 0;
 			}
 
+			start = current_time_usec();
 			slot = make_persistent_db_connection_noerror(node, bkinfo->backend_hostname,
 														 bkinfo->backend_port,
 														 pool_config->health_check_params[node].health_check_database,
 														 pool_config->health_check_params[node].health_check_user,
 														 password ? password : "", false);
 
+			record_health_check_sample(node, slot ? current_time_usec() - start : -1);
+
 			if (pool_config->health_check_params[node].health_check_timeout > 0)
 			{
 				/* cancel health check timer */
@@ -375,6 +423,742 @@ discard_persistent_connection(int node)
 	}
 }
 
+/*
+* multiplexed health check main loop
+*
+* A single process checks all the backends. Probes are non blocking: a probe
+* connects to the backend, sends a startup packet and waits for the first
+* response (either an authentication request or an error), so all the
+* backends are checked concurrently in one select(2) loop and the probe
+* interval can be shorter than a second.
+*/
+void
+do_multiplexed_health_check_child(void *params)
+{
+	sigjmp_buf	local_sigjmp_buf;
+	MemoryContext HealthCheckMemoryContext;
+	int			i;
+
+	ereport(DEBUG1,
+			(errmsg("I am multiplexed health check process pid:%d", getpid())));
+
+	/* Identify myself via ps */
+	init_ps_display("", "", "", "");
+	set_ps_display("health check process(multiplexed)", false);
+
+	/* set up signal handlers */
+	signal(SIGALRM, SIG_DFL);
+	signal(SIGTERM, my_signal_handler);
+	signal(SIGINT, my_signal_handler);
+	signal(SIGHUP, reload_config_handler);
+	signal(SIGQUIT, my_signal_handler);
+	signal(SIGCHLD, SIG_IGN);
+	signal(SIGUSR1, my_signal_handler);
+	signal(SIGUSR2, SIG_IGN);
+	signal(SIGPIPE, SIG_IGN);
+
+	/* Create per loop iteration memory context */
+	HealthCheckMemoryContext = AllocSetContextCreate(TopMemoryContext,
+													 "health_check_main_loop",
+													 ALLOCSET_DEFAULT_MINSIZE,
+													 ALLOCSET_DEFAULT_INITSIZE,
+													 ALLOCSET_DEFAULT_MAXSIZE);
+
+	MemoryContextSwitchTo(TopMemoryContext);
+
+	/* Initialize my backend status */
+	pool_initialize_private_backend_status();
+
+	/* Initialize per process context */
+	pool_init_process_context();
+
+	for (i = 0; i < MAX_NUM_BACKENDS; i++)
+	{
+		probes[i].state = PROBE_IDLE;
+		probes[i].fd = -1;
+	}
+
+	if (sigsetjmp(local_sigjmp_buf, 1) != 0)
+	{
+		pool_signal(SIGALRM, SIG_IGN);
+		error_context_stack = NULL;
+		EmitErrorReport();
+		MemoryContextSwitchTo(TopMemoryContext);
+		FlushErrorState();
+
+		/* forget probes in progress, they are restarted from scratch */
+		for (i = 0; i < MAX_NUM_BACKENDS; i++)
+			close_probe(i);
+	}
+	/* We can now handle ereport(ERROR) */
+	PG_exception_stack = &local_sigjmp_buf;
+
+	for (;;)
+	{
+		struct timeval timeout;
+		fd_set		rset,
+					wset;
+		int64		now;
+		int64		wakeup;
+		int			maxfd = -1;
+		int			sts;
+
+		MemoryContextSwitchTo(HealthCheckMemoryContext);
+		MemoryContextResetAndDeleteChildren(HealthCheckMemoryContext);
+
+		CHECK_REQUEST;
+
+		now = current_time_ms();
+
+		/* wake up at least once a second to check requests */
+		wakeup = now + 1000;
+
+		FD_ZERO(&rset);
+		FD_ZERO(&wset);
+
+		for (i = 0; i < NUM_BACKENDS; i++)
+		{
+			HealthCheckProbe *probe = &probes[i];
+			int			timeout_ms = pool_config->health_check_params[i].health_check_timeout * 1000;
+
+			if (probe->state == PROBE_IDLE && now >= probe->next)
+			{
+				if (probe_needed(i, now))
+					start_probe(i, now);
+				else
+					probe->next = now + probe_interval(i);
+			}
+
+			if (probe->state != PROBE_IDLE && timeout_ms > 0)
+			{
+				if (now - probe->start >= timeout_ms)
+				{
+					finish_probe(i, false, true, now);
+				}
+				else if (probe->start + timeout_ms < wakeup)
+					wakeup = probe->start + timeout_ms;
+			}
+
+			if (probe->state == PROBE_IDLE)
+			{
+				if (probe->next < wakeup)
+					wakeup = probe->next;
+				continue;
+			}
+
+			if (probe->state == PROBE_CONNECTING)
+				FD_SET(probe->fd, &wset);
+			else
+				FD_SET(probe->fd, &rset);
+			if (probe->fd > maxfd)
+				maxfd = probe->fd;
+		}
+
+		if (wakeup < now)
+			wakeup = now;
+		timeout.tv_sec = (wakeup - now) / 1000;
+		timeout.tv_usec = ((wakeup - now) % 1000) * 1000;
+
+		sts = select(maxfd + 1, &rset, &wset, NULL, &timeout);
+		if (sts < 0)
+		{
+			if (errno != EINTR)
+				ereport(WARNING,
+						(errmsg("multiplexed health check: select() failed"),
+						 errdetail("%s", strerror(errno))));
+			continue;
+		}
+		if (sts == 0)
+			continue;
+
+		now = current_time_ms();
+
+		for (i = 0; i < NUM_BACKENDS; i++)
+		{
+			HealthCheckProbe *probe = &probes[i];
+
+			if (probe->state == PROBE_CONNECTING && FD_ISSET(probe->fd, &wset))
+			{
+				int			error = 0;
+				socklen_t	socklen = sizeof(error);
+
+				if (getsockopt(probe->fd, SOL_SOCKET, SO_ERROR, &error, &socklen) < 0 ||
+					error != 0)
+				{
+					ereport(LOG,
+							(errmsg("health check failed to connect to DB node: %d", i),
+							 errdetail("%s", strerror(error ? error : errno))));
+					finish_probe(i, false, false, now);
+				}
+				else
+					send_probe_first_packet(i);
+			}
+			else if (probe->state == PROBE_WAIT_SSL && FD_ISSET(probe->fd, &rset))
+				read_probe_ssl_response(i, now);
+			else if (probe->state == PROBE_WAIT_RESPONSE && FD_ISSET(probe->fd, &rset))
+				read_probe_response(i, now);
+		}
+	}
+	exit(0);
+}
+
+static int64
+current_time_ms(void)
+{
+	return current_time_usec() / 1000;
+}
+
+static int64
+current_time_usec(void)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (int64) now.tv_sec * 1000000 + now.tv_usec;
+}
+
+/*
+ * Interval between the probes of the node in milliseconds.
+ * health_check_probe_interval takes precedence over health_check_period.
+ */
+static int
+probe_interval(int node)
+{
+	if (pool_config->health_check_probe_interval > 0)
+		return pool_config->health_check_probe_interval;
+	if (pool_config->health_check_params[node].health_check_period > 0)
+		return pool_config->health_check_params[node].health_check_period * 1000;
+	/* health check is disabled for the node. check the setting later */
+	return 1000;
+}
+
+/*
+ * Return true if the node needs to be probed now. This is the same logic as
+ * establish_persistent_connection(): down nodes are only checked for
+ * quarantine and auto_failback.
+ */
+static bool
+probe_needed(int node, int64 now)
+{
+	BackendInfo *bkinfo = pool_get_node_info(node);
+	HealthCheckProbe *probe = &probes[node];
+
+	probe->check_failback = false;
+
+	if (pool_config->health_check_params[node].health_check_period <= 0)
+		return false;
+
+	if (bkinfo->backend_status == CON_UNUSED ||
+		(bkinfo->backend_status == CON_DOWN && bkinfo->quarantine == false))
+	{
+		if (pool_config->auto_failback && probe->auto_failback_time < now &&
+			STREAM && !strcmp(bkinfo->replication_state, "streaming") && !Req_info->switching)
+		{
+			ereport(DEBUG1,
+					(errmsg("health check DB node: %d (status:%d) for auto_failback", node, bkinfo->backend_status)));
+			probe->check_failback = true;
+			return true;
+		}
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Start non blocking connection to the backend.
+ */
+static void
+start_probe(int node, int64 now)
+{
+	BackendInfo *bkinfo = pool_get_node_info(node);
+	HealthCheckProbe *probe = &probes[node];
+	int			fd;
+	int			ret;
+
+	probe->start = now;
+	probe->start_usec = current_time_usec();
+	probe->resplen = 0;
+
+	if (*bkinfo->backend_hostname == '/')
+	{
+		struct sockaddr_un addr;
+
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0)
+		{
+			finish_probe(node, false, false, now);
+			return;
+		}
+		memset((char *) &addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/.s.PGSQL.%d",
+				 bkinfo->backend_hostname, bkinfo->backend_port);
+		pool_set_nonblock(fd);
+		ret = connect(fd, (struct sockaddr *) &addr, sizeof(addr));
+	}
+	else
+	{
+		struct addrinfo hints;
+		struct addrinfo *res;
+		char		portstr[16];
+		int			on = 1;
+
+		snprintf(portstr, sizeof(portstr), "%d", bkinfo->backend_port);
+		memset(&hints, 0, sizeof(struct addrinfo));
+		hints.ai_family = PF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+
+		if ((ret = getaddrinfo(bkinfo->backend_hostname, portstr, &hints, &res)) != 0)
+		{
+			ereport(LOG,
+					(errmsg("health check failed to resolve DB node: %d", node),
+					 errdetail("getaddrinfo() failed with error \"%s\"", gai_strerror(ret))));
+			finish_probe(node, false, false, now);
+			return;
+		}
+
+		fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+		if (fd < 0)
+		{
+			freeaddrinfo(res);
+			finish_probe(node, false, false, now);
+			return;
+		}
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (char *) &on, sizeof(on));
+		pool_set_nonblock(fd);
+		ret = connect(fd, res->ai_addr, res->ai_addrlen);
+		freeaddrinfo(res);
+	}
+
+	probe->fd = fd;
+
+	if (ret == 0)
+		send_probe_first_packet(node);
+	else if (errno == EINPROGRESS)
+		probe->state = PROBE_CONNECTING;
+	else
+	{
+		ereport(LOG,
+				(errmsg("health check failed to connect to DB node: %d", node),
+				 errdetail("%s", strerror(errno))));
+		finish_probe(node, false, false, now);
+	}
+}
+
+/*
+ * Send the first packet to the connected backend. If SSL is enabled, ask the
+ * backend for SSL first as the child processes do, otherwise a backend which
+ * only allows hostssl connections would reject the probe.
+ */
+static void
+send_probe_first_packet(int node)
+{
+#ifdef USE_SSL
+	HealthCheckProbe *probe = &probes[node];
+
+	if (pool_config->ssl)
+	{
+		int			ssl_packet[2] = {htonl(sizeof(int) * 2), htonl(NEGOTIATE_SSL_CODE)};
+
+		if (write(probe->fd, ssl_packet, sizeof(ssl_packet)) != sizeof(ssl_packet))
+		{
+			ereport(LOG,
+					(errmsg("health check failed to send SSL request to DB node: %d", node),
+					 errdetail("%s", strerror(errno))));
+			finish_probe(node, false, false, current_time_ms());
+			return;
+		}
+		probe->state = PROBE_WAIT_SSL;
+		return;
+	}
+#endif
+	send_probe_startup_packet(node);
+}
+
+/*
+ * Read the response to the SSL request. If the backend refuses SSL, go on
+ * with the plain startup packet. If it accepts SSL, the handshake is not done
+ * in the select(2) loop: the node is checked with a regular connection
+ * instead, which blocks the other probes for at most health_check_timeout.
+ */
+static void
+read_probe_ssl_response(int node, int64 now)
+{
+	HealthCheckProbe *probe = &probes[node];
+	char		response;
+	int			n;
+
+	n = read(probe->fd, &response, 1);
+	if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+		return;
+	if (n <= 0)
+	{
+		ereport(LOG,
+				(errmsg("health check failed on DB node: %d", node),
+				 errdetail("connection closed by backend")));
+		finish_probe(node, false, false, now);
+		return;
+	}
+
+	switch (response)
+	{
+		case 'N':
+			send_probe_startup_packet(node);
+			break;
+		case 'S':
+			close(probe->fd);
+			probe->fd = -1;
+			probe_with_connection(node, now);
+			break;
+		default:
+			ereport(LOG,
+					(errmsg("health check failed on DB node: %d", node),
+					 errdetail("unhandled response to SSL request: \"%c\"", response)));
+			finish_probe(node, false, false, now);
+			break;
+	}
+}
+
+/*
+ * Check the node with a regular connection to the backend, including SSL
+ * handshake and authentication. Used when the backend accepts SSL.
+ */
+static void
+probe_with_connection(int node, int64 now)
+{
+	BackendInfo *bkinfo = pool_get_node_info(node);
+	HealthCheckParams *params = &pool_config->health_check_params[node];
+	POOL_CONNECTION_POOL_SLOT *s;
+	char	   *database = params->health_check_database;
+	char	   *password;
+
+	if (*database == '\0')
+		database = "postgres";
+
+	password = get_pgpool_config_user_password(params->health_check_user,
+											   params->health_check_password);
+
+	health_check_timer_expired = 0;
+	if (params->health_check_timeout > 0)
+	{
+		/* the probe has already used some of the timeout */
+		int			remaining = params->health_check_timeout - (current_time_ms() - probes[node].start) / 1000;
+
+		pool_signal(SIGALRM, health_check_timer_handler);
+		alarm(remaining > 0 ? remaining : 1);
+	}
+
+	s = make_persistent_db_connection_noerror(node, bkinfo->backend_hostname,
+											  bkinfo->backend_port,
+											  database,
+											  params->health_check_user,
+											  password ? password : "", false);
+
+	if (params->health_check_timeout > 0)
+	{
+		pool_signal(SIGALRM, SIG_IGN);
+		alarm(0);
+	}
+
+	if (password)
+		pfree(password);
+
+	if (s)
+		discard_persistent_db_connection(s);
+
+	finish_probe(node, s != NULL, s == NULL && health_check_timer_expired, current_time_ms());
+}
+
+/*
+ * Send startup packet for health_check_user and health_check_database.
+ */
+static void
+send_probe_startup_packet(int node)
+{
+	HealthCheckProbe *probe = &probes[node];
+	char	   *user = pool_config->health_check_params[node].health_check_user;
+	char	   *database = pool_config->health_check_params[node].health_check_database;
+	char		packet[1024];
+	int			len;
+	int			n;
+
+	if (*database == '\0')
+		database = "postgres";
+
+	len = sizeof(int) * 2;
+	len += snprintf(packet + len, sizeof(packet) - len, "user%c%.*s%c", 0, 255, user, 0);
+	len += snprintf(packet + len, sizeof(packet) - len, "database%c%.*s%c", 0, 255, database, 0);
+	packet[len++] = '\0';
+
+	n = htonl(len);
+	memcpy(packet, &n, sizeof(n));
+	n = htonl(PROTO_MAJOR_V3 << 16);
+	memcpy(packet + sizeof(int), &n, sizeof(n));
+
+	/* the socket buffer of a new connection never fills up with this */
+	if (write(probe->fd, packet, len) != len)
+	{
+		ereport(LOG,
+				(errmsg("health check failed to send startup packet to DB node: %d", node),
+				 errdetail("%s", strerror(errno))));
+		finish_probe(node, false, false, current_time_ms());
+		return;
+	}
+	probe->state = PROBE_WAIT_RESPONSE;
+}
+
+/*
+ * Read the first response of the backend. An authentication request means
+ * the backend is accepting connections. The authentication itself is not
+ * done: the connection is just closed, which PostgreSQL handles silently.
+ */
+static void
+read_probe_response(int node, int64 now)
+{
+	HealthCheckProbe *probe = &probes[node];
+	int			n;
+
+	n = read(probe->fd, probe->resp + probe->resplen, sizeof(probe->resp) - probe->resplen);
+	if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+		return;
+	if (n <= 0)
+	{
+		ereport(LOG,
+				(errmsg("health check failed on DB node: %d", node),
+				 errdetail("connection closed by backend")));
+		finish_probe(node, false, false, now);
+		return;
+	}
+	probe->resplen += n;
+
+	if (probe->resp[0] != 'R')
+	{
+		ereport(LOG,
+				(errmsg("health check failed on DB node: %d", node),
+				 errdetail("backend rejected the connection with message kind \"%c\"", probe->resp[0])));
+		finish_probe(node, false, false, now);
+		return;
+	}
+
+	if (probe->resplen < sizeof(probe->resp))
+		return;
+
+	/* authentication ok (trust). say good-bye */
+	if (probe->resp[5] == 0 && probe->resp[6] == 0 &&
+		probe->resp[7] == 0 && probe->resp[8] == 0)
+	{
+		static char terminate[] = {'X', 0, 0, 0, 4};
+
+		if (write(probe->fd, terminate, sizeof(terminate)) < 0)
+			ereport(DEBUG1,
+					(errmsg("health check failed to send terminate message to DB node: %d", node)));
+	}
+
+	finish_probe(node, true, false, now);
+}
+
+/*
+ * Finish the probe, record the result and handle the failure in the same
+ * way as per node health check does.
+ */
+static void
+finish_probe(int node, bool success, bool timed_out, int64 now)
+{
+	HealthCheckProbe *probe = &probes[node];
+	BackendInfo *bkinfo = pool_get_node_info(node);
+	HealthCheckParams *params = &pool_config->health_check_params[node];
+
+	close_probe(node);
+
+	if (success)
+	{
+		record_health_check_sample(node, current_time_usec() - probe->start_usec);
+
+		if (probe->retries > 0)
+			ereport(LOG,
+					(errmsg("health check retrying on DB node: %d succeeded", node)));
+		probe->retries = 0;
+		probe->next = probe->start + probe_interval(node);
+
+		if (probe->check_failback)
+		{
+			if (!Req_info->switching)
+			{
+				ereport(LOG,
+						(errmsg("request auto failback, node id:%d", node)));
+				probe->auto_failback_time = now + pool_config->auto_failback_interval * 1000;
+				send_failback_request(node, true, REQ_DETAIL_CONFIRMED);
+			}
+		}
+		else if (bkinfo->backend_status == CON_DOWN && bkinfo->quarantine == true)
+		{
+			/*
+			 * The node has become reachable again. Reset the quarantine
+			 * state
+			 */
+			send_failback_request(node, false, REQ_DETAIL_UPDATE | REQ_DETAIL_WATCHDOG);
+		}
+		return;
+	}
+
+	record_health_check_sample(node, -1);
+
+	/* nothing to do if the down node is still unreachable */
+	if (probe->check_failback)
+	{
+		probe->next = now + probe_interval(node);
+		return;
+	}
+
+	if (probe->retries < params->health_check_max_retries)
+	{
+		probe->retries++;
+		ereport(LOG,
+				(errmsg("health check retrying on DB node: %d (round:%d)",
+						node, probe->retries)));
+		probe->next = now + params->health_check_retry_delay * 1000;
+		return;
+	}
+
+	probe->retries = 0;
+	probe->next = now + probe_interval(node);
+
+	if (POOL_DISALLOW_TO_FAILOVER(BACKEND_INFO(node).flag))
+	{
+		ereport(LOG,
+				(errmsg("health check failed on node %d but failover is disallowed for the node",
+						node)));
+	}
+	else
+	{
+		ereport(LOG, (errmsg("health check failed on node %d (timeout:%d)",
+							 node, timed_out)));
+
+		if (bkinfo->backend_status == CON_DOWN && bkinfo->quarantine == true)
+		{
+			ereport(LOG, (errmsg("health check failed on quarantine node %d (timeout:%d)",
+								 node, timed_out),
+						  errdetail("ignoring..")));
+		}
+		else
+		{
+			/* trigger failover */
+			degenerate_backend_set(&node, 1, timed_out ? 0 : REQ_DETAIL_SWITCHOVER);
+		}
+	}
+}
+
+static void
+close_probe(int node)
+{
+	HealthCheckProbe *probe = &probes[node];
+
+	if (probe->fd >= 0)
+		close(probe->fd);
+	probe->fd = -1;
+	probe->state = PROBE_IDLE;
+}
+
+/*
+ * Record the result of a probe in the statistics of the node. Negative
+ * latency means the probe failed.
+ */
+static void
+record_health_check_sample(int node, int64 latency)
+{
+	HealthCheckStats *stats = &health_check_stats[node];
+	HealthCheckSample *sample = &stats->samples[stats->next];
+	HealthCheckStatsSummary summary;
+
+	sample->time = time(NULL);
+	sample->latency = latency < 0 ? -1 : latency;
+	stats->next = (stats->next + 1) % HEALTH_CHECK_STATS_SAMPLES;
+
+	if (latency < 0)
+		stats->failures++;
+	else
+		stats->probes++;
+
+	/*
+	 * Keep the percentile used by load balancing up to date here so that
+	 * children need not compute it for every load balancing decision.
+	 */
+	health_check_stats_summary(node, &summary);
+	stats->p90 = summary.nsamples > 0 ? summary.p90 : 0;
+}
+
+static int
+compare_latency(const void *a, const void *b)
+{
+	int64		l1 = *(const int64 *) a;
+	int64		l2 = *(const int64 *) b;
+
+	return l1 < l2 ? -1 : (l1 > l2 ? 1 : 0);
+}
+
+/*
+ * Compute the summary of the health check statistics of the node. This can
+ * be called from any process. The statistics are read without locking
+ * since they are only updated by the health check process and a slightly
+ * inconsistent snapshot is harmless.
+ */
+void
+health_check_stats_summary(int node, HealthCheckStatsSummary * summary)
+{
+	HealthCheckStats stats;
+	int64		latencies[HEALTH_CHECK_STATS_SAMPLES];
+	int64		sum = 0;
+	int64		jitter = 0;
+	int64		prev = -1;
+	int			njitter = 0;
+	int			n = 0;
+	int			i;
+
+	memcpy(&stats, &health_check_stats[node], sizeof(stats));
+	memset(summary, 0, sizeof(*summary));
+	summary->probes = stats.probes;
+	summary->failures = stats.failures;
+	summary->last = -1;
+
+	/* walk the ring from the oldest sample */
+	for (i = 0; i < HEALTH_CHECK_STATS_SAMPLES; i++)
+	{
+		HealthCheckSample *sample = &stats.samples[(stats.next + i) % HEALTH_CHECK_STATS_SAMPLES];
+
+		if (sample->time == 0)
+			continue;
+
+		summary->last_time = sample->time;
+		summary->last = sample->latency;
+
+		if (sample->latency < 0)
+			continue;
+
+		if (prev >= 0)
+		{
+			jitter += sample->latency > prev ? sample->latency - prev : prev - sample->latency;
+			njitter++;
+		}
+		prev = sample->latency;
+		sum += sample->latency;
+		latencies[n++] = sample->latency;
+	}
+
+	summary->nsamples = n;
+	if (n == 0)
+		return;
+
+	qsort(latencies, n, sizeof(int64), compare_latency);
+	summary->min = latencies[0];
+	summary->max = latencies[n - 1];
+	summary->avg = sum / n;
+	summary->p50 = latencies[(n - 1) * 50 / 100];
+	summary->p90 = latencies[(n - 1) * 90 / 100];
+	summary->p99 = latencies[(n - 1) * 99 / 100];
+	if (njitter > 0)
+		summary->jitter = jitter / njitter;
+}
+
 static RETSIGTYPE my_signal_handler(int sig)
 {
 	int			save_errno = errno;
@@ -50,6 +50,7 @@
 #include "pool.h"
 #include "utils/palloc.h"
 #include "utils/memutils.h"
+#include "utils/pool_stream.h"
 #include "pool_config.h"
 #include "context/pool_process_context.h"
 #include "version.h"
@@ -57,6 +58,7 @@
 #include "auth/pool_passwd.h"
 #include "auth/pool_hba.h"
 #include "query_cache/pool_memqcache.h"
+#include "utils/pool_relcache.h"
 #include "watchdog/wd_ipc_commands.h"
 #include "watchdog/wd_lifecheck.h"
 
@@ -119,6 +121,7 @@ static void FileUnlink(int code, Datum path);
 static pid_t pcp_fork_a_child(int unix_fd, int inet_fd, char *pcp_conf_file);
 static pid_t fork_a_child(int *fds, int id);
 static pid_t worker_fork_a_child(ProcessType type, void (*func) (), void *params);
+static void do_memqcache_loader_child(void *params);
 static int	create_unix_domain_socket(struct sockaddr_un un_addr_tmp);
 static int	create_inet_domain_socket(const char *hostname, const int port);
 static int *create_inet_domain_sockets(const char *hostname, const int port);
@@ -129,7 +132,9 @@ static void wakeup_children(void);
 static void reload_config(void);
 static int	pool_pause(struct timeval *timeout);
 static void kill_all_children(int sig);
+static void manage_spare_children(void);
 static pid_t fork_follow_child(int old_master, int new_primary, int old_primary);
+static bool child_uses_nodes(int child_id, int *nodes);
 static int	read_status_file(bool discard_status);
 static RETSIGTYPE exit_handler(int sig);
 static RETSIGTYPE reap_handler(int sig);
@@ -150,6 +155,8 @@ static void sync_backend_from_watchdog(void);
 static void update_backend_quarantine_status(void);
 static void degenerate_all_quarantine_nodes(void);
 static int	get_server_version(POOL_CONNECTION_POOL_SLOT * *slots, int node_id);
+static void get_recovery_status_of_all_nodes(POOL_CONNECTION_POOL_SLOT * *slots, char *in_recovery);
+static bool read_recovery_status(POOL_CONNECTION_POOL_SLOT * slot, int node_id, char *in_recovery);
 static void get_info_from_conninfo(char *conninfo, char *host, char *port);
 
 static struct sockaddr_un un_addr;	/* unix domain socket path */
@@ -190,6 +197,11 @@ static int	switching = 0;		/* non 0 if I'm failing over or degenerating */
 
 POOL_REQUEST_INFO *Req_info;	/* request info area in shared memory */
 volatile sig_atomic_t *InRecovery;	/* non 0 if recovery is started */
+ReplicationLagHistory *replication_lag_history; /* replication delay samples */
+HealthCheckStats *health_check_stats;	/* health check statistics */
+StartupPacketStat *startup_packet_stats;	/* frequently used startup packets */
+PrewarmStartupLimit *prewarm_startup_limit;	/* rate limit of prewarming at
+											 * start up */
 volatile sig_atomic_t reload_config_request = 0;
 static volatile sig_atomic_t sigusr1_request = 0;
 static volatile sig_atomic_t sigchld_request = 0;
@@ -208,6 +220,9 @@ static pid_t pcp_pid = 0;		/* pid for child process handling PCP */
 static pid_t watchdog_pid = 0;	/* pid for watchdog child process */
 static pid_t wd_lifecheck_pid = 0;	/* pid for child process handling watchdog
 									 * lifecheck */
+static pid_t memqcache_loader_pid = 0;	/* pid for child process loading
+										 * query cache snapshot */
+static bool memqcache_snapshot_pending = false;
 
 BACKEND_STATUS *my_backend_status[MAX_NUM_BACKENDS];	/* Backend status buffer */
 int			my_master_node_id;	/* Master node id buffer */
@@ -378,9 +393,16 @@ PgpoolMain(bool discard_status, bool clear_memcache_oidmaps)
 	 * is harmless.
 	 */
 	POOL_SETMASK(&BlockSig);
-	/* fork the children */
+	/*
+	 * Fork the children. In dynamic process management mode, start with
+	 * max_spare_children and let manage_spare_children() adjust them.
+	 */
 	for (i = 0; i < pool_config->num_init_children; i++)
 	{
+		if (pool_config->process_management_mode == PM_DYNAMIC &&
+			i >= pool_config->max_spare_children)
+			break;
+
 		process_info[i].pid = fork_a_child(fds, i);
 		process_info[i].start_time = time(NULL);
 	}
@@ -427,13 +449,29 @@ PgpoolMain(bool discard_status, bool clear_memcache_oidmaps)
 	/* Fork worker process */
 	worker_pid = worker_fork_a_child(PT_WORKER, do_worker_child, NULL);
 
-	/* Fork health check process */
-	for (i = 0; i < NUM_BACKENDS; i++)
+	/*
+	 * Fork health check process. In multiplexed health check mode, a single
+	 * process checks all the nodes and its pid is kept in
+	 * health_check_pids[0].
+	 */
+	if (pool_config->health_check_mode == HC_MULTIPLEXED)
+		health_check_pids[0] = worker_fork_a_child(PT_HEALTH_CHECK, do_multiplexed_health_check_child, NULL);
+	else
 	{
-		if (VALID_BACKEND(i))
-			health_check_pids[i] = worker_fork_a_child(PT_HEALTH_CHECK, do_health_check_child, &i);
+		for (i = 0; i < NUM_BACKENDS; i++)
+		{
+			if (VALID_BACKEND(i))
+				health_check_pids[i] = worker_fork_a_child(PT_HEALTH_CHECK, do_health_check_child, &i);
+		}
 	}
 
+	/*
+	 * Load query cache snapshot in background. Children do not use the
+	 * cache until loading is done, but they can serve clients meanwhile.
+	 */
+	if (memqcache_snapshot_pending)
+		memqcache_loader_pid = worker_fork_a_child(PT_WORKER, do_memqcache_loader_child, NULL);
+
 	if (sigsetjmp(local_sigjmp_buf, 1) != 0)
 	{
 		/* Since not using PG_TRY, must reset error stack by hand */
@@ -501,9 +539,17 @@ PgpoolMain(bool discard_status, bool clear_memcache_oidmaps)
 			int			r;
 			struct timeval t = {3, 0};
 
+			/* Check spare children every second in dynamic mode */
+			if (pool_config->process_management_mode == PM_DYNAMIC)
+				t.tv_sec = 1;
+
 			POOL_SETMASK(&UnBlockSig);
 			r = pool_pause(&t);
 			POOL_SETMASK(&BlockSig);
+
+			if (pool_config->process_management_mode == PM_DYNAMIC)
+				manage_spare_children();
+
 			if (r > 0)
 				break;
 		}
@@ -720,6 +766,26 @@ static pid_t worker_fork_a_child(ProcessType type, void (*func) (), void *params
 	return pid;
 }
 
+/*
+ * Main of the process loading query cache snapshot. Exits when done.
+ */
+static void
+do_memqcache_loader_child(void *params)
+{
+	pool_signal(SIGTERM, SIG_DFL);
+	pool_signal(SIGINT, SIG_DFL);
+	pool_signal(SIGQUIT, SIG_DFL);
+	pool_signal(SIGCHLD, SIG_DFL);
+	pool_signal(SIGUSR1, SIG_IGN);
+	pool_signal(SIGUSR2, SIG_IGN);
+	pool_signal(SIGHUP, SIG_IGN);
+
+	set_ps_display("query cache loader", false);
+
+	pool_load_memqcache_snapshot();
+	exit(POOL_EXIT_NO_RESTART);
+}
+
 static int *
 create_inet_domain_sockets(const char *hostname, const int port)
 {
@@ -1017,6 +1083,8 @@ terminate_all_childrens()
 	if (worker_pid != 0)
 		kill(worker_pid, SIGINT);
 	worker_pid = 0;
+	if (memqcache_loader_pid != 0)
+		kill(memqcache_loader_pid, SIGINT);
 	if (pool_config->use_watchdog)
 	{
 		if (pool_config->use_watchdog)
@@ -1653,6 +1721,8 @@ failover(void)
 	int			nodes[MAX_NUM_BACKENDS];
 	bool		need_to_restart_children = true;
 	bool		partial_restart = false;
+	bool		restart_affected_children = false;
+	bool	   *restart_children = NULL;	/* children killed to restart */
 	int			status;
 	int			sts;
 	bool		need_to_restart_pcp = false;
@@ -2028,6 +2098,47 @@ failover(void)
 				}
 			}
 		}
+		/*
+		 * If neither the master node nor the primary node goes down, only the
+		 * children whose sessions use the failed nodes need to be restarted.
+		 * In streaming replication mode, a session not load balanced to the
+		 * failed nodes closes its connections to them by itself and
+		 * continues.  Other children are told to discard their pooled
+		 * connections and refresh the backend status when they accept the
+		 * next session.
+		 */
+		else if ((reqkind == NODE_DOWN_REQUEST || reqkind == NODE_QUARANTINE_REQUEST) &&
+				 REAL_MASTER_NODE_ID >= 0 && !nodes[REAL_MASTER_NODE_ID] &&
+				 (Req_info->primary_node_id < 0 || !nodes[Req_info->primary_node_id]))
+		{
+			ereport(LOG,
+					(errmsg("Restart children using the failed nodes")));
+
+			need_to_restart_children = true;
+			partial_restart = true;
+			restart_affected_children = true;
+
+			/*
+			 * Remember the killed children so that they are surely forked
+			 * again below even if their connection info changes meanwhile.
+			 */
+			if (restart_children == NULL)
+				restart_children = palloc0(sizeof(bool) * pool_config->num_init_children);
+
+			for (i = 0; i < pool_config->num_init_children; i++)
+			{
+				pid_t		pid = process_info[i].pid;
+
+				if (pid && child_uses_nodes(i, nodes))
+				{
+					restart_children[i] = true;
+					kill(pid, SIGQUIT);
+					ereport(DEBUG1,
+							(errmsg("failover handler"),
+							 errdetail("kill process with PID:%d", pid)));
+				}
+			}
+		}
 		else
 		{
 			ereport(LOG,
@@ -2216,6 +2327,9 @@ failover(void)
 		/* Kill children and restart them if needed */
 		if (need_to_restart_children)
 		{
+			if (restart_children == NULL)
+				restart_children = palloc0(sizeof(bool) * pool_config->num_init_children);
+
 			for (i = 0; i < pool_config->num_init_children; i++)
 			{
 				/*
@@ -2231,7 +2345,17 @@ failover(void)
 
 				bool		restart = false;
 
-				if (partial_restart)
+				if (partial_restart && restart_affected_children)
+				{
+					if (restart_children[i] || child_uses_nodes(i, nodes))
+					{
+						ereport(DEBUG1,
+								(errmsg("child pid %d needs to restart because its session uses failed backends",
+										process_info[i].pid)));
+						restart = true;
+					}
+				}
+				else if (partial_restart)
 				{
 					for (j = 0; j < pool_config->max_pool; j++)
 					{
@@ -2259,14 +2383,27 @@ failover(void)
 					if (process_info[i].pid)
 					{
 						kill(process_info[i].pid, SIGQUIT);
-
-						process_info[i].pid = fork_a_child(fds, i);
-						process_info[i].start_time = time(NULL);
+						restart_children[i] = true;
 					}
 				}
 				else
 					process_info[i].need_to_restart = 1;
 			}
+
+			/*
+			 * Fork the new children after all the old ones have been told to
+			 * exit, so that they shut down concurrently while we are forking.
+			 */
+			for (i = 0; i < pool_config->num_init_children; i++)
+			{
+				if (!restart_children[i])
+					continue;
+
+				process_info[i].pid = fork_a_child(fds, i);
+				process_info[i].start_time = time(NULL);
+			}
+			pfree(restart_children);
+			restart_children = NULL;
 		}
 
 		else
@@ -2296,17 +2433,28 @@ failover(void)
 							BACKEND_INFO(node_id).backend_hostname,
 							BACKEND_INFO(node_id).backend_port)));
 
-			/* Fork health check process if needed */
-			for (i = 0; i < NUM_BACKENDS; i++)
+			/*
+			 * Fork health check process if needed. The multiplexed health
+			 * check process picks up the node by itself.
+			 */
+			if (pool_config->health_check_mode == HC_MULTIPLEXED)
+			{
+				if (health_check_pids[0] == 0)
+					health_check_pids[0] = worker_fork_a_child(PT_HEALTH_CHECK, do_multiplexed_health_check_child, NULL);
+			}
+			else
 			{
-				if (health_check_pids[i] == 0)
+				for (i = 0; i < NUM_BACKENDS; i++)
 				{
-					ereport(LOG,
-							(errmsg("start health check process for host %s(%d)",
-									BACKEND_INFO(node_id).backend_hostname,
-									BACKEND_INFO(node_id).backend_port)));
+					if (health_check_pids[i] == 0)
+					{
+						ereport(LOG,
+								(errmsg("start health check process for host %s(%d)",
+										BACKEND_INFO(node_id).backend_hostname,
+										BACKEND_INFO(node_id).backend_port)));
 
-					health_check_pids[i] = worker_fork_a_child(PT_HEALTH_CHECK, do_health_check_child, &i);
+						health_check_pids[i] = worker_fork_a_child(PT_HEALTH_CHECK, do_health_check_child, &i);
+					}
 				}
 			}
 		}
@@ -2533,6 +2681,8 @@ process_name_from_pid(pid_t pid)
 		return "PCP child";
 	if (pid == worker_pid)
 		return "worker child";
+	if (pid == memqcache_loader_pid)
+		return "query cache loader";
 	if (pool_config->use_watchdog)
 	{
 		if (pid == watchdog_pid)
@@ -2716,6 +2866,15 @@ reaper(void)
 			}
 		}
 
+		/* Query cache loader is never restarted */
+		if (found == false && pid == memqcache_loader_pid)
+		{
+			found = true;
+			memqcache_loader_pid = 0;
+			if (!exiting)
+				pool_abort_memqcache_loading();
+		}
+
 		/* Check health check process */
 		if (found == false)
 		{
@@ -2726,7 +2885,12 @@ reaper(void)
 					found = true;
 
 					/* Fork new health check worker */
-					if (!switching && !exiting && VALID_BACKEND(i))
+					if (!switching && !exiting &&
+						pool_config->health_check_mode == HC_MULTIPLEXED)
+					{
+						health_check_pids[i] = worker_fork_a_child(PT_HEALTH_CHECK, do_multiplexed_health_check_child, NULL);
+					}
+					else if (!switching && !exiting && VALID_BACKEND(i))
 					{
 						health_check_pids[i] = worker_fork_a_child(PT_HEALTH_CHECK, do_health_check_child, &i);
 					}
@@ -2758,6 +2922,74 @@ reaper(void)
 			(errmsg("reaper handler: exiting normally")));
 }
 
+/*
+ * Keep the number of idle children between min_spare_children and
+ * max_spare_children in dynamic process management mode. New children
+ * are forked into free slots up to num_init_children. Surplus idle
+ * children are asked to exit; they do so only while they are idle.
+ */
+static void
+manage_spare_children(void)
+{
+	int			idle = 0;
+	int			n;
+	int			i;
+
+	if (switching || exiting)
+		return;
+
+	for (i = 0; i < pool_config->num_init_children; i++)
+	{
+		if (process_info[i].pid &&
+			process_info[i].wait_for_connect &&
+			!process_info[i].exit_if_idle)
+			idle++;
+	}
+
+	if (idle < pool_config->min_spare_children)
+	{
+		n = pool_config->min_spare_children - idle;
+
+		for (i = 0; i < pool_config->num_init_children && n > 0; i++)
+		{
+			if (process_info[i].pid)
+				continue;
+
+			process_info[i].need_to_restart = 0;
+			process_info[i].exit_if_idle = 0;
+
+			/* Regard as idle until the child starts */
+			process_info[i].wait_for_connect = 1;
+			process_info[i].pid = fork_a_child(fds, i);
+			process_info[i].start_time = time(NULL);
+			n--;
+
+			ereport(DEBUG1,
+					(errmsg("forked a spare child process with pid: %d", process_info[i].pid)));
+		}
+	}
+	else if (idle > pool_config->max_spare_children)
+	{
+		n = idle - pool_config->max_spare_children;
+
+		/* Retire children in higher slots first */
+		for (i = pool_config->num_init_children - 1; i >= 0 && n > 0; i--)
+		{
+			if (process_info[i].pid &&
+				process_info[i].wait_for_connect &&
+				!process_info[i].exit_if_idle)
+			{
+				process_info[i].exit_if_idle = 1;
+				kill(process_info[i].pid, SIGUSR2);
+				n--;
+
+				ereport(DEBUG1,
+						(errmsg("retiring a spare child process with pid: %d", process_info[i].pid)));
+			}
+		}
+	}
+}
+
 /*
  * get node information specified by node_number
  */
@@ -2780,18 +3012,29 @@ pool_get_node_count(void)
 }
 
 /*
- * get process ids
+ * get process ids. Empty slots in dynamic process management mode are
+ * skipped.
  */
 int *
 pool_get_process_list(int *array_size)
 {
 	int		   *array;
+	int			count = 0;
 	int			i;
 
-	*array_size = pool_config->num_init_children;
-	array = palloc0(*array_size * sizeof(int));
-	for (i = 0; i < *array_size; i++)
-		array[i] = process_info[i].pid;
+	for (i = 0; i < pool_config->num_init_children; i++)
+	{
+		if (process_info[i].pid != 0)
+			count++;
+	}
+
+	array = palloc0((count > 0 ? count : 1) * sizeof(int));
+	*array_size = 0;
+	for (i = 0; i < pool_config->num_init_children && *array_size < count; i++)
+	{
+		if (process_info[i].pid != 0)
+			array[(*array_size)++] = process_info[i].pid;
+	}
 
 	return array;
 }
@@ -2804,6 +3047,9 @@ pool_get_process_info(pid_t pid)
 {
 	int			i;
 
+	if (pid == 0)
+		return NULL;
+
 	for (i = 0; i < pool_config->num_init_children; i++)
 		if (process_info[i].pid == pid)
 			return &process_info[i];
@@ -3117,46 +3363,38 @@ trigger_failover_command(int node, const char *command_line,
  */
 static POOL_NODE_STATUS pool_node_status[MAX_NUM_BACKENDS];
 
+/* backend server versions cached by get_server_version() */
+static int	server_versions[MAX_NUM_BACKENDS];
+
 POOL_NODE_STATUS *
 verify_backend_node_status(POOL_CONNECTION_POOL_SLOT * *slots)
 {
 	POOL_SELECT_RESULT *res;
 	int			num_primaries = 0;
 	int			num_standbys = 0;
+	char		in_recovery[MAX_NUM_BACKENDS];
 	int			i,
 				j;
 	BackendInfo *backend_info;
 
+	get_recovery_status_of_all_nodes(slots, in_recovery);
+
 	for (i = 0; i < NUM_BACKENDS; i++)
 	{
 		pool_node_status[i] = POOL_NODE_STATUS_UNUSED;
 
-		if (!VALID_BACKEND(i))
-			continue;
-
-		if (!slots[i])
-			continue;
-
-		if (get_query_result(slots, i, "SELECT pg_is_in_recovery()", &res))
-		{
-			continue;
-		}
-
-		get_server_version(slots, i);
-
-		if (res->data[0] && !strcmp(res->data[0], "t"))
+		if (in_recovery[i] == 't')
 		{
 			/* Possibly standby */
 			pool_node_status[i] = POOL_NODE_STATUS_STANDBY;
 			num_standbys++;
 		}
-		else if (res->data[0] && !strcmp(res->data[0], "f"))
+		else if (in_recovery[i] == 'f')
 		{
 			/* Possibly primary */
 			pool_node_status[i] = POOL_NODE_STATUS_PRIMARY;
 			num_primaries++;
 		}
-		free_select_result(res);
 	}
 
 	/*
@@ -3249,7 +3487,8 @@ verify_backend_node_status(POOL_CONNECTION_POOL_SLOT * *slots)
 		 */
 		for (i = 0; i < NUM_BACKENDS; i++)
 		{
-			if (!VALID_BACKEND(i))
+			/* the connection may have been discarded by the check above */
+			if (!VALID_BACKEND(i) || !slots[i])
 				continue;
 
 			if (get_server_version(slots, i) >= 90600)
@@ -3390,6 +3629,217 @@ pool_get_node_status(void)
 	return pool_node_status;
 }
 
+/*
+ * Send pg_is_in_recovery() to all the backends at once, then collect the
+ * replies under a single deadline of connect_timeout, so that the time to
+ * verify the backends does not grow with the number of backends.
+ * in_recovery[i] is set to 't' or 'f', or '\0' if backend i did not answer.
+ * The connection to a backend which failed or did not answer in time is
+ * out of sync, so it is discarded and slots[i] is set to NULL. The server
+ * version is asked in the same query and cached for get_server_version().
+ */
+static void
+get_recovery_status_of_all_nodes(POOL_CONNECTION_POOL_SLOT * *slots, char *in_recovery)
+{
+	static char query[] = "SELECT pg_is_in_recovery(), current_setting('server_version_num')";
+	MemoryContext oldContext = CurrentMemoryContext;
+	bool		pending[MAX_NUM_BACKENDS];
+	int			num_pending = 0;
+	struct timeval start;
+	int			i;
+
+	for (i = 0; i < NUM_BACKENDS; i++)
+	{
+		in_recovery[i] = '\0';
+		pending[i] = false;
+
+		if (!VALID_BACKEND(i) || !slots[i])
+			continue;
+
+		pending[i] = true;
+
+		PG_TRY();
+		{
+			int			len = htonl(sizeof(len) + sizeof(query));
+
+			pool_write(slots[i]->con, "Q", 1);
+			pool_write(slots[i]->con, &len, sizeof(len));
+			pool_write_and_flush(slots[i]->con, query, sizeof(query));
+		}
+		PG_CATCH();
+		{
+			MemoryContextSwitchTo(oldContext);
+			FlushErrorState();
+			ereport(LOG,
+					(errmsg("verify_backend_node_status: failed to send query to node %d", i)));
+			pending[i] = false;
+		}
+		PG_END_TRY();
+
+		if (pending[i])
+			num_pending++;
+		else
+		{
+			discard_persistent_db_connection(slots[i]);
+			slots[i] = NULL;
+		}
+	}
+
+	gettimeofday(&start, NULL);
+
+	while (num_pending > 0)
+	{
+		struct timeval timeout;
+		struct timeval *tm = NULL;
+		fd_set		rset;
+		int			maxfd = -1;
+		int			sts;
+
+		if (pool_config->connect_timeout > 0)
+		{
+			struct timeval now;
+			long		remaining;
+
+			gettimeofday(&now, NULL);
+			remaining = pool_config->connect_timeout -
+				((now.tv_sec - start.tv_sec) * 1000 + (now.tv_usec - start.tv_usec) / 1000);
+			if (remaining <= 0)
+				break;
+			timeout.tv_sec = remaining / 1000;
+			timeout.tv_usec = (remaining % 1000) * 1000;
+			tm = &timeout;
+		}
+
+		FD_ZERO(&rset);
+		for (i = 0; i < NUM_BACKENDS; i++)
+		{
+			if (!pending[i])
+				continue;
+			FD_SET(slots[i]->con->fd, &rset);
+			if (slots[i]->con->fd > maxfd)
+				maxfd = slots[i]->con->fd;
+		}
+
+		sts = select(maxfd + 1, &rset, NULL, NULL, tm);
+		if (sts < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			ereport(LOG,
+					(errmsg("verify_backend_node_status: select() failed"),
+					 errdetail("%m")));
+			break;
+		}
+		if (sts == 0)
+			break;				/* timed out */
+
+		for (i = 0; i < NUM_BACKENDS; i++)
+		{
+			if (!pending[i] || !FD_ISSET(slots[i]->con->fd, &rset))
+				continue;
+
+			pending[i] = false;
+			num_pending--;
+
+			/* the reply is short, so read it to the end at once */
+			if (!read_recovery_status(slots[i], i, &in_recovery[i]))
+			{
+				discard_persistent_db_connection(slots[i]);
+				slots[i] = NULL;
+			}
+		}
+	}
+
+	for (i = 0; i < NUM_BACKENDS; i++)
+	{
+		if (pending[i])
+		{
+			ereport(LOG,
+					(errmsg("verify_backend_node_status: node %d did not reply to pg_is_in_recovery() in time", i)));
+			discard_persistent_db_connection(slots[i]);
+			slots[i] = NULL;
+		}
+	}
+}
+
+/*
+ * Read the reply to the query sent by get_recovery_status_of_all_nodes()
+ * up to Ready for query. Returns false if the reply could not be read.
+ * This function must not throw ERROR or FATAL.
+ */
+static bool
+read_recovery_status(POOL_CONNECTION_POOL_SLOT * slot, int node_id, char *in_recovery)
+{
+	MemoryContext oldContext = CurrentMemoryContext;
+	bool		result = true;
+
+	PG_TRY();
+	{
+		char		value = '\0';
+
+		for (;;)
+		{
+			char		kind;
+			int			len;
+			char	   *p = NULL;
+
+			pool_read(slot->con, &kind, sizeof(kind));
+			pool_read(slot->con, &len, sizeof(len));
+			len = ntohl(len) - sizeof(len);
+			if (len > 0)
+				p = pool_read2(slot->con, len);
+
+			if (kind == 'Z')
+				break;
+
+			if (kind == 'E')
+			{
+				ereport(LOG,
+						(errmsg("verify_backend_node_status: pg_is_in_recovery() failed on node %d", node_id)));
+				value = '\0';
+			}
+			else if (kind == 'D' && len >= (int) (sizeof(int16) + sizeof(int32) * 2 + 1))
+			{
+				int16		num_fields;
+				int32		collen;
+				char		version[16];
+
+				memcpy(&num_fields, p, sizeof(num_fields));
+				p += sizeof(num_fields);
+				memcpy(&collen, p, sizeof(collen));
+				p += sizeof(collen);
+				if (ntohs(num_fields) != 2 || ntohl(collen) != 1)
+					continue;
+				value = *p++;
+
+				memcpy(&collen, p, sizeof(collen));
+				p += sizeof(collen);
+				collen = ntohl(collen);
+				if (server_versions[node_id] == 0 && collen > 0 &&
+					collen < (int) sizeof(version) &&
+					collen <= len - (int) (sizeof(int16) + sizeof(int32) * 2 + 1))
+				{
+					memcpy(version, p, collen);
+					version[collen] = '\0';
+					server_versions[node_id] = atoi(version);
+				}
+			}
+		}
+		*in_recovery = value;
+	}
+	PG_CATCH();
+	{
+		MemoryContextSwitchTo(oldContext);
+		FlushErrorState();
+		ereport(LOG,
+				(errmsg("verify_backend_node_status: failed to read reply from node %d", node_id)));
+		result = false;
+	}
+	PG_END_TRY();
+
+	return result;
+}
+
 /*
  * Find the primary node (i.e. not standby node) and returns its node
  * id. If no primary node is found, returns -1.
@@ -3397,7 +3847,6 @@ pool_get_node_status(void)
 static int
 find_primary_node(void)
 {
-	BackendInfo *bkinfo;
 	POOL_CONNECTION_POOL_SLOT *slots[MAX_NUM_BACKENDS];
 	int			i;
 	POOL_NODE_STATUS *status;
@@ -3434,26 +3883,20 @@ find_primary_node(void)
 											   pool_config->sr_check_password);
 
 	/*
-	 * Establish connections to backend
+	 * Establish connections to all the backends at once so that the time to
+	 * find the primary does not grow with the number of backends.
 	 */
+	make_persistent_db_connections_noerror(slots,
+										   pool_config->sr_check_database,
+										   pool_config->sr_check_user,
+										   password ? password : "");
+
 	for (i = 0; i < NUM_BACKENDS; i++)
 	{
-		slots[i] = NULL;
-
-		if (!VALID_BACKEND(i))
-			continue;
-
-		bkinfo = pool_get_node_info(i);
-
-		slots[i] = make_persistent_db_connection_noerror(i, bkinfo->backend_hostname,
-														 bkinfo->backend_port,
-														 pool_config->sr_check_database,
-														 pool_config->sr_check_user,
-														 password ? password : "", true);
-		if (!slots[i])
+		if (VALID_BACKEND(i) && !slots[i])
 		{
 			ereport(LOG,
-					(errmsg("find_primary_node: make_persistent_db_connection_noerror failed on node %d", i)));
+					(errmsg("find_primary_node: make_persistent_db_connections_noerror failed on node %d", i)));
 		}
 	}
 
@@ -3497,7 +3940,7 @@ find_primary_node(void)
 static int
 find_primary_node_repeatedly(void)
 {
-	int			sec;
+	time_t		deadline;
 	int			node_id = -1;
 	int			i;
 
@@ -3532,21 +3975,63 @@ find_primary_node_repeatedly(void)
 	/*
 	 * Try to find the new primary node and keep trying for
 	 * search_primary_node_timeout seconds. search_primary_node_timeout = 0
-	 * means never timeout and keep searching indefinitely
+	 * means never timeout and keep searching indefinitely. The time spent
+	 * in connecting to and querying the backends counts toward the timeout
+	 * as well as the sleeps between the attempts.
 	 */
 	ereport(LOG,
 			(errmsg("find_primary_node_repeatedly: waiting for finding a primary node")));
-	for (sec = 0; (pool_config->search_primary_node_timeout == 0 ||
-				   sec < pool_config->search_primary_node_timeout); sec++)
+	deadline = time(NULL) + pool_config->search_primary_node_timeout;
+	for (;;)
 	{
 		node_id = find_primary_node();
 		if (node_id != -1)
 			break;
+		if (pool_config->search_primary_node_timeout > 0 &&
+			time(NULL) + 1 > deadline)
+			break;
 		pool_sleep(1);
 	}
 	return node_id;
 }
 
+/*
+ * Return true if a session of the child process depends on one of the nodes
+ * flagged in the nodes array. In streaming replication mode a session only
+ * depends on its load balance node (and the primary node, which is checked
+ * by the caller) since the child detaches the other failed nodes from the
+ * session by itself. In other modes any session connected to the nodes
+ * depends on them.
+ */
+static bool
+child_uses_nodes(int child_id, int *nodes)
+{
+	int			i,
+				j;
+
+	for (i = 0; i < pool_config->max_pool; i++)
+	{
+		for (j = 0; j < NUM_BACKENDS; j++)
+		{
+			ConnectionInfo *con = pool_coninfo(child_id, i, j);
+
+			if (!con->connected)
+				continue;
+
+			if (SL_MODE)
+			{
+				if (con->load_balancing_node >= 0 &&
+					con->load_balancing_node < MAX_NUM_BACKENDS &&
+					nodes[con->load_balancing_node])
+					return true;
+			}
+			else if (nodes[j])
+				return true;
+		}
+	}
+	return false;
+}
+
 /*
 * fork a follow child
 */
@@ -3555,6 +4040,7 @@ fork_follow_child(int old_master, int new_primary, int old_primary)
 {
 	pid_t		pid;
 	int			i;
+	int			running = 0;
 
 	pid = fork();
 
@@ -3565,14 +4051,63 @@ fork_follow_child(int old_master, int new_primary, int old_primary)
 
 		ereport(LOG,
 				(errmsg("start triggering follow command.")));
+
+		/* we wait for the command processes by ourselves */
+		pool_signal(SIGCHLD, SIG_DFL);
+
 		for (i = 0; i < pool_config->backend_desc->num_backends; i++)
 		{
 			BackendInfo *bkinfo;
 
 			bkinfo = pool_get_node_info(i);
-			if (bkinfo->backend_status == CON_DOWN)
+			if (bkinfo->backend_status != CON_DOWN)
+				continue;
+
+			if (pool_config->follow_master_parallelism <= 1)
+			{
+				trigger_failover_command(i, pool_config->follow_master_command,
+										 old_master, new_primary, old_primary);
+				continue;
+			}
+
+			/*
+			 * Run the command for multiple nodes concurrently, but not more
+			 * than follow_master_parallelism at a time.
+			 */
+			while (running >= pool_config->follow_master_parallelism)
+			{
+				if (wait(NULL) > 0)
+					running--;
+				else if (errno != EINTR)
+					running = 0;
+			}
+
+			pid = fork();
+			if (pid == 0)
+			{
+				trigger_failover_command(i, pool_config->follow_master_command,
+										 old_master, new_primary, old_primary);
+				exit(0);
+			}
+			else if (pid == -1)
+			{
+				ereport(WARNING,
+						(errmsg("follow fork() failed with reason: \"%s\"", strerror(errno)),
+						 errdetail("executing follow master command for node %d sequentially", i)));
 				trigger_failover_command(i, pool_config->follow_master_command,
 										 old_master, new_primary, old_primary);
+			}
+			else
+				running++;
+		}
+
+		/* wait for all the follow master commands to finish */
+		while (running > 0)
+		{
+			if (wait(NULL) > 0)
+				running--;
+			else if (errno != EINTR)
+				break;
 		}
 		exit(0);
 	}
@@ -3603,7 +4138,6 @@ initialize_shared_mem_objects(bool clear_memcache_oidmaps)
 	 */
 	size = pool_coninfo_size();
 	con_info = pool_shared_memory_create(size);
-	memset(con_info, 0, size);
 
 	size = pool_config->num_init_children * (sizeof(ProcessInfo));
 
@@ -3614,7 +4148,6 @@ initialize_shared_mem_objects(bool clear_memcache_oidmaps)
 					size)));
 
 	process_info = pool_shared_memory_create(size);
-	memset(process_info, 0, size);
 
 	for (i = 0; i < pool_config->num_init_children; i++)
 	{
@@ -3652,10 +4185,21 @@ initialize_shared_mem_objects(bool clear_memcache_oidmaps)
 			(errmsg("Recovery management area: sizeof(int) %zu bytes requested for shared memory",
 					sizeof(int))));
 
+	size = MAX_NUM_BACKENDS * sizeof(ReplicationLagHistory);
+	replication_lag_history = pool_shared_memory_create(size);
+
+	size = MAX_NUM_BACKENDS * sizeof(HealthCheckStats);
+	health_check_stats = pool_shared_memory_create(size);
+
+	size = STARTUP_PACKET_STATS_SIZE * sizeof(StartupPacketStat);
+	startup_packet_stats = pool_shared_memory_create(size);
+
+	prewarm_startup_limit = pool_shared_memory_create(sizeof(PrewarmStartupLimit));
+
 	/*
 	 * Initialize shared memory cache
 	 */
-	if (pool_config->memory_cache_enabled || pool_config->enable_shared_relcache)
+	if (pool_config->memory_cache_enabled)
 	{
 		if (pool_is_shmem_cache())
 		{
@@ -3674,12 +4218,25 @@ initialize_shared_mem_objects(bool clear_memcache_oidmaps)
 
 			pool_allocate_fsmm_clock_hand();
 
+			size = pool_shared_memory_table_generation_size();
+			pool_init_table_generation(size);
+
+			size = pool_shared_memory_frequency_sketch_size();
+			pool_init_frequency_sketch(size);
+
 			pool_discard_oid_maps();
 
 			ereport(LOG,
 					(errmsg("pool_discard_oid_maps: discarded memqcache oid maps")));
 
 			pool_hash_init(pool_config->memqcache_max_num_cache);
+
+			/*
+			 * Query cache saved at the last shutdown is restored by the
+			 * loader process after children are forked.
+			 */
+			if (pool_config->memory_cache_enabled)
+				memqcache_snapshot_pending = pool_prepare_memqcache_snapshot(clear_memcache_oidmaps);
 		}
 
 #ifdef USE_MEMCACHED
@@ -3702,6 +4259,10 @@ initialize_shared_mem_objects(bool clear_memcache_oidmaps)
 		pool_init_memqcache_stats();
 	}
 
+	/* Initialize shared relation cache */
+	if (pool_config->enable_shared_relcache)
+		pool_init_shared_relcache();
+
 	/* Initialize statistics area */
 	stat_set_stat_area(pool_shared_memory_create(stat_shared_memory_size()));
 	stat_init_stat_area();
@@ -4029,6 +4590,10 @@ system_will_go_down(int code, Datum arg)
 	if (processState != EXITING)
 		terminate_all_childrens();
 	processState = EXITING;
+
+	/* Save query cache now that no child can touch it */
+	if (pool_config->memory_cache_enabled && pool_is_shmem_cache())
+		pool_save_memqcache_snapshot();
 	POOL_SETMASK(&UnBlockSig);
 
 }
@@ -4371,17 +4936,16 @@ sync_backend_from_watchdog(void)
 
 /*
  * Obtain backend server version number and cache it.  Note that returned
- * version number is in the static memory area.
+ * version number is in the static memory area.  Returns 0 if it's not
+ * known and there's no connection to the backend.
  */
 static int
 get_server_version(POOL_CONNECTION_POOL_SLOT * *slots, int node_id)
 {
-	static int	server_versions[MAX_NUM_BACKENDS];
-
 	char	   *query;
 	POOL_SELECT_RESULT *res;
 
-	if (server_versions[node_id] == 0)
+	if (server_versions[node_id] == 0 && slots[node_id])
 	{
 		query = "SELECT current_setting('server_version_num')";
 
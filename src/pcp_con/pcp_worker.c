@@ -822,9 +822,12 @@ inform_node_info(PCP_CONNECTION * frontend, char *buf)
 	char		role_str[10];
 	char		standby_delay_str[20];
 	char		status_changed_time_str[20];
+	char		health_check_latency_str[20];
+	char		health_check_jitter_str[20];
 	char		code[] = "CommandComplete";
 	BackendInfo *bi = NULL;
 	SERVER_ROLE role;
+	HealthCheckStatsSummary summary;
 
 	node_id = atoi(buf);
 
@@ -863,6 +866,10 @@ inform_node_info(PCP_CONNECTION * frontend, char *buf)
 
 	snprintf(status_changed_time_str, sizeof(status_changed_time_str), UINT64_FORMAT, bi->status_changed_time);
 
+	health_check_stats_summary(node_id, &summary);
+	snprintf(health_check_latency_str, sizeof(health_check_latency_str), INT64_FORMAT, summary.p99);
+	snprintf(health_check_jitter_str, sizeof(health_check_jitter_str), INT64_FORMAT, summary.jitter);
+
 	pcp_write(frontend, "i", 1);
 	wsize = htonl(sizeof(code) +
 				  strlen(bi->backend_hostname) + 1 +
@@ -874,6 +881,8 @@ inform_node_info(PCP_CONNECTION * frontend, char *buf)
 				  strlen(bi->replication_state) + 1 +
 				  strlen(bi->replication_sync_state) + 1 +
 				  strlen(status_changed_time_str) + 1 +
+				  strlen(health_check_latency_str) + 1 +
+				  strlen(health_check_jitter_str) + 1 +
 				  sizeof(int));
 	pcp_write(frontend, &wsize, sizeof(int));
 	pcp_write(frontend, code, sizeof(code));
@@ -886,6 +895,8 @@ inform_node_info(PCP_CONNECTION * frontend, char *buf)
 	pcp_write(frontend, bi->replication_state, strlen(bi->replication_state) + 1);
 	pcp_write(frontend, bi->replication_sync_state, strlen(bi->replication_sync_state) + 1);
 	pcp_write(frontend, status_changed_time_str, strlen(status_changed_time_str) + 1);
+	pcp_write(frontend, health_check_latency_str, strlen(health_check_latency_str) + 1);
+	pcp_write(frontend, health_check_jitter_str, strlen(health_check_jitter_str) + 1);
 
 	do_pcp_flush(frontend);
 }
@@ -24,6 +24,7 @@
  * "CommandComplete".
  *---------------------------------------------------------------------
  */
+#include <stdlib.h>
 #include <string.h>
 #include <arpa/inet.h>
 
@@ -38,8 +39,11 @@
 #include "utils/palloc.h"
 #include "utils/memutils.h"
 #include "utils/pool_stream.h"
+#include "utils/pool_relcache.h"
+#include "utils/pool_select_walker.h"
 
 static int	extract_ntuples(char *message);
+static void record_query_cost(POOL_QUERY_CONTEXT * query_context, char *message, int len);
 static POOL_STATUS handle_mismatch_tuples(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend, char *packet, int packetlen, bool command_complete);
 static int	foward_command_complete(POOL_CONNECTION * frontend, char *packet, int packetlen);
 static int	foward_empty_query(POOL_CONNECTION * frontend, char *packet, int packetlen);
@@ -200,6 +204,11 @@ CommandComplete(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend, bool
 		}
 	}
 
+	/* Record cost of SELECT for routing heavy queries */
+	if ((pool_config->heavy_query_time_threshold > 0 || pool_config->heavy_query_rows_threshold > 0) &&
+		command_complete && session_context->query_context)
+		record_query_cost(session_context->query_context, p1, len1);
+
 	pfree(p1);
 
 	if (pool_is_doing_extended_query_message() && pool_is_query_in_progress())
@@ -393,6 +402,37 @@ handle_query_context(POOL_CONNECTION_POOL * backend)
 			}
 		}
 	}
+
+	/* Reload IMMUTABLE function map if function definition is changed */
+	if (pool_is_function_ddl(node))
+		pool_discard_immutable_function_maps();
+
+	/*
+	 * Invalidate shared relation cache entries of the objects modified by
+	 * DDL.
+	 */
+	if (pool_config->enable_shared_relcache)
+		pool_shared_relcache_handle_stmt(backend, node);
+}
+
+/*
+ * Record execution time and number of rows of SELECT
+ */
+static void
+record_query_cost(POOL_QUERY_CONTEXT * query_context, char *message, int len)
+{
+	struct timeval now;
+	double		elapsed;
+
+	if (len < 8 || strncmp(message, "SELECT ", 7) || query_context->original_query == NULL)
+		return;
+
+	gettimeofday(&now, NULL);
+	elapsed = (now.tv_sec - query_context->start_time.tv_sec) * 1000000.0 +
+		(now.tv_usec - query_context->start_time.tv_usec);
+
+	stat_record_query_cost(stat_query_fingerprint(query_context->original_query),
+						   elapsed, strtoull(message + 7, NULL, 10));
 }
 
 /*
@@ -42,6 +42,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <fcntl.h>
 #include <sys/time.h>
 
 #include "pool.h"
@@ -86,9 +87,17 @@ static StartupPacket *StartupPacketCopy(StartupPacket *sp);
 static void print_process_status(char *remote_host, char *remote_port);
 static bool backend_cleanup(POOL_CONNECTION * volatile *frontend, POOL_CONNECTION_POOL * volatile backend, bool frontend_invalid);
 static void free_persisten_db_connection_memory(POOL_CONNECTION_POOL_SLOT * cp);
+static POOL_CONNECTION_POOL_SLOT * start_persistent_db_connection(int db_node_id, char *hostname, int port, char *dbname, char *user, bool retry, int fd);
 static int	choose_db_node_id(char *str);
 static void child_will_go_down(int code, Datum arg);
 static int opt_sort(const void *a, const void *b);
+static double load_balance_weight(int node_id);
+static int	weighted_random_node(double *weights, double total_weight);
+static double node_load(int node_id, double weight);
+static int	select_load_balancing_node_internal(bool by_cost, bool heavy);
+static bool prewarm_backend_connections(bool startup);
+static bool client_is_waiting(void);
+static bool prewarm_possible(StartupPacketStat * stat);
 
 /*
  * Non 0 means SIGTERM (smart shutdown) or SIGINT (fast shutdown) has arrived
@@ -138,6 +147,8 @@ do_child(int *fds)
 	static int	connected = 0;	/* non 0 if has been accepted connections from
 								 * frontend */
 	int			connections_count = 0;	/* used if child_max_connections > 0 */
+	static bool prewarm_pending = true; /* true if connections should be
+										 * prewarmed before next accept */
 	char		psbuf[NI_MAXHOST + 128];
 
 	ereport(DEBUG2,
@@ -300,6 +311,9 @@ do_child(int *fds)
 		backend = NULL;
 		idle = 1;
 
+		/* Forget queries possibly aborted in the previous session */
+		stat_reset_outstanding_queries();
+
 		/* pgpool stop request already sent? */
 		check_stop_request();
 		check_restart_request();
@@ -307,7 +321,20 @@ do_child(int *fds)
 		/* Destroy session context for just in case... */
 		pool_session_context_destroy();
 
-		front_end_fd = wait_for_new_connections(fds, &timeout, &saddr);
+		/* open frequently used connections while nobody is waiting */
+		if (prewarm_pending)
+			prewarm_pending = !prewarm_backend_connections(!connected);
+
+		pool_get_my_process_info()->wait_for_connect = 1;
+		if (prewarm_pending)
+		{
+			/* prewarming was deferred, retry it a second later */
+			struct timeval retry = {1, 0};
+
+			front_end_fd = wait_for_new_connections(fds, &retry, &saddr);
+		}
+		else
+			front_end_fd = wait_for_new_connections(fds, &timeout, &saddr);
 		if (front_end_fd == OPERATION_TIMEOUT)
 		{
 			if (pool_config->child_life_time > 0 && connected)
@@ -322,6 +349,8 @@ do_child(int *fds)
 		if (front_end_fd == RETRY)
 			continue;
 
+		pool_get_my_process_info()->wait_for_connect = 0;
+
 		/*
 		 * Check if max connections from clients execeeded.
 		 */
@@ -375,6 +404,10 @@ do_child(int *fds)
 			continue;
 		}
 		connected = 1;
+		prewarm_pending = true;
+
+		/* remember the startup packet for prewarming connections */
+		pool_record_startup_packet(backend);
 
 		/*
 		 * show ps status
@@ -966,6 +999,7 @@ static POOL_CONNECTION_POOL * connect_backend(StartupPacket *sp, POOL_CONNECTION
 {
 	POOL_CONNECTION_POOL *backend;
 	StartupPacket *topmem_sp;
+	bool		ssl_requested[MAX_NUM_BACKENDS];
 	int			i;
 
 	/* connect to the backend */
@@ -988,6 +1022,12 @@ static POOL_CONNECTION_POOL * connect_backend(StartupPacket *sp, POOL_CONNECTION
 		topmem_sp = StartupPacketCopy(sp);
 		MemoryContextSwitchTo(oldContext);
 
+		/*
+		 * Send SSL requests to all backends first so that the round trips
+		 * for the answers overlap. The SSL handshakes themselves and the
+		 * authentication in pool_do_auth() are still done one backend after
+		 * another.
+		 */
 		for (i = 0; i < NUM_BACKENDS; i++)
 		{
 			if (VALID_BACKEND(i))
@@ -999,7 +1039,16 @@ static POOL_CONNECTION_POOL * connect_backend(StartupPacket *sp, POOL_CONNECTION
 				/* mark this is a backend connection */
 				CONNECTION(backend, i)->isbackend = 1;
 
-				pool_ssl_negotiate_clientserver(CONNECTION(backend, i));
+				ssl_requested[i] = pool_ssl_request_clientserver(CONNECTION(backend, i));
+			}
+		}
+
+		for (i = 0; i < NUM_BACKENDS; i++)
+		{
+			if (VALID_BACKEND(i))
+			{
+				if (ssl_requested[i])
+					pool_ssl_complete_clientserver(CONNECTION(backend, i));
 
 				/*
 				 * save startup packet info
@@ -1035,6 +1084,178 @@ static POOL_CONNECTION_POOL * connect_backend(StartupPacket *sp, POOL_CONNECTION
 	return backend;
 }
 
+/*
+ * Open backend connections for the startup packets most frequently used by
+ * clients, so that the next client sending one of them can reuse the
+ * connection. Authentication is done against a dummy frontend, hence only
+ * startup packets whose authentication does not need the client are
+ * prewarmed. Connections are created only in free slots of the connection
+ * pool; existing cached connections are never discarded for this.
+ *
+ * Prewarming stops as soon as a client is waiting for a connection. If
+ * startup is true, i.e. the child has not served any client yet, prewarming
+ * is rate limited by pool_prewarm_startup_allowed() and false is returned
+ * if it has to be retried later.
+ *
+ * Note that a failed backend connection is handled by new_connection() as
+ * for a client: it may trigger failover if failover_on_backend_error is on,
+ * and the child exits with FATAL, which is not caught here.
+ */
+static bool
+prewarm_backend_connections(bool startup)
+{
+	StartupPacketStat *stats;
+	int			num_stats;
+	int			max;
+	volatile int prewarmed = 0;
+	int			i;
+
+	if (pool_config->prewarm_connections <= 0)
+		return true;
+
+	max = Min(pool_config->prewarm_connections, pool_config->max_pool);
+
+	stats = palloc(sizeof(StartupPacketStat) * STARTUP_PACKET_STATS_SIZE);
+	num_stats = pool_get_frequent_startup_packets(stats, max);
+
+	if (num_stats > 0 && startup && !pool_prewarm_startup_allowed())
+	{
+		pfree(stats);
+		return false;
+	}
+
+	for (i = 0; i < num_stats; i++)
+	{
+		StartupPacket *sp;
+		POOL_CONNECTION *frontend;
+		POOL_CONNECTION_POOL *backend;
+		int			free_slots = 0;
+		int			fd;
+		int			j;
+
+		if (pool_get_cp(stats[i].user, stats[i].database, PROTO_MAJOR_V3, 1))
+			continue;
+
+		if (!prewarm_possible(&stats[i]))
+			continue;
+
+		if (client_is_waiting())
+		{
+			ereport(DEBUG1,
+					(errmsg("stop prewarming backend connections"),
+					 errdetail("a client is waiting for connection")));
+			break;
+		}
+
+		for (j = 0; j < pool_config->max_pool; j++)
+		{
+			if (MASTER_CONNECTION(&pool_connection_pool[j]) == NULL)
+				free_slots++;
+		}
+		if (free_slots == 0)
+			break;
+
+		fd = open("/dev/null", O_RDWR);
+		if (fd < 0)
+		{
+			ereport(LOG,
+					(errmsg("unable to prewarm backend connections"),
+					 errdetail("open(\"/dev/null\") failed with error: \"%s\"", strerror(errno))));
+			break;
+		}
+
+		sp = palloc0(sizeof(*sp));
+		sp->startup_packet = palloc(stats[i].len);
+		memcpy(sp->startup_packet, stats[i].packet, stats[i].len);
+		sp->len = stats[i].len;
+		sp->major = PROTO_MAJOR_V3;
+		sp->minor = 0;
+		sp->user = pstrdup(stats[i].user);
+		sp->database = pstrdup(stats[i].database);
+		if (stats[i].application_name >= 0)
+			sp->application_name = sp->startup_packet + stats[i].application_name;
+
+		frontend = pool_open(fd, false);
+		frontend->protoVersion = PROTO_MAJOR_V3;
+		frontend->username = sp->user;
+		frontend->frontend_authenticated = true;
+
+		PG_TRY();
+		{
+			backend = connect_backend(sp, frontend);
+			pool_connection_pool_timer(backend);
+			prewarmed++;
+
+			ereport(DEBUG1,
+					(errmsg("prewarmed backend connection"),
+					 errdetail("user: \"%s\" database: \"%s\"", sp->user, sp->database)));
+		}
+		PG_CATCH();
+		{
+			/* the connection pool is already discarded by connect_backend */
+			EmitErrorReport();
+			FlushErrorState();
+		}
+		PG_END_TRY();
+
+		pool_close(frontend);
+		pool_free_startup_packet(sp);
+	}
+
+	pfree(stats);
+
+	if (prewarmed > 0)
+		ereport(DEBUG1,
+				(errmsg("prewarmed %d backend connections", prewarmed)));
+
+	return true;
+}
+
+/*
+ * Return true if a client is waiting to be accepted on any of the listen
+ * sockets. The client may be accepted by another child.
+ */
+static bool
+client_is_waiting(void)
+{
+	fd_set		rmask;
+	struct timeval t = {0, 0};
+
+	memcpy((char *) &rmask, (char *) &readmask, sizeof(fd_set));
+
+	return select(nsocks, &rmask, NULL, NULL, &t) > 0;
+}
+
+/*
+ * Return true if the connection for the startup packet can be authenticated
+ * without the client. The backend must trust the user, or pool_passwd must
+ * have the password of the user for the authentication method which
+ * Pgpool-II can do on behalf of the client.
+ */
+static bool
+prewarm_possible(StartupPacketStat * stat)
+{
+	switch (stat->auth_kind)
+	{
+		case AUTH_REQ_OK:
+			return true;
+
+		case AUTH_REQ_MD5:
+			if (RAW_MODE || NUM_BACKENDS == 1)
+				return false;
+			/* fall through */
+
+		case AUTH_REQ_PASSWORD:
+		case AUTH_REQ_SASL:
+			if (!strcmp("", pool_config->pool_passwd))
+				return false;
+			return pool_get_passwd(stat->user) != NULL;
+
+		default:
+			return false;
+	}
+}
+
 /*
  * signal handler for SIGTERM, SIGINT and SIGQUUT
  */
@@ -1286,7 +1507,9 @@ child_will_go_down(int code, Datum arg)
 	if (accepted)
 		connection_count_down();
 
-	if ((pool_config->memory_cache_enabled || pool_config->enable_shared_relcache)
+	stat_reset_outstanding_queries();
+
+	if (pool_config->memory_cache_enabled
 		&& !pool_is_shmem_cache())
 	{
 		memcached_disconnect();
@@ -1324,7 +1547,34 @@ make_persistent_db_connection(
 							  int db_node_id, char *hostname, int port, char *dbname, char *user, char *password, bool retry)
 {
 	POOL_CONNECTION_POOL_SLOT *cp;
-	int			fd;
+
+	cp = start_persistent_db_connection(db_node_id, hostname, port, dbname, user, retry, -1);
+
+	PG_TRY();
+	{
+		connection_do_auth(cp, password);
+	}
+	PG_CATCH();
+	{
+		pool_close(cp->con);
+		free_persisten_db_connection_memory(cp);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	return cp;
+}
+
+/*
+ * Connect to the backend and send the startup packet of a persistent
+ * connection. If fd is not -1, it is a socket already connected to the
+ * backend, or POOL_CONNECT_FAILED if connecting in parallel failed, which
+ * is not retried. The authentication is left to the caller.
+ */
+static POOL_CONNECTION_POOL_SLOT *
+start_persistent_db_connection(int db_node_id, char *hostname, int port, char *dbname, char *user, bool retry, int fd)
+{
+	POOL_CONNECTION_POOL_SLOT *cp;
 
 #define MAX_USER_AND_DATABASE	1024
 
@@ -1347,7 +1597,9 @@ make_persistent_db_connection(
 	/*
 	 * create socket
 	 */
-	if (*hostname == '/')
+	if (fd != -1)
+		;
+	else if (*hostname == '/')
 	{
 		fd = connect_unix_domain_socket_by_port(port, hostname, retry);
 	}
@@ -1428,7 +1680,6 @@ make_persistent_db_connection(
 	PG_TRY();
 	{
 		send_startup_packet(cp);
-		connection_do_auth(cp, password);
 	}
 	PG_CATCH();
 	{
@@ -1472,6 +1723,97 @@ make_persistent_db_connection_noerror(
 	return slot;
 }
 
+/*
+ * Create persistent connections to all the valid backends concurrently.
+ * The sockets are connected at once. Then each step of the authentication
+ * is sent to all the backends before reading any reply: the startup
+ * packets, then the passwords. So the round trips to the backends overlap.
+ * slots[i] is set to NULL if backend i is not valid or the connection
+ * failed. Errors are not reported like
+ * make_persistent_db_connection_noerror().
+ */
+void
+make_persistent_db_connections_noerror(POOL_CONNECTION_POOL_SLOT * *slots, char *dbname, char *user, char *password)
+{
+	MemoryContext oldContext = CurrentMemoryContext;
+	int			fds[MAX_NUM_BACKENDS];
+	int			auth_kinds[MAX_NUM_BACKENDS];
+	int			i;
+
+	connect_inet_domain_sockets_in_parallel(fds);
+
+	for (i = 0; i < NUM_BACKENDS; i++)
+	{
+		BackendInfo *bkinfo = pool_get_node_info(i);
+
+		slots[i] = NULL;
+
+		if (!VALID_BACKEND(i))
+		{
+			if (fds[i] >= 0)
+				close(fds[i]);
+			continue;
+		}
+
+		PG_TRY();
+		{
+			slots[i] = start_persistent_db_connection(i, bkinfo->backend_hostname,
+													  bkinfo->backend_port,
+													  dbname, user, true, fds[i]);
+		}
+		PG_CATCH();
+		{
+			EmitErrorReport();
+			MemoryContextSwitchTo(oldContext);
+			FlushErrorState();
+			slots[i] = NULL;
+		}
+		PG_END_TRY();
+	}
+
+	for (i = 0; i < NUM_BACKENDS; i++)
+	{
+		if (!slots[i])
+			continue;
+
+		PG_TRY();
+		{
+			auth_kinds[i] = connection_start_auth(slots[i], password);
+		}
+		PG_CATCH();
+		{
+			EmitErrorReport();
+			MemoryContextSwitchTo(oldContext);
+			FlushErrorState();
+			pool_close(slots[i]->con);
+			free_persisten_db_connection_memory(slots[i]);
+			slots[i] = NULL;
+		}
+		PG_END_TRY();
+	}
+
+	for (i = 0; i < NUM_BACKENDS; i++)
+	{
+		if (!slots[i])
+			continue;
+
+		PG_TRY();
+		{
+			connection_finish_auth(slots[i], auth_kinds[i]);
+		}
+		PG_CATCH();
+		{
+			EmitErrorReport();
+			MemoryContextSwitchTo(oldContext);
+			FlushErrorState();
+			pool_close(slots[i]->con);
+			free_persisten_db_connection_memory(slots[i]);
+			slots[i] = NULL;
+		}
+		PG_END_TRY();
+	}
+}
+
 /*
  * Free memory of POOL_CONNECTION_POOL_SLOT.  Should only be used in
  * make_persistent_db_connection and discard_persistent_db_connection.
@@ -1580,6 +1922,82 @@ static RETSIGTYPE wakeup_handler(int sig)
 }
 
 
+/*
+ * Return the weight of the node used for load balancing. If
+ * delay_weight_scale is set, the weight of a standby decreases gradually
+ * as its replication delay grows: it is halved when the delay reaches
+ * delay_weight_scale, and so on. health_check_latency_weight_scale works
+ * in the same way against the 90th percentile of the recent health check
+ * latency, so that a degrading node gets fewer sessions before it fails.
+ */
+static double
+load_balance_weight(int node_id)
+{
+	BackendInfo *bkinfo = pool_get_node_info(node_id);
+	double		weight = bkinfo->backend_weight;
+
+	if (SL_MODE && pool_config->delay_weight_scale > 0 &&
+		node_id != PRIMARY_NODE_ID && bkinfo->standby_delay > 0)
+		weight = weight * pool_config->delay_weight_scale /
+			((double) pool_config->delay_weight_scale + bkinfo->standby_delay);
+
+	if (pool_config->health_check_latency_weight_scale > 0 && weight > 0.0)
+	{
+		int64		p90 = health_check_stats[node_id].p90;
+
+		if (p90 > 0)
+			weight = weight * pool_config->health_check_latency_weight_scale /
+				(pool_config->health_check_latency_weight_scale + p90 / 1000.0);
+	}
+
+	return weight;
+}
+
+/*
+ * Choose a node in random manner with weight. Returns master node id if
+ * no node has weight.
+ */
+static int
+weighted_random_node(double *weights, double total_weight)
+{
+	int			selected_slot = MASTER_NODE_ID;
+	double		r;
+	int			i;
+
+#if defined(sun) || defined(__sun)
+	r = (((double) rand()) / RAND_MAX) * total_weight;
+#else
+	r = (((double) random()) / RAND_MAX) * total_weight;
+#endif
+
+	total_weight = 0.0;
+	for (i = 0; i < NUM_BACKENDS; i++)
+	{
+		if (weights[i] > 0.0)
+		{
+			if (r >= total_weight)
+				selected_slot = i;
+			else
+				break;
+			total_weight += weights[i];
+		}
+	}
+	return selected_slot;
+}
+
+/*
+ * Return load of the node relative to its weight, estimated from the
+ * number of queries in progress and the average response time of the
+ * node. 1ms is added to the response time so that nodes without any
+ * measurement yet are comparable.
+ */
+static double
+node_load(int node_id, double weight)
+{
+	return (stat_get_outstanding_queries(node_id) + 1) *
+		(stat_get_query_latency(node_id) + 1000.0) / weight;
+}
+
 /*
  * Select load balancing node. This function is called when:
  * 1) client connects
@@ -1587,10 +2005,47 @@ static RETSIGTYPE wakeup_handler(int sig)
  */
 int
 select_load_balancing_node(void)
+{
+	return select_load_balancing_node_internal(false, false);
+}
+
+/*
+ * Select load balancing node for a query. If the query is heavy, choose
+ * among ANALYTICS nodes, otherwise among the other nodes. If there's no
+ * candidate in the class, any node can be chosen.
+ */
+int
+select_load_balancing_node_by_cost(bool heavy)
+{
+	return select_load_balancing_node_internal(true, heavy);
+}
+
+/*
+ * Return true if the node has replayed the last write transaction of the
+ * session, or read_your_writes is not in effect.
+ */
+bool
+node_replayed_session_writes(int node_id)
+{
+	POOL_SESSION_CONTEXT *ses;
+
+	if (!pool_config->read_your_writes || !STREAM || node_id == PRIMARY_NODE_ID)
+		return true;
+
+	ses = pool_get_session_context(true);
+	if (!ses || ses->write_lsn == 0)
+		return true;
+
+	return BACKEND_INFO(node_id).replay_lsn >= ses->write_lsn;
+}
+
+static int
+select_load_balancing_node_internal(bool by_cost, bool heavy)
 {
 	int			selected_slot;
 	double		total_weight,
 				r;
+	double		weights[MAX_NUM_BACKENDS];
 	int			i;
 	int			index_db = -1,
 				index_app = -1;
@@ -1713,47 +2168,121 @@ select_load_balancing_node(void)
 		}
 	}
 
-	/* Choose a backend in random manner with weight */
+	/*
+	 * Choose a backend according to load_balance_policy. Take a snapshot
+	 * of the weights since standby delay may be updated meanwhile.
+	 */
 	selected_slot = MASTER_NODE_ID;
 	total_weight = 0.0;
 
 	for (i = 0; i < NUM_BACKENDS; i++)
 	{
+		weights[i] = 0.0;
+
 		if (VALID_BACKEND_RAW(i))
 		{
 			if (i == no_load_balance_node_id)
 				continue;
-			if (suggested_node_id == -1)
+			if (suggested_node_id == -1 && i == PRIMARY_NODE_ID)
+				continue;
+
+			weights[i] = load_balance_weight(i);
+			total_weight += weights[i];
+		}
+	}
+
+	/* Leave only the nodes of the cost class if any */
+	if (by_cost)
+	{
+		double		class_weight = 0.0;
+
+		for (i = 0; i < NUM_BACKENDS; i++)
+		{
+			if (weights[i] > 0.0 &&
+				((BACKEND_INFO(i).flag & POOL_ANALYTICS) != 0) == heavy)
+				class_weight += weights[i];
+		}
+
+		if (class_weight > 0.0)
+		{
+			for (i = 0; i < NUM_BACKENDS; i++)
 			{
-				if (i != PRIMARY_NODE_ID)
-					total_weight += BACKEND_INFO(i).backend_weight;
+				if (((BACKEND_INFO(i).flag & POOL_ANALYTICS) != 0) != heavy)
+					weights[i] = 0.0;
 			}
-			else
-				total_weight += BACKEND_INFO(i).backend_weight;
+			total_weight = class_weight;
 		}
 	}
 
-#if defined(sun) || defined(__sun)
-	r = (((double) rand()) / RAND_MAX) * total_weight;
-#else
-	r = (((double) random()) / RAND_MAX) * total_weight;
-#endif
+	/*
+	 * Leave only the nodes which have replayed our writes. If there's none,
+	 * the primary has to take the query.
+	 */
+	if (pool_config->read_your_writes)
+	{
+		total_weight = 0.0;
+		for (i = 0; i < NUM_BACKENDS; i++)
+		{
+			if (weights[i] > 0.0 && !node_replayed_session_writes(i))
+				weights[i] = 0.0;
+			total_weight += weights[i];
+		}
 
-	total_weight = 0.0;
-	for (i = 0; i < NUM_BACKENDS; i++)
+		if (total_weight <= 0.0)
+		{
+			ereport(DEBUG1,
+					(errmsg("selecting load balance node"),
+					 errdetail("no node has replayed the writes of the session. selected backend id is %d",
+							   PRIMARY_NODE_ID)));
+			return PRIMARY_NODE_ID;
+		}
+	}
+
+	if (pool_config->load_balance_policy == LBPOLICY_LEAST_LOADED)
 	{
-		if ((suggested_node_id == -1 && i == PRIMARY_NODE_ID) || i == no_load_balance_node_id)
-			continue;
+		double		min_load = 0.0;
+		bool		found = false;
 
-		if (VALID_BACKEND_RAW(i) && BACKEND_INFO(i).backend_weight > 0.0)
+		for (i = 0; i < NUM_BACKENDS; i++)
 		{
-			if (r >= total_weight)
+			double		load;
+
+			if (weights[i] <= 0.0)
+				continue;
+
+			load = node_load(i, weights[i]);
+			if (!found || load < min_load)
+			{
 				selected_slot = i;
-			else
-				break;
-			total_weight += BACKEND_INFO(i).backend_weight;
+				min_load = load;
+				found = true;
+			}
 		}
 	}
+	else if (pool_config->load_balance_policy == LBPOLICY_POWER_OF_TWO)
+	{
+		int			first;
+		int			second;
+		double		weight;
+
+		/* Choose two different nodes and take the less loaded one */
+		first = weighted_random_node(weights, total_weight);
+		weight = weights[first];
+		if (weight > 0.0 && total_weight - weight > 0.0)
+		{
+			weights[first] = 0.0;
+			second = weighted_random_node(weights, total_weight - weight);
+			weights[first] = weight;
+
+			selected_slot = node_load(second, weights[second]) < node_load(first, weight) ?
+				second : first;
+		}
+		else
+			selected_slot = first;
+	}
+	else
+		selected_slot = weighted_random_node(weights, total_weight);
+
 	ereport(DEBUG1,
 			(errmsg("selecting load balance node"),
 			 errdetail("selected backend id is %d", selected_slot)));
@@ -1825,6 +2354,18 @@ check_restart_request(void)
 		pool_get_my_process_info()->need_to_restart = 0;
 		child_exit(POOL_EXIT_AND_RESTART);
 	}
+
+	/*
+	 * Check if pgpool main decided that there are too many idle children. If
+	 * so, exit myself without being restarted.
+	 */
+	if (pool_get_my_process_info()->exit_if_idle)
+	{
+		ereport(DEBUG1,
+				(errmsg("retiring spare child process")));
+
+		child_exit(POOL_EXIT_NO_RESTART);
+	}
 }
 
 /*
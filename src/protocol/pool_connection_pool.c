@@ -56,7 +56,7 @@ volatile sig_atomic_t backend_timer_expired = 0;	/* flag for connection
 													 * closed timer is expired */
 volatile sig_atomic_t health_check_timer_expired;	/* non 0 if health check
 													 * timer expired */
-static POOL_CONNECTION_POOL_SLOT * create_cp(POOL_CONNECTION_POOL_SLOT * cp, int slot);
+static POOL_CONNECTION_POOL_SLOT * create_cp(POOL_CONNECTION_POOL_SLOT * cp, int slot, int fd);
 static POOL_CONNECTION_POOL * new_connection(POOL_CONNECTION_POOL * p);
 static int	check_socket_status(int fd);
 static bool connect_with_timeout(int fd, struct addrinfo *walk, char *host, int port, bool retry);
@@ -817,20 +817,249 @@ connect_inet_domain_socket_by_port(char *host, int port, bool retry)
 }
 
 /*
- * create connection pool
+ * Connect to all the backends using INET domain socket at once, so that
+ * the time to establish connections does not grow with the number of
+ * backends. Connections are started with non blocking connect(2) and
+ * completed in a single select(2) loop limited by connect_timeout.
+ *
+ * fds[i] is set to the connected socket of backend i. It is set to
+ * POOL_CONNECT_FAILED if the connection was refused or timed out, which is
+ * already reported here and must not be retried by the caller. Otherwise
+ * it is -1 and the backend is left to the ordinary
+ * connect_inet_domain_socket() (UNIX domain socket, down, host with
+ * multiple addresses or failed to resolve).
  */
-static POOL_CONNECTION_POOL_SLOT * create_cp(POOL_CONNECTION_POOL_SLOT * cp, int slot)
+void
+connect_inet_domain_sockets_in_parallel(int *fds)
 {
-	BackendInfo *b = &pool_config->backend_desc->backend_info[slot];
-	int			fd;
+	bool		pending[MAX_NUM_BACKENDS];
+	int			num_pending = 0;
+	int			num_candidates = 0;
+	int			on = 1;
+	bool		timed_out = false;
+	struct timeval start;
+	int			i;
 
-	if (*b->backend_hostname == '/')
+	for (i = 0; i < NUM_BACKENDS; i++)
 	{
-		fd = connect_unix_domain_socket(slot, TRUE);
+		fds[i] = -1;
+		pending[i] = false;
+
+		if (!VALID_BACKEND(i) ||
+			(BACKEND_INFO(i).backend_status != CON_UP &&
+			 BACKEND_INFO(i).backend_status != CON_CONNECT_WAIT) ||
+			*BACKEND_INFO(i).backend_hostname == '/')
+			continue;
+		num_candidates++;
 	}
-	else
+
+	/* nothing to gain */
+	if (num_candidates < 2)
+		return;
+
+	for (i = 0; i < NUM_BACKENDS; i++)
+	{
+		BackendInfo *b = &BACKEND_INFO(i);
+		struct addrinfo hints;
+		struct addrinfo *res;
+		char		portstr[16];
+		int			fd;
+
+		if (!VALID_BACKEND(i) ||
+			(b->backend_status != CON_UP && b->backend_status != CON_CONNECT_WAIT) ||
+			*b->backend_hostname == '/')
+			continue;
+
+		snprintf(portstr, sizeof(portstr), "%d", b->backend_port);
+		memset(&hints, 0, sizeof(struct addrinfo));
+		hints.ai_family = PF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+
+		if (getaddrinfo(b->backend_hostname, portstr, &hints, &res) != 0)
+			continue;
+
+		/*
+		 * Only the first address is tried here. Leave hosts with multiple
+		 * addresses to connect_inet_domain_socket(), which tries them all.
+		 */
+		if (res->ai_next != NULL)
+		{
+			freeaddrinfo(res);
+			continue;
+		}
+
+		fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+		if (fd < 0)
+		{
+			freeaddrinfo(res);
+			continue;
+		}
+
+		if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (char *) &on, sizeof(on)) < 0)
+		{
+			close(fd);
+			freeaddrinfo(res);
+			continue;
+		}
+
+		pool_set_nonblock(fd);
+
+		if (connect(fd, res->ai_addr, res->ai_addrlen) == 0)
+		{
+			pool_unset_nonblock(fd);
+			fds[i] = fd;
+		}
+		else if (errno == EINPROGRESS)
+		{
+			fds[i] = fd;
+			pending[i] = true;
+			num_pending++;
+		}
+		else
+		{
+			ereport(LOG,
+					(errmsg("failed to connect to PostgreSQL server on \"%s:%d\" with error \"%s\"",
+							b->backend_hostname, b->backend_port, strerror(errno))));
+			close(fd);
+			fds[i] = POOL_CONNECT_FAILED;
+		}
+
+		freeaddrinfo(res);
+	}
+
+	gettimeofday(&start, NULL);
+
+	while (num_pending > 0)
+	{
+		struct timeval timeout;
+		struct timeval *tm = NULL;
+		fd_set		wset;
+		int			maxfd = -1;
+		int			sts;
+
+		if (exit_request)
+		{
+			timed_out = true;
+			break;
+		}
+
+		if (pool_config->connect_timeout > 0)
+		{
+			struct timeval now;
+			long		remaining;
+
+			gettimeofday(&now, NULL);
+			remaining = pool_config->connect_timeout -
+				((now.tv_sec - start.tv_sec) * 1000 + (now.tv_usec - start.tv_usec) / 1000);
+			if (remaining <= 0)
+			{
+				timed_out = true;
+				break;
+			}
+			timeout.tv_sec = remaining / 1000;
+			timeout.tv_usec = (remaining % 1000) * 1000;
+			tm = &timeout;
+		}
+
+		FD_ZERO(&wset);
+		for (i = 0; i < NUM_BACKENDS; i++)
+		{
+			if (!pending[i])
+				continue;
+			FD_SET(fds[i], &wset);
+			if (fds[i] > maxfd)
+				maxfd = fds[i];
+		}
+
+		sts = select(maxfd + 1, NULL, &wset, NULL, tm);
+		if (sts < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		if (sts == 0)
+		{
+			timed_out = true;
+			break;
+		}
+
+		for (i = 0; i < NUM_BACKENDS; i++)
+		{
+			int			error = 0;
+			socklen_t	socklen = sizeof(error);
+
+			if (!pending[i] || !FD_ISSET(fds[i], &wset))
+				continue;
+
+			pending[i] = false;
+			num_pending--;
+
+			if (getsockopt(fds[i], SOL_SOCKET, SO_ERROR, &error, &socklen) < 0)
+			{
+				close(fds[i]);
+				fds[i] = -1;
+				continue;
+			}
+			if (error != 0)
+			{
+				ereport(LOG,
+						(errmsg("failed to connect to PostgreSQL server on \"%s:%d\" with error \"%s\"",
+								BACKEND_INFO(i).backend_hostname, BACKEND_INFO(i).backend_port,
+								strerror(error))));
+				close(fds[i]);
+				fds[i] = POOL_CONNECT_FAILED;
+				continue;
+			}
+			pool_unset_nonblock(fds[i]);
+		}
+	}
+
+	/*
+	 * Give up connections not completed in time. If select(2) itself failed,
+	 * the backends are not to blame and the ordinary connect is tried.
+	 */
+	for (i = 0; i < NUM_BACKENDS; i++)
+	{
+		if (pending[i])
+		{
+			close(fds[i]);
+			fds[i] = -1;
+			if (!timed_out)
+				continue;
+
+			if (exit_request)
+				ereport(LOG,
+						(errmsg("failed to connect to PostgreSQL server on \"%s:%d\" using INET socket",
+								BACKEND_INFO(i).backend_hostname, BACKEND_INFO(i).backend_port),
+						 errdetail("exit request has been sent")));
+			else
+				ereport(LOG,
+						(errmsg("failed to connect to PostgreSQL server on \"%s:%d\", timed out",
+								BACKEND_INFO(i).backend_hostname, BACKEND_INFO(i).backend_port)));
+			fds[i] = POOL_CONNECT_FAILED;
+		}
+	}
+}
+
+/*
+ * create connection pool. If fd is not -1, it is a socket already connected
+ * to the backend, or POOL_CONNECT_FAILED if connecting in parallel failed.
+ */
+static POOL_CONNECTION_POOL_SLOT * create_cp(POOL_CONNECTION_POOL_SLOT * cp, int slot, int fd)
+{
+	BackendInfo *b = &pool_config->backend_desc->backend_info[slot];
+
+	if (fd == -1)
 	{
-		fd = connect_inet_domain_socket(slot, TRUE);
+		if (*b->backend_hostname == '/')
+		{
+			fd = connect_unix_domain_socket(slot, TRUE);
+		}
+		else
+		{
+			fd = connect_inet_domain_socket(slot, TRUE);
+		}
 	}
 
 	if (fd < 0)
@@ -850,11 +1079,14 @@ static POOL_CONNECTION_POOL * new_connection(POOL_CONNECTION_POOL * p)
 {
 	POOL_CONNECTION_POOL_SLOT *s;
 	int			active_backend_count = 0;
+	int			fds[MAX_NUM_BACKENDS];
 	int			i;
 	bool		status_changed = false;
 
 	MemoryContext oldContext = MemoryContextSwitchTo(TopMemoryContext);
 
+	connect_inet_domain_sockets_in_parallel(fds);
+
 	for (i = 0; i < NUM_BACKENDS; i++)
 	{
 		ereport(DEBUG1,
@@ -867,6 +1099,8 @@ static POOL_CONNECTION_POOL * new_connection(POOL_CONNECTION_POOL * p)
 					(errmsg("creating new connection to backend"),
 					 errdetail("skipping backend slot %d because backend_status = %d",
 							   i, BACKEND_INFO(i).backend_status)));
+			if (fds[i] >= 0)
+				close(fds[i]);
 			continue;
 		}
 
@@ -886,12 +1120,14 @@ static POOL_CONNECTION_POOL * new_connection(POOL_CONNECTION_POOL * p)
 
 			/* sync local status with global status */
 			*(my_backend_status[i]) = BACKEND_INFO(i).backend_status;
+			if (fds[i] >= 0)
+				close(fds[i]);
 			continue;
 		}
 
 		s = palloc(sizeof(POOL_CONNECTION_POOL_SLOT));
 
-		if (create_cp(s, i) == NULL)
+		if (create_cp(s, i, fds[i]) == NULL)
 		{
 			pfree(s);
 
@@ -1019,3 +1255,136 @@ pool_pool_index(void)
 {
 	return pool_index;
 }
+
+/*
+ * Remember the startup packet of the connection pool just handed to a
+ * client so that idle children can open the most frequently used ones in
+ * advance. Each packet hashes to a single entry of the table. If the entry
+ * is occupied by another packet, its count is decremented and the entry is
+ * taken over once the count drops to zero, so that the table converges to
+ * the frequently used packets without keeping exact counts.
+ */
+void
+pool_record_startup_packet(POOL_CONNECTION_POOL * backend)
+{
+	StartupPacket *sp;
+	StartupPacketStat *stat;
+	uint32		hash = 2166136261U;
+	int			i;
+
+	if (pool_config->prewarm_connections <= 0 || startup_packet_stats == NULL)
+		return;
+
+	sp = MASTER_CONNECTION(backend)->sp;
+
+	/* we do not bother to prewarm protocol version 2 connections */
+	if (sp == NULL || sp->major != PROTO_MAJOR_V3)
+		return;
+
+	if (sp->len > STARTUP_PACKET_STATS_PACKET_LEN ||
+		strlen(sp->user) >= STARTUP_PACKET_STATS_NAME_LEN ||
+		strlen(sp->database) >= STARTUP_PACKET_STATS_NAME_LEN)
+		return;
+
+	/* FNV-1a */
+	for (i = 0; i < sp->len; i++)
+	{
+		hash ^= (unsigned char) sp->startup_packet[i];
+		hash *= 16777619U;
+	}
+	if (hash == 0)
+		hash = 1;
+
+	stat = &startup_packet_stats[hash % STARTUP_PACKET_STATS_SIZE];
+
+	pool_semaphore_lock(STARTUP_PACKET_STATS_SEM);
+
+	if (stat->hash == hash && stat->len == sp->len &&
+		memcmp(stat->packet, sp->startup_packet, sp->len) == 0)
+	{
+		if (stat->count < INT_MAX)
+			stat->count++;
+		stat->auth_kind = MASTER(backend)->auth_kind;
+	}
+	else if (stat->count > 1)
+	{
+		stat->count--;
+	}
+	else
+	{
+		stat->hash = hash;
+		stat->count = 1;
+		stat->auth_kind = MASTER(backend)->auth_kind;
+		stat->len = sp->len;
+		stat->application_name = sp->application_name ?
+			sp->application_name - sp->startup_packet : -1;
+		strlcpy(stat->user, sp->user, sizeof(stat->user));
+		strlcpy(stat->database, sp->database, sizeof(stat->database));
+		memcpy(stat->packet, sp->startup_packet, sp->len);
+	}
+
+	pool_semaphore_unlock(STARTUP_PACKET_STATS_SEM);
+}
+
+static int
+startup_packet_stat_cmp(const void *a, const void *b)
+{
+	return ((const StartupPacketStat *) b)->count -
+		((const StartupPacketStat *) a)->count;
+}
+
+/*
+ * Copy up to max used entries of the startup packet table to stats, the most
+ * frequently used first. Returns the number of copied entries.
+ */
+int
+pool_get_frequent_startup_packets(StartupPacketStat * stats, int max)
+{
+	int			i;
+	int			n = 0;
+
+	if (startup_packet_stats == NULL)
+		return 0;
+
+	pool_semaphore_lock(STARTUP_PACKET_STATS_SEM);
+	for (i = 0; i < STARTUP_PACKET_STATS_SIZE; i++)
+	{
+		if (startup_packet_stats[i].hash != 0)
+			memcpy(&stats[n++], &startup_packet_stats[i], sizeof(StartupPacketStat));
+	}
+	pool_semaphore_unlock(STARTUP_PACKET_STATS_SEM);
+
+	qsort(stats, n, sizeof(StartupPacketStat), startup_packet_stat_cmp);
+
+	return n < max ? n : max;
+}
+
+/*
+ * Return true if a child process just started may prewarm connections
+ * now. At most PREWARM_STARTUP_PER_SECOND children are allowed in a
+ * second.
+ */
+bool
+pool_prewarm_startup_allowed(void)
+{
+	time_t		now = time(NULL);
+	bool		allowed = false;
+
+	if (prewarm_startup_limit == NULL)
+		return true;
+
+	pool_semaphore_lock(STARTUP_PACKET_STATS_SEM);
+	if (prewarm_startup_limit->second != now)
+	{
+		prewarm_startup_limit->second = now;
+		prewarm_startup_limit->count = 0;
+	}
+	if (prewarm_startup_limit->count < PREWARM_STARTUP_PER_SECOND)
+	{
+		prewarm_startup_limit->count++;
+		allowed = true;
+	}
+	pool_semaphore_unlock(STARTUP_PACKET_STATS_SEM);
+
+	return allowed;
+}
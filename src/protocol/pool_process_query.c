@@ -86,6 +86,7 @@ static POOL_STATUS insert_oid_into_insert_lock(POOL_CONNECTION * frontend, POOL_
 static POOL_STATUS read_packets_and_process(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend, int reset_request, int *state, short *num_fields, bool *cont);
 static bool is_all_slaves_command_complete(unsigned char *kind_list, int num_backends, int master);
 static bool pool_process_notice_message_from_one_backend(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend, int backend_idx, char kind);
+static void detach_failed_backends(POOL_CONNECTION_POOL * backend);
 
 /*
  * Main module for query processing
@@ -120,7 +121,7 @@ pool_process_query(POOL_CONNECTION * frontend,
 
 
 	/* Try to connect memcached */
-	if ((pool_config->memory_cache_enabled || pool_config->enable_shared_relcache)
+	if (pool_config->memory_cache_enabled
 		&& !pool_is_shmem_cache())
 	{
 		memcached_connect();
@@ -4599,6 +4600,8 @@ static POOL_STATUS read_packets_and_process(POOL_CONNECTION * frontend, POOL_CON
 	int			idle_count_in_recovery = 0; /* for in recovery */
 
 SELECT_RETRY:
+	detach_failed_backends(backend);
+
 	FD_ZERO(&readmask);
 	FD_ZERO(&writemask);
 	FD_ZERO(&exceptmask);
@@ -4713,6 +4716,9 @@ SELECT_RETRY:
 		goto SELECT_RETRY;
 	}
 
+	/* the data may be EOF from a backend which has been degenerated */
+	detach_failed_backends(backend);
+
 	for (i = 0; i < NUM_BACKENDS; i++)
 	{
 		if (VALID_BACKEND(i))
@@ -5009,3 +5015,47 @@ pool_push_pending_data(POOL_CONNECTION * backend)
 	}
 	return data_pushed;
 }
+
+/*
+ * Detach the backends degenerated by failover while this session is
+ * running. In streaming replication mode, if the session does not depend on
+ * the failed node, i.e. the node is neither the primary, the master nor the
+ * load balance node of the session and no transaction is open on it, the
+ * connection to the node is closed and the session continues. Otherwise
+ * the session is terminated.
+ */
+static void
+detach_failed_backends(POOL_CONNECTION_POOL * backend)
+{
+	int			i;
+
+	if (!SL_MODE || pool_is_query_in_progress() || pool_pending_message_exists())
+		return;
+
+	for (i = 0; i < NUM_BACKENDS; i++)
+	{
+		if (!VALID_BACKEND(i) || BACKEND_INFO(i).backend_status != CON_DOWN ||
+			CONNECTION_SLOT(backend, i) == NULL)
+			continue;
+
+		if (i == Req_info->primary_node_id || i == my_master_node_id ||
+			i == backend->info->load_balancing_node || TSTATE(backend, i) != 'I')
+		{
+			ereport(FATAL,
+					(pool_error_code(ADMIN_SHUTDOWN_ERROR_CODE),
+					 errmsg("terminating connection because backend node %d used by this session went down", i)));
+		}
+
+		ereport(LOG,
+				(errmsg("detaching failed backend node %d from the session", i),
+				 errdetail("the session does not use the node")));
+
+		/* the startup packet is shared with the other slots */
+		CONNECTION_SLOT(backend, i)->sp = NULL;
+		pool_close(CONNECTION(backend, i));
+		pfree(CONNECTION_SLOT(backend, i));
+		CONNECTION_SLOT(backend, i) = NULL;
+
+		*(my_backend_status[i]) = CON_DOWN;
+	}
+}
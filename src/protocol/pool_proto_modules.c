@@ -90,6 +90,8 @@ static POOL_STATUS parse_before_bind(POOL_CONNECTION * frontend,
 static int *find_victim_nodes(int *ntuples, int nmembers, int master_node, int *number_of_nodes);
 static POOL_STATUS close_standby_transactions(POOL_CONNECTION * frontend,
 											  POOL_CONNECTION_POOL * backend);
+static bool is_write_query(Node *node, char *query);
+static void update_write_lsn(POOL_CONNECTION_POOL * backend);
 
 static char *flatten_set_variable_args(const char *name, List *args);
 static bool
@@ -175,6 +177,8 @@ SimpleQuery(POOL_CONNECTION * frontend,
 	static char *sq_nodes = "pool_nodes";
 	static char *sq_version = "pool_version";
 	static char *sq_cache = "pool_cache";
+	static char *sq_cache_entries = "pool_cache_entries";
+	static char *sq_health_check_stats = "pool_health_check_stats";
 	int			commit;
 	List	   *parse_tree_list;
 	Node	   *node = NULL;
@@ -430,6 +434,22 @@ SimpleQuery(POOL_CONNECTION * frontend,
 						 errdetail("cache reporting")));
 				cache_reporting(frontend, backend);
 			}
+			else if (!strcmp(sq_cache_entries, vnode->name))
+			{
+				is_valid_show_command = true;
+				ereport(DEBUG1,
+						(errmsg("SimpleQuery"),
+						 errdetail("cache entries reporting")));
+				cache_entries_reporting(frontend, backend);
+			}
+			else if (!strcmp(sq_health_check_stats, vnode->name))
+			{
+				is_valid_show_command = true;
+				ereport(DEBUG1,
+						(errmsg("SimpleQuery"),
+						 errdetail("health check stats reporting")));
+				health_check_stats_reporting(frontend, backend);
+			}
 
 			if (is_valid_show_command)
 			{
@@ -770,6 +790,7 @@ Execute(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend,
 	query_context = bind_msg->query_context;
 	node = bind_msg->query_context->parse_tree;
 	query = bind_msg->query_context->original_query;
+	gettimeofday(&query_context->start_time, NULL);
 
 	strlcpy(query_string_buffer, query, sizeof(query_string_buffer));
 
@@ -788,16 +809,11 @@ Execute(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend,
 	{
 		POOL_STATUS status;
 		char	   *search_query = NULL;
-		int			len;
 
-#define STR_ALLOC_SIZE 1024
 		ereport(DEBUG1, (errmsg("Execute: pool_is_likely_select: true pool_is_writing_transaction: %d TSTATE: %c",
 								pool_is_writing_transaction(),
 								TSTATE(backend, MASTER_SLAVE ? PRIMARY_NODE_ID : REAL_MASTER_NODE_ID))));
 
-		len = strlen(query) + 1;
-		search_query = MemoryContextStrdup(query_context->memory_context, query);
-
 		ereport(DEBUG1, (errmsg("Execute: checkig cache fetch condition")));
 
 		/*
@@ -805,30 +821,17 @@ Execute(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend,
 		 */
 		if (query_context->is_cache_safe && bind_msg->param_offset && bind_msg->contents)
 		{
-			/* Extract binary contents from bind message */
-			char	   *query_in_bind_msg = bind_msg->contents + bind_msg->param_offset;
-			char		hex_str[4]; /* 02X chars + white space + null end */
-			int			i;
-			int			alloc_len;
-
-			alloc_len = (len / STR_ALLOC_SIZE + 1) * STR_ALLOC_SIZE;
-			search_query = repalloc(search_query, alloc_len);
+			MemoryContext old_context;
 
-			for (i = 0; i < bind_msg->len - bind_msg->param_offset; i++)
-			{
-				int			hexlen;
-
-				snprintf(hex_str, sizeof(hex_str), (i == 0) ? " %02X" : "%02X", 0xff & query_in_bind_msg[i]);
-				hexlen = strlen(hex_str);
-
-				if ((len + hexlen) >= alloc_len)
-				{
-					alloc_len += STR_ALLOC_SIZE;
-					search_query = repalloc(search_query, alloc_len);
-				}
-				strcat(search_query, hex_str);
-				len += hexlen;
-			}
+			/*
+			 * Build the key from the query and parameter values and formats
+			 * in the bind message.
+			 */
+			old_context = MemoryContextSwitchTo(query_context->memory_context);
+			search_query = pool_get_bind_cache_key(query,
+												   bind_msg->contents + bind_msg->param_offset,
+												   bind_msg->len - bind_msg->param_offset);
+			MemoryContextSwitchTo(old_context);
 
 			/*
 			 * If bind message is sent again to an existing prepared statement,
@@ -853,7 +856,8 @@ Execute(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend,
 			 * However, It is possible that temp_cache does not exist.
 			 * Consider following scenario: - In the previous execute cache is
 			 * overflowed, and temp_cache discarded. - In the subsequent
-			 * bind/execute uses the same portal
+			 * bind/execute uses the same portal. In this case
+			 * memqcache_register() creates temp_cache using query_w_hex.
 			 */
 			if (query_context->temp_cache)
 			{
@@ -861,6 +865,8 @@ Execute(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend,
 				query_context->temp_cache->query = MemoryContextStrdup(session_context->memory_context, search_query);
 			}
 		}
+		else
+			search_query = MemoryContextStrdup(query_context->memory_context, query);
 
 		/*
 		 * If the query is SELECT from table to cache, try to fetch cached
@@ -1454,6 +1460,11 @@ Bind(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend,
 	{
 		if (!SL_MODE)
 		{
+			/*
+			 * Temporary tables may have been created or dropped since the
+			 * parse message. Analyze the query again.
+			 */
+			query_context->select_analysis = NULL;
 			pool_where_to_send(query_context, query_context->original_query,
 							   query_context->parse_tree);
 		}
@@ -1972,6 +1983,25 @@ ReadyForQuery(POOL_CONNECTION * frontend,
 		}
 	}
 
+	/*
+	 * If read_your_writes is on, take the WAL location of the primary when a
+	 * transaction which wrote something ends so that following reads are
+	 * not sent to standbys which have not replayed it yet. This must be done
+	 * before the frontend sends next query. Writes by extended query
+	 * messages have been remembered at CommandComplete by
+	 * pool_at_command_success(), which is called for a simple query after
+	 * ReadyForQuery is forwarded, so check the simple query here.
+	 */
+	if (pool_config->read_your_writes && STREAM && MAJOR(backend) == PROTO_MAJOR_V3)
+	{
+		if (pool_is_query_in_progress() && pool_is_command_success() &&
+			is_write_query(pool_get_parse_tree(), pool_get_query_string()))
+			session_context->write_lsn_pending = true;
+
+		if (session_context->write_lsn_pending && state == 'I')
+			update_write_lsn(backend);
+	}
+
 	if (send_ready)
 	{
 		pool_write(frontend, "Z", 1);
@@ -2071,6 +2101,52 @@ ReadyForQuery(POOL_CONNECTION * frontend,
 	return POOL_CONTINUE;
 }
 
+/*
+ * Return true if the query may write something on the primary.
+ */
+static bool
+is_write_query(Node *node, char *query)
+{
+	if (node == NULL || query == NULL)
+		return false;
+
+	if (IsA(node, TransactionStmt) || IsA(node, VariableSetStmt) ||
+		IsA(node, VariableShowStmt))
+		return false;
+
+	return !is_select_query(node, query) || pool_has_function_call(node);
+}
+
+/*
+ * Remember the current WAL location of the primary as the location every
+ * write of this session has been done.
+ */
+static void
+update_write_lsn(POOL_CONNECTION_POOL * backend)
+{
+	POOL_SESSION_CONTEXT *session_context = pool_get_session_context(false);
+	POOL_SELECT_RESULT *res;
+	char	   *query;
+
+	if (Pgversion(backend)->major >= 100)
+		query = "SELECT pg_current_wal_lsn()";
+	else
+		query = "SELECT pg_current_xlog_location()";
+
+	per_node_statement_log(backend, PRIMARY_NODE_ID, query);
+	do_query(CONNECTION(backend, PRIMARY_NODE_ID), query, &res, MAJOR(backend));
+
+	if (res->numrows == 1 && res->nullflags[0] != -1)
+		session_context->write_lsn = text_to_lsn(res->data[0]);
+	free_select_result(res);
+
+	session_context->write_lsn_pending = false;
+
+	ereport(DEBUG1,
+			(errmsg("update write LSN of the session"),
+			 errdetail("write LSN: %llX", (unsigned long long int) session_context->write_lsn)));
+}
+
 /*
  * Close running transactions on standbys.
  */
@@ -3927,6 +4003,14 @@ pool_at_command_success(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backe
 				(errmsg("pool_at_command_success: no query found")));
 	}
 
+	/*
+	 * Remember that the session wrote something so that ReadyForQuery takes
+	 * the WAL location of the primary for read_your_writes. Each Execute of
+	 * a pipeline comes here at its CommandComplete.
+	 */
+	if (pool_config->read_your_writes && is_write_query(node, query))
+		pool_get_session_context(false)->write_lsn_pending = true;
+
 	/*
 	 * If the query was BEGIN/START TRANSACTION, clear the history that we had
 	 * a writing command in the transaction and forget the transaction
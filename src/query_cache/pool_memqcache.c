@@ -36,6 +36,7 @@
 #include <ctype.h>
 #include <arpa/inet.h>
 #include <dirent.h>
+#include <sys/mman.h>
 
 #ifdef USE_MEMCACHED
 #include <libmemcached/memcached.h>
@@ -54,16 +55,19 @@
 #include "utils/elog.h"
 #include "utils/palloc.h"
 #include "utils/memutils.h"
+#include "utils/pg_lzcompress.h"
 
 #ifdef USE_MEMCACHED
 memcached_st *memc;
 #endif
 
 static char *encode_key(const char *s, char *buf, POOL_CONNECTION_POOL * backend);
+static int16 get_int16(const unsigned char *p);
+static int32 get_int32(const unsigned char *p);
 #ifdef DEBUG
 static void dump_cache_data(const char *data, size_t len);
 #endif
-static int	pool_commit_cache(POOL_CONNECTION_POOL * backend, char *query, char *data, size_t datalen, int num_oids, int *oids);
+static int	pool_commit_cache(POOL_CONNECTION_POOL * backend, char *query, char *data, size_t datalen, int raw_length, int num_oids, int *oids);
 static int	send_cached_messages(POOL_CONNECTION * frontend, const char *qcache, int qcachelen);
 static void send_message(POOL_CONNECTION * conn, char kind, int len, const char *data);
 #ifdef USE_MEMCACHED
@@ -76,9 +80,11 @@ static void pool_invalidate_query_cache(int num_table_oids, int *table_oid, bool
 static int	pool_get_database_oid(void);
 static void pool_add_table_oid_map(POOL_CACHEKEY * cachkey, int num_table_oids, int *table_oids);
 static void pool_reset_memqcache_buffer(bool reset_dml_oids);
-static POOL_CACHEID * pool_add_item_shmem_cache(POOL_QUERY_HASH * query_hash, char *data, int size, time_t expire);
+static POOL_CACHEID * pool_add_item_shmem_cache(POOL_QUERY_HASH * query_hash, char *data, int size, int raw_length, time_t expire,
+												 int num_generations, POOL_CACHE_TABLE_GENERATION * generations);
 static POOL_CACHEID * pool_find_item_on_shmem_cache(POOL_QUERY_HASH * query_hash);
-static char *pool_get_item_shmem_cache(POOL_QUERY_HASH * query_hash, int *size, int *sts);
+static char *pool_get_item_shmem_cache(POOL_QUERY_HASH * query_hash, int *size, int *raw_length, int *sts);
+static int	pool_compress_cache_data(char **data, size_t *datalen);
 static POOL_QUERY_CACHE_ARRAY * pool_add_query_cache_array(POOL_QUERY_CACHE_ARRAY * cache_array, POOL_TEMP_QUERY_CACHE * cache);
 static void pool_add_temp_query_cache(POOL_TEMP_QUERY_CACHE * temp_cache, char kind, char *data, int data_len);
 static void pool_add_oids_temp_query_cache(POOL_TEMP_QUERY_CACHE * temp_cache, int num_oids, int *oids);
@@ -97,8 +103,10 @@ static void pool_set_memqcache_blocks(int num_blocks);
 static int	pool_get_memqcache_blocks(void);
 static void *pool_memory_cache_address(void);
 static void pool_reset_fsmm(size_t size);
+static void pool_finish_memqcache_loading(void);
 static void *pool_fsmm_address(void);
 static void pool_update_fsmm(POOL_CACHE_BLOCKID blockid, size_t free_space);
+static POOL_CACHE_BLOCKID pool_find_block(size_t free_space);
 static POOL_CACHE_BLOCKID pool_get_block(size_t free_space);
 static POOL_CACHE_ITEM_HEADER * pool_cache_item_header(POOL_CACHEID * cacheid);
 static int	pool_init_cache_block(POOL_CACHE_BLOCKID blockid);
@@ -110,6 +118,16 @@ static char *block_address(int blockid);
 static POOL_CACHE_ITEM_POINTER * item_pointer(char *block, int i);
 static POOL_CACHE_ITEM_HEADER * item_header(char *block, int i);
 static POOL_CACHE_BLOCKID pool_reuse_block(void);
+static uint32 table_generation_slot(int dboid, int oid);
+static void pool_bump_table_generation(int dboid, int oid);
+static int	pool_get_table_generations(int num_oids, int *oids, POOL_CACHE_TABLE_GENERATION * *generationsp);
+static bool pool_is_cache_item_stale(POOL_CACHE_ITEM_HEADER * cih);
+static uint32 frequency_sketch_index(POOL_QUERY_HASH * query_hash, int row);
+static void pool_record_cache_access(POOL_QUERY_HASH * query_hash);
+static int	pool_estimate_cache_frequency(POOL_QUERY_HASH * query_hash);
+static int	pool_cache_item_request_size(int size, int num_generations);
+static bool pool_admit_item_shmem_cache(POOL_QUERY_HASH * query_hash, int request_size);
+static bool write_snapshot_data(int fd, const void *data, size_t size, const char *path);
 #ifdef SHMEMCACHE_DEBUG
 static void dump_shmem_cache(POOL_CACHE_BLOCKID blockid);
 #endif
@@ -219,6 +237,14 @@ memqcache_register(char kind,
 
 			query_context = session_context->query_context;
 
+			/*
+			 * In extended query protocol the query string is not enough to
+			 * identify the result. Use the key including bind parameters
+			 * built at Execute if any.
+			 */
+			if (pool_is_doing_extended_query_message() && query_context->query_w_hex)
+				query = query_context->query_w_hex;
+
 			if (query)
 				query_context->temp_cache = pool_create_temp_query_cache(query);
 		}
@@ -228,10 +254,13 @@ memqcache_register(char kind,
 }
 
 /*
- * Commit SELECT results to cache storage.
+ * Commit SELECT results to cache storage. If raw_length > 0, data has been
+ * compressed by pool_compress_cache_data() and raw_length is the original
+ * length. The compression is done by the caller before taking
+ * pool_shmem_lock() so that other processes do not wait for it.
  */
 static int
-pool_commit_cache(POOL_CONNECTION_POOL * backend, char *query, char *data, size_t datalen, int num_oids, int *oids)
+pool_commit_cache(POOL_CONNECTION_POOL * backend, char *query, char *data, size_t datalen, int raw_length, int num_oids, int *oids)
 {
 #ifdef USE_MEMCACHED
 	memcached_return rc;
@@ -253,6 +282,13 @@ pool_commit_cache(POOL_CONNECTION_POOL * backend, char *query, char *data, size_
 	{
 		return -1;
 	}
+
+	/* the cache is not available until the snapshot is loaded */
+	if (pool_is_shmem_cache() && pool_is_memqcache_loading())
+	{
+		return 0;
+	}
+
 	ereport(DEBUG1,
 			(errmsg("commiting SELECT results to cache storage"),
 			 errdetail("Query=\"%s\"", query)));
@@ -260,7 +296,6 @@ pool_commit_cache(POOL_CONNECTION_POOL * backend, char *query, char *data, size_
 	dump_cache_data(data, datalen);
 #endif
 
-
 	/* encode md5key for memcached */
 	encode_key(query, tmpkey, backend);
 	ereport(DEBUG2,
@@ -278,10 +313,17 @@ pool_commit_cache(POOL_CONNECTION_POOL * backend, char *query, char *data, size_
 	{
 		POOL_CACHEID *cacheid;
 		POOL_QUERY_HASH query_hash;
+		POOL_CACHE_TABLE_GENERATION *generations;
+		int			num_generations;
 
 		memcpy(query_hash.query_hash, tmpkey, sizeof(query_hash.query_hash));
 
-		cacheid = pool_hash_search(&query_hash);
+		/*
+		 * Use pool_find_item_on_shmem_cache() rather than pool_hash_search()
+		 * so that an expired or stale item is reclaimed and replaced by the
+		 * new result.
+		 */
+		cacheid = pool_find_item_on_shmem_cache(&query_hash);
 
 		if (cacheid != NULL)
 		{
@@ -293,7 +335,23 @@ pool_commit_cache(POOL_CONNECTION_POOL * backend, char *query, char *data, size_
 		}
 		else
 		{
-			cacheid = pool_add_item_shmem_cache(&query_hash, data, datalen,memqcache_expire);
+			num_generations = pool_get_table_generations(num_oids, oids, &generations);
+			if (num_generations < 0)
+				return -1;
+
+			if (!pool_admit_item_shmem_cache(&query_hash,
+											 pool_cache_item_request_size(datalen, num_generations)))
+			{
+				ereport(DEBUG1,
+						(errmsg("commiting SELECT results to cache storage"),
+						 errdetail("rejected by admission filter")));
+				pfree(generations);
+				return 0;
+			}
+
+			cacheid = pool_add_item_shmem_cache(&query_hash, data, datalen, raw_length,
+												memqcache_expire, num_generations, generations);
+			pfree(generations);
 			if (cacheid == NULL)
 			{
 				ereport(LOG,
@@ -315,8 +373,9 @@ pool_commit_cache(POOL_CONNECTION_POOL * backend, char *query, char *data, size_
 #ifdef USE_MEMCACHED
 	else
 	{
+		/* flags carries the uncompressed length if compressed */
 		rc = memcached_set(memc, tmpkey, 32,
-						   data, datalen, (time_t) memqcache_expire, 0);
+						   data, datalen, (time_t) memqcache_expire, raw_length);
 		if (rc != MEMCACHED_SUCCESS)
 		{
 			ereport(WARNING,
@@ -329,115 +388,13 @@ pool_commit_cache(POOL_CONNECTION_POOL * backend, char *query, char *data, size_
 	}
 #endif
 
-/*
- * Register cache id to oid map
- */
-	pool_add_table_oid_map(&cachekey, num_oids, oids);
-
-	return 0;
-}
-
-/*
- * Commit SELECT system catalog results to cache storage.
- */
-int
-pool_catalog_commit_cache(POOL_CONNECTION_POOL * backend, char *query, char *data, size_t datalen)
-{
-#ifdef USE_MEMCACHED
-	memcached_return rc;
-#endif
-	POOL_CACHEKEY cachekey;
-	char		tmpkey[MAX_KEY];
-	time_t		memqcache_expire;
-
 	/*
-	 * get_buflen() will return -1 if query result exceeds memqcache_maxcache
+	 * Register hash key to oid map. Shmem cache items carry table
+	 * generations instead, so they do not need the map.
 	 */
-	if (datalen == -1)
-	{
-		return -1;
-	}
-
-	/* query disabled */
-	if (strlen(query) <= 0)
-	{
-		return -1;
-	}
-	ereport(DEBUG1,
-			(errmsg("commiting relation cache to cache storage"),
-			 errdetail("Query=\"%s\"", query)));
-
-#ifdef DEBUG
-	dump_cache_data(data, datalen);
-#endif
-
-	/* encode md5key for memcached */
-	encode_key(query, tmpkey, backend);
-	ereport(DEBUG2,
-			(errmsg("commiting relation cache to cache storage"),
-			 errdetail("search key : \"%s\"", tmpkey)));
-
-	memcpy(cachekey.hashkey, tmpkey, 32);
-
-	memqcache_expire = pool_config->relcache_expire;
-	ereport(DEBUG1,
-			(errmsg("commiting relation cache to cache storage"),
-			 errdetail("memqcache_expire = %ld", memqcache_expire)));
-
-	if (pool_is_shmem_cache())
-	{
-		POOL_CACHEID *cacheid;
-		POOL_QUERY_HASH query_hash;
-
-		memcpy(query_hash.query_hash, tmpkey, sizeof(query_hash.query_hash));
-
-		cacheid = pool_hash_search(&query_hash);
-
-		if (cacheid != NULL)
-		{
-			ereport(DEBUG1,
-					(errmsg("commiting relation cache to cache storage"),
-					 errdetail("item already exists")));
-
-			return 0;
-		}
-		else
-		{
-			cacheid = pool_add_item_shmem_cache(&query_hash, data, datalen, memqcache_expire);
-			if (cacheid == NULL)
-			{
-				ereport(LOG,
-						(errmsg("failed to add item to shmem cache")));
-				return -1;
-			}
-			else
-			{
-				ereport(DEBUG2,
-						(errmsg("commiting relation cache to cache storage"),
-						 errdetail("blockid: %d itemid: %d",
-								   cacheid->blockid, cacheid->itemid)));
-			}
-			cachekey.cacheid.blockid = cacheid->blockid;
-			cachekey.cacheid.itemid = cacheid->itemid;
-		}
-	}
+	if (!pool_is_shmem_cache())
+		pool_add_table_oid_map(&cachekey, num_oids, oids);
 
-#ifdef USE_MEMCACHED
-	else
-	{
-		rc = memcached_set(memc, tmpkey, 32,
-						   data, datalen, (time_t) memqcache_expire, 0);
-		if (rc != MEMCACHED_SUCCESS)
-		{
-			ereport(WARNING,
-					(errmsg("cache commit failed with error:\"%s\"", memcached_strerror(memc, rc))));
-			return -1;
-		}
-		ereport(DEBUG1,
-				(errmsg("commiting relation cache to cache storage"),
-				 errdetail("set cache succeeded")));
-	}
-#endif
 	return 0;
 }
 
@@ -455,6 +412,7 @@ pool_fetch_cache(POOL_CONNECTION_POOL * backend, const char *query, char **buf,
 	char		tmpkey[MAX_KEY];
 	int			sts;
 	char	   *p;
+	int			raw_length = 0;
 
 	if (strlen(query) <= 0)
 		ereport(ERROR,
@@ -471,10 +429,42 @@ pool_fetch_cache(POOL_CONNECTION_POOL * backend, const char *query, char **buf,
 	{
 		POOL_QUERY_HASH query_hash;
 		int			mylen;
+		pool_sigset_t oldmask;
 
 		memcpy(query_hash.query_hash, tmpkey, sizeof(query_hash.query_hash));
 
-		ptr = pool_get_item_shmem_cache(&query_hash, &mylen, &sts);
+		POOL_SETMASK2(&BlockSig, &oldmask);
+		pool_shmem_lock();
+
+		PG_TRY();
+		{
+			/* Record the access for the admission filter, whether found or not */
+			pool_record_cache_access(&query_hash);
+
+			ptr = pool_get_item_shmem_cache(&query_hash, &mylen, &raw_length, &sts);
+
+			/*
+			 * Copy the item out of shared memory so that it is decompressed
+			 * after releasing the lock.
+			 */
+			if (ptr != NULL)
+			{
+				p = palloc(mylen);
+				memcpy(p, ptr, mylen);
+				ptr = p;
+			}
+		}
+		PG_CATCH();
+		{
+			pool_shmem_unlock();
+			POOL_SETMASK(&oldmask);
+			PG_RE_THROW();
+		}
+		PG_END_TRY();
+
+		pool_shmem_unlock();
+		POOL_SETMASK(&oldmask);
+
 		if (ptr == NULL)
 		{
 			ereport(DEBUG1,
@@ -516,6 +506,8 @@ pool_fetch_cache(POOL_CONNECTION_POOL * backend, const char *query, char **buf,
 				return 1;
 			}
 		}
+		/* flags carries the uncompressed length if compressed */
+		raw_length = flags;
 	}
 #else
 	else
@@ -525,12 +517,41 @@ pool_fetch_cache(POOL_CONNECTION_POOL * backend, const char *query, char **buf,
 	}
 #endif
 
-	p = palloc(*len);
+	if (raw_length > 0)
+	{
+		/* Decompress directly into the buffer to be returned */
+		p = palloc(raw_length);
 
-	memcpy(p, ptr, *len);
+		if (pglz_decompress(ptr, *len, p, raw_length) < 0)
+		{
+			ereport(LOG,
+					(errmsg("fetching from cache storage, failed to decompress cache data"),
+					 errdetail("search key \"%s\"", tmpkey)));
+			pfree(p);
+			if (pool_is_shmem_cache())
+				pfree(ptr);
+			else
+				free(ptr);
+			/* Behave as if cache not found */
+			return 1;
+		}
+		*len = raw_length;
 
-	if (!pool_is_shmem_cache())
+		if (pool_is_shmem_cache())
+			pfree(ptr);
+		else
+			free(ptr);
+	}
+	else if (pool_is_shmem_cache())
+	{
+		/* already copied out of shared memory */
+		p = ptr;
+	}
+	else
 	{
+		p = palloc(*len);
+
+		memcpy(p, ptr, *len);
 		free(ptr);
 	}
 
@@ -546,6 +567,234 @@ pool_fetch_cache(POOL_CONNECTION_POOL * backend, const char *query, char **buf,
 	return 0;
 }
 
+/*
+ * Compress cache data if its length is memqcache_compress_threshold or
+ * more. This must be called before pool_shmem_lock(). If the data is
+ * compressed, *data and *datalen are replaced with the palloc'ed compressed
+ * data and its length, and the original length is returned. Returns 0 if
+ * the data should be stored as it is, i.e. compression is disabled, the
+ * data is too small or it does not compress well.
+ */
+static int
+pool_compress_cache_data(char **data, size_t *datalen)
+{
+	char	   *compressed;
+	int32		len;
+	int			raw_length;
+
+	if (*data == NULL || *datalen == -1 ||
+		pool_config->memqcache_compress_threshold <= 0 ||
+		*datalen < pool_config->memqcache_compress_threshold)
+		return 0;
+
+	compressed = palloc(PGLZ_MAX_OUTPUT(*datalen));
+	len = pglz_compress(*data, *datalen, compressed, PGLZ_strategy_default);
+	if (len < 0)
+	{
+		pfree(compressed);
+		return 0;
+	}
+
+	ereport(DEBUG1,
+			(errmsg("commiting SELECT results to cache storage"),
+			 errdetail("compressed %zd bytes to %d bytes", *datalen, len)));
+
+	raw_length = *datalen;
+	*data = compressed;
+	*datalen = len;
+	return raw_length;
+}
+
+/*
+ * Read network byte order integers from a message
+ */
+static int16
+get_int16(const unsigned char *p)
+{
+	uint16		tmp;
+
+	memcpy(&tmp, p, sizeof(tmp));
+	return (int16) ntohs(tmp);
+}
+
+static int32
+get_int32(const unsigned char *p)
+{
+	uint32		tmp;
+
+	memcpy(&tmp, p, sizeof(tmp));
+	return (int32) ntohl(tmp);
+}
+
+/*
+ * Build query cache key for extended query protocol from the query string
+ * and the part of a Bind message following the portal name and the
+ * statement name (params, len bytes). The key consists of the query string
+ * followed by each parameter value in hex with its format, and the result
+ * format codes.
+ *
+ * Format codes are normalized so that Bind messages meaning the same thing
+ * produce the same key. For example "no format code" and "one text format
+ * code" are the same, and a result format list having the same code for
+ * all columns is regarded as the single code.
+ *
+ * If the message cannot be parsed, the key is built from the hex of the
+ * whole params as it is. Returns palloc'ed string.
+ */
+char *
+pool_get_bind_cache_key(const char *query, const char *params, int len)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	const unsigned char *p = (const unsigned char *) params;
+	const unsigned char *end = p + len;
+	const unsigned char *param_formats;
+	const unsigned char *result_formats;
+	int			num_param_formats;
+	int			num_params;
+	int			num_result_formats;
+	int			query_len = strlen(query);
+	int			i;
+	bool		same_format;
+	char	   *key;
+	char	   *kp;
+
+	/* Parameter format codes */
+	if (end - p < sizeof(int16))
+		goto malformed;
+	num_param_formats = get_int16(p);
+	p += sizeof(int16);
+	if (num_param_formats < 0 || end - p < num_param_formats * sizeof(int16))
+		goto malformed;
+	param_formats = p;
+	p += num_param_formats * sizeof(int16);
+
+	/* Parameters */
+	if (end - p < sizeof(int16))
+		goto malformed;
+	num_params = get_int16(p);
+	p += sizeof(int16);
+	if (num_params < 0 || (num_param_formats > 1 && num_param_formats != num_params))
+		goto malformed;
+
+	/*
+	 * Key length: query + " " + for each parameter "<format><hex value>"
+	 * or "N" followed by a space, and "R" + result formats. Check the
+	 * parameters at the same time.
+	 */
+	{
+		const unsigned char *q = p;
+		int			key_len = query_len + 1;
+
+		for (i = 0; i < num_params; i++)
+		{
+			int32		plen;
+
+			if (end - q < sizeof(int32))
+				goto malformed;
+			plen = get_int32(q);
+			q += sizeof(int32);
+			if (plen > 0)
+			{
+				if (end - q < plen)
+					goto malformed;
+				q += plen;
+				key_len += 2 + plen * 2;
+			}
+			else
+				key_len += 2;
+		}
+
+		if (end - q < sizeof(int16))
+			goto malformed;
+		num_result_formats = get_int16(q);
+		q += sizeof(int16);
+		if (num_result_formats < 0 || end - q != num_result_formats * sizeof(int16))
+			goto malformed;
+		result_formats = q;
+		key_len += 1 + Max(num_result_formats, 1) + 1;
+
+		key = palloc(key_len);
+	}
+
+	memcpy(key, query, query_len);
+	kp = key + query_len;
+	*kp++ = ' ';
+
+	for (i = 0; i < num_params; i++)
+	{
+		int32		plen;
+		int16		format = 0;
+
+		if (num_param_formats == 1)
+			format = get_int16(param_formats);
+		else if (num_param_formats > 1)
+			format = get_int16(param_formats + i * sizeof(int16));
+
+		plen = get_int32(p);
+		p += sizeof(int32);
+
+		if (plen < 0)
+		{
+			/* NULL */
+			*kp++ = 'N';
+		}
+		else
+		{
+			int			j;
+
+			*kp++ = format ? 'b' : 't';
+			for (j = 0; j < plen; j++)
+			{
+				*kp++ = hex[p[j] >> 4];
+				*kp++ = hex[p[j] & 0x0f];
+			}
+			p += plen;
+		}
+		*kp++ = ' ';
+	}
+
+	*kp++ = 'R';
+	same_format = true;
+	for (i = 1; i < num_result_formats; i++)
+	{
+		if (get_int16(result_formats + i * sizeof(int16)) != get_int16(result_formats))
+		{
+			same_format = false;
+			break;
+		}
+	}
+	if (num_result_formats == 0)
+		*kp++ = 't';
+	else if (same_format)
+		*kp++ = get_int16(result_formats) ? 'b' : 't';
+	else
+	{
+		for (i = 0; i < num_result_formats; i++)
+			*kp++ = get_int16(result_formats + i * sizeof(int16)) ? 'b' : 't';
+	}
+	*kp = '\0';
+
+	return key;
+
+malformed:
+	ereport(DEBUG1,
+			(errmsg("building query cache key for bind message"),
+			 errdetail("could not parse bind message")));
+
+	key = palloc(query_len + 1 + len * 2 + 1);
+	memcpy(key, query, query_len);
+	kp = key + query_len;
+	*kp++ = ' ';
+	for (i = 0; i < len; i++)
+	{
+		*kp++ = hex[(unsigned char) params[i] >> 4];
+		*kp++ = hex[(unsigned char) params[i] & 0x0f];
+	}
+	*kp = '\0';
+
+	return key;
+}
+
 /*
  * encode key.
  * create cache key as md5(username + query string + database name)
@@ -731,30 +980,17 @@ pool_fetch_from_memory_cache(POOL_CONNECTION * frontend,
 	char	   *qcache;
 	size_t		qcachelen;
 	int			sts;
-	pool_sigset_t oldmask;
 
 	ereport(DEBUG1,
 			(errmsg("pool_fetch_from_memory_cache called")));
 
 	*foundp = false;
 
-	POOL_SETMASK2(&BlockSig, &oldmask);
-	pool_shmem_lock();
-
-	PG_TRY();
-	{
-		sts = pool_fetch_cache(backend, contents, &qcache, &qcachelen);
-	}
-	PG_CATCH();
-	{
-		pool_shmem_unlock();
-		POOL_SETMASK(&oldmask);
-		PG_RE_THROW();
-	}
-	PG_END_TRY();
+	if (pool_is_shmem_cache() && pool_is_memqcache_loading())
+		return POOL_CONTINUE;
 
-	pool_shmem_unlock();
-	POOL_SETMASK(&oldmask);
+	/* pool_fetch_cache() takes the shmem lock by itself */
+	sts = pool_fetch_cache(backend, contents, &qcache, &qcachelen);
 
 	if (sts != 0)
 		/* Cache not found */
@@ -917,8 +1153,9 @@ bool
 pool_is_allow_to_cache(Node *node, char *query)
 {
 	int			i = 0;
-	int			num_oids = -1;
-	SelectContext ctx;
+	int			num_oids;
+	int			flags;
+	SelectContext *ctx;
 
 	/*
 	 * If NO QUERY CACHE comment exists, do not cache.
@@ -926,52 +1163,65 @@ pool_is_allow_to_cache(Node *node, char *query)
 	if (!strncasecmp(query, NO_QUERY_CACHE, NO_QUERY_CACHE_COMMENT_SZ))
 		return false;
 
+	/*
+	 * Collect all the facts checked below by a single walk over the parse
+	 * tree.
+	 */
+	flags = POOL_SELECT_INSERTINTO_OR_LOCKING |
+		POOL_SELECT_NON_IMMUTABLE_FUNCTION |
+		POOL_SELECT_SYSTEM_CATALOG;
+	if (pool_config->check_temp_table)
+		flags |= POOL_SELECT_TEMP_TABLE;
+	if (pool_config->num_black_memqcache_table_list > 0 ||
+		pool_config->num_white_memqcache_table_list > 0)
+		flags |= POOL_SELECT_TABLE_OIDS;
+	if (pool_config->num_white_memqcache_table_list <= 0)
+		flags |= POOL_SELECT_VIEW | POOL_SELECT_UNLOGGED_TABLE;
+
+	ctx = pool_analyze_select_stmt(node, flags);
+	num_oids = ctx->num_oids;
+
 	/*
 	 * Check black table list first.
 	 */
 	if (pool_config->num_black_memqcache_table_list > 0)
 	{
 		/*
-		 * Extract oids in from clause of SELECT, and check if SELECT to them
-		 * could be cached.
+		 * Check if SELECT to the tables in from clause could be cached.
 		 */
-		num_oids = pool_extract_table_oids_from_select_stmt(node, &ctx);
-		if (num_oids > 0)
+		for (i = 0; i < num_oids; i++)
 		{
-			for (i = 0; i < num_oids; i++)
+			ereport(DEBUG1,
+					(errmsg("memcache: checking if node is allowed to cache: check table_names[%d] = \"%s\"", i, ctx->table_names[i])));
+			if (pool_is_table_in_black_list(ctx->table_names[i]) == true)
 			{
 				ereport(DEBUG1,
-						(errmsg("memcache: checking if node is allowed to cache: check table_names[%d] = \"%s\"", i, ctx.table_names[i])));
-				if (pool_is_table_in_black_list(ctx.table_names[i]) == true)
-				{
-					ereport(DEBUG1,
-							(errmsg("memcache: node is not allowed to cache")));
-					return false;
-				}
+						(errmsg("memcache: node is not allowed to cache")));
+				return false;
 			}
 		}
 	}
 
 	/* SELECT INTO or SELECT FOR SHARE or UPDATE cannot be cached */
-	if (pool_has_insertinto_or_locking_clause(node))
+	if (ctx->has_insertinto_or_locking_clause)
 		return false;
 
 	/*
 	 * If SELECT uses non immutable functions, it's not allowed to cache.
 	 */
-	if (pool_has_non_immutable_function_call(node))
+	if (ctx->has_non_immutable_function_call)
 		return false;
 
 	/*
 	 * If SELECT uses temporary tables it's not allowed to cache.
 	 */
-	if (pool_config->check_temp_table && pool_has_temp_table(node))
+	if (pool_config->check_temp_table && ctx->has_temp_table)
 		return false;
 
 	/*
 	 * If SELECT uses system catalogs, it's not allowed to cache.
 	 */
-	if (pool_has_system_catalog(node))
+	if (ctx->has_system_catalog)
 		return false;
 
 	/*
@@ -996,25 +1246,19 @@ pool_is_allow_to_cache(Node *node, char *query)
 	 */
 	if (pool_config->num_white_memqcache_table_list > 0)
 	{
-		if (num_oids < 0)
-			num_oids = pool_extract_table_oids_from_select_stmt(node, &ctx);
-
-		if (num_oids > 0)
+		for (i = 0; i < num_oids; i++)
 		{
-			for (i = 0; i < num_oids; i++)
-			{
-				char	   *table = ctx.table_names[i];
+			char	   *table = ctx->table_names[i];
 
-				ereport(DEBUG1,
-						(errmsg("memcache: checking if node is allowed to cache: check table_names[%d] = \"%s\"", i, table)));
-				if (is_view(table) || is_unlogged_table(table))
+			ereport(DEBUG1,
+					(errmsg("memcache: checking if node is allowed to cache: check table_names[%d] = \"%s\"", i, table)));
+			if (is_view(table) || is_unlogged_table(table))
+			{
+				if (pool_is_table_in_white_list(table) == false)
 				{
-					if (pool_is_table_in_white_list(table) == false)
-					{
-						ereport(DEBUG1,
-								(errmsg("memcache: node is not allowed to cache")));
-						return false;
-					}
+					ereport(DEBUG1,
+							(errmsg("memcache: node is not allowed to cache")));
+					return false;
 				}
 			}
 		}
@@ -1022,15 +1266,10 @@ pool_is_allow_to_cache(Node *node, char *query)
 	else
 	{
 		/*
-		 * If SELECT uses views, it's not allowed to cache.
+		 * If SELECT uses views or unlogged tables, it's not allowed to
+		 * cache.
 		 */
-		if (pool_has_view(node))
-			return false;
-
-		/*
-		 * If SELECT uses unlogged tables, it's not allowed to cache.
-		 */
-		if (pool_has_unlogged_table(node))
+		if (ctx->has_view || ctx->has_unlogged_table)
 			return false;
 	}
 	return true;
@@ -1367,6 +1606,9 @@ pool_discard_dml_table_oid(void)
  * deleted (cache invalidation) (when DROP TABLE, ALTER TABLE is
  * executed, the caches must be deleted as well). When database is
  * dropped, all caches belonging to the database must be deleted.
+ *
+ * The oid map is only used with memcached. Cache items on shmem record
+ * table generations instead (see pool_get_table_generations()).
  */
 
 /*
@@ -1661,6 +1903,33 @@ pool_invalidate_query_cache(int num_table_oids, int *table_oid, bool unlinkp, in
 	int			len;
 	POOL_CACHEKEY buf;
 
+	/*
+	 * In shmem case we just bump the generation of each table. Cache items
+	 * using the tables are found stale and deleted when they are looked up.
+	 */
+	if (pool_is_shmem_cache())
+	{
+		if (dboid == 0)
+		{
+			dboid = pool_get_database_oid();
+			if (dboid <= 0)
+			{
+				ereport(WARNING,
+						(errmsg("memcache: invalidating query cache, could not get database OID")));
+				return;
+			}
+		}
+
+		for (i = 0; i < num_table_oids; i++)
+		{
+			ereport(DEBUG1,
+					(errmsg("memcache invalidating query cache"),
+					 errdetail("bumping generation of table oid:%d dboid:%d", table_oid[i], dboid)));
+			pool_bump_table_generation(dboid, table_oid[i]);
+		}
+		return;
+	}
+
 	/*
 	 * Create memqcache_oiddir
 	 */
@@ -1940,6 +2209,13 @@ pool_shared_memory_cache_size(void)
  * only once from pgpool main process at the process staring up time.
  */
 static void *shmem;
+
+/*
+ * True while the query cache snapshot is being loaded by the loader
+ * process. Meanwhile children neither look up nor add cache items.
+ */
+static volatile bool *memqcache_loading;
+
 int
 pool_init_memory_cache(size_t size)
 {
@@ -1947,9 +2223,19 @@ pool_init_memory_cache(size_t size)
 			(errmsg("memory cache request size : %zd", size)));
 
 	shmem = pool_shared_memory_create(size);
+	memqcache_loading = pool_shared_memory_create(sizeof(bool));
 	return 0;
 }
 
+/*
+ * Returns true if the query cache snapshot is still being loaded.
+ */
+bool
+pool_is_memqcache_loading(void)
+{
+	return memqcache_loading != NULL && *memqcache_loading;
+}
+
 /*
  * Clear all the shared memory cache and reset FSMM and hash table.
  */
@@ -2106,122 +2392,787 @@ static POOL_CACHE_BLOCKID pool_reuse_block(void)
 	char	   *p;
 	int			i;
 
-	bh->flags = 0;
-	reused_block = *pool_fsmm_clock_hand;
-	p = block_address(reused_block);
+	bh->flags = 0;
+	reused_block = *pool_fsmm_clock_hand;
+	p = block_address(reused_block);
+
+	for (i = 0; i < bh->num_items; i++)
+	{
+		cip = item_pointer(p, i);
+
+		if (!(POOL_ITEM_DELETED & cip->flags))
+		{
+			pool_hash_delete(&cip->query_hash);
+			ereport(DEBUG1,
+					(errmsg("pool_reuse_block: blockid: %d item: %d", reused_block, i)));
+		}
+	}
+
+	pool_init_cache_block(reused_block);
+	pool_update_fsmm(reused_block, POOL_MAX_FREE_SPACE);
+
+	(*pool_fsmm_clock_hand)++;
+	if (*pool_fsmm_clock_hand >= maxblock)
+		*pool_fsmm_clock_hand = 0;
+
+	ereport(LOG,
+			(errmsg("pool_reuse_block: blockid: %d", reused_block)));
+
+	return reused_block;
+}
+
+/*
+ * Find block id which has enough space without reusing any block.
+ * Returns -1 if there's no such block.
+ */
+static POOL_CACHE_BLOCKID pool_find_block(size_t free_space)
+{
+	int			encode_value;
+	unsigned char *p = pool_fsmm_address();
+	int			i;
+	int			maxblock = pool_get_memqcache_blocks();
+	POOL_CACHE_BLOCK_HEADER *bh;
+
+	encode_value = free_space / POOL_FSMM_RATIO;
+
+	for (i = 0; i < maxblock; i++)
+	{
+		if (p[i] >= encode_value)
+		{
+			/*
+			 * This block *may" have enough space. We need to make sure it
+			 * actually has enough space.
+			 */
+			bh = (POOL_CACHE_BLOCK_HEADER *) block_address(i);
+			if (bh->free_bytes >= free_space)
+			{
+				return (POOL_CACHE_BLOCKID) i;
+			}
+		}
+	}
+
+	return -1;
+}
+
+/*
+ * Get block id which has enough space
+ */
+static POOL_CACHE_BLOCKID pool_get_block(size_t free_space)
+{
+	unsigned char *p = pool_fsmm_address();
+	POOL_CACHE_BLOCKID blockid;
+
+	if (p == NULL)
+	{
+		ereport(WARNING,
+				(errmsg("memcache: getting block: FSMM is not initialized")));
+		return -1;
+	}
+
+	if (free_space > POOL_MAX_FREE_SPACE)
+	{
+		ereport(WARNING,
+				(errmsg("memcache: getting block: invalid free space:%zd", free_space),
+				 errdetail("requested free space: %zd is more than maximum allowed space:%lu", free_space, POOL_MAX_FREE_SPACE)));
+		return -1;
+	}
+
+	blockid = pool_find_block(free_space);
+	if (blockid != -1)
+		return blockid;
+
+	/*
+	 * No enough space found. Reuse victim block
+	 */
+	return pool_reuse_block();
+}
+
+/*
+ * Update free space info for specified block
+ */
+static void
+pool_update_fsmm(POOL_CACHE_BLOCKID blockid, size_t free_space)
+{
+	int			encode_value;
+	char	   *p = pool_fsmm_address();
+
+	if (p == NULL)
+	{
+		ereport(WARNING,
+				(errmsg("memcache: updating free space in block: FSMM is not initialized")));
+		return;
+	}
+
+	if (blockid >= pool_get_memqcache_blocks())
+	{
+		ereport(WARNING,
+				(errmsg("memcache: updating free space in block: block id:%d in invalid", blockid)));
+		return;
+	}
+
+	if (free_space > POOL_MAX_FREE_SPACE)
+	{
+		ereport(WARNING,
+				(errmsg("memcache: updating free space in block: invalid free space:%zd", free_space),
+				 errdetail("requested free space: %zd is more than maximum allowed space:%lu", free_space, POOL_MAX_FREE_SPACE)));
+
+		return;
+	}
+
+	encode_value = free_space / POOL_FSMM_RATIO;
+
+	p[blockid] = encode_value;
+
+	return;
+}
+
+/*
+ * Table generation management modules.
+ *
+ * Each cache item on shmem records the generations of the tables it was
+ * built from. Modifying a table just bumps the generation of the table,
+ * and an item whose recorded generation does not match the current one
+ * is regarded as stale and deleted when it is looked up. This way cache
+ * invalidation does not need to look for the items using the table.
+ *
+ * Generations are kept in a fixed size array on shmem indexed by a hash of
+ * database oid and table oid. Tables sharing a slot only cause extra
+ * invalidation, never stale results. The database itself uses table oid 0
+ * so that DROP DATABASE invalidates all items belonging to the database.
+ *
+ * Caller must hold shmem lock before calling these functions.
+ */
+static uint32 *table_generations;
+
+/*
+ * Calculate necessary shared memory size for the table generation array.
+ */
+size_t
+pool_shared_memory_table_generation_size(void)
+{
+	return sizeof(uint32) * POOL_TABLE_GENERATION_SLOTS;
+}
+
+/*
+ * Acquire and initialize the table generation array on shmem. This should
+ * be called only once from pgpool main process at the process staring up
+ * time.
+ */
+int
+pool_init_table_generation(size_t size)
+{
+	table_generations = pool_shared_memory_create(size);
+	return 0;
+}
+
+/*
+ * Returns slot in the table generation array for the table.
+ */
+static uint32
+table_generation_slot(int dboid, int oid)
+{
+	uint32		h;
+
+	h = (uint32) dboid * 0x9e3779b1 ^ (uint32) oid;
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+
+	return h & (POOL_TABLE_GENERATION_SLOTS - 1);
+}
+
+/*
+ * Invalidate all cache items using the table. If oid is 0, all cache items
+ * belonging to the database are invalidated.
+ */
+static void
+pool_bump_table_generation(int dboid, int oid)
+{
+	table_generations[table_generation_slot(dboid, oid)]++;
+}
+
+/*
+ * Build current generations of the database and tables used by a
+ * SELECT. The array is palloc'ed and stored in *generationsp.  Returns the
+ * number of generations, or -1 if database oid cannot be obtained.
+ */
+static int
+pool_get_table_generations(int num_oids, int *oids, POOL_CACHE_TABLE_GENERATION * *generationsp)
+{
+	POOL_CACHE_TABLE_GENERATION *generations;
+	int			dboid;
+	int			i;
+
+	dboid = pool_get_database_oid();
+	if (dboid <= 0)
+	{
+		ereport(WARNING,
+				(errmsg("memcache: getting table generations, failed to get database OID")));
+		*generationsp = NULL;
+		return -1;
+	}
+
+	generations = palloc(sizeof(POOL_CACHE_TABLE_GENERATION) * (num_oids + 1));
+
+	generations[0].slot = table_generation_slot(dboid, 0);
+	generations[0].generation = table_generations[generations[0].slot];
+
+	for (i = 0; i < num_oids; i++)
+	{
+		generations[i + 1].slot = table_generation_slot(dboid, oids[i]);
+		generations[i + 1].generation = table_generations[generations[i + 1].slot];
+	}
+
+	*generationsp = generations;
+	return num_oids + 1;
+}
+
+/*
+ * Returns true if any of the tables used by the cache item has been
+ * modified since the item was cached.
+ */
+static bool
+pool_is_cache_item_stale(POOL_CACHE_ITEM_HEADER * cih)
+{
+	POOL_CACHE_TABLE_GENERATION *generations;
+	int			i;
+
+	generations = (POOL_CACHE_TABLE_GENERATION *) ((char *) cih + sizeof(POOL_CACHE_ITEM_HEADER));
+
+	for (i = 0; i < cih->num_generations; i++)
+	{
+		if (table_generations[generations[i].slot] != generations[i].generation)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Cache admission filter modules.
+ *
+ * Every lookup of the shmem cache is recorded in a frequency sketch on
+ * shmem, whether the item is found or not. When adding a new item needs
+ * to evict existing items, the new item is admitted only if its estimated
+ * frequency is higher than the one of the victim block, i.e. the highest
+ * frequency of live items in the block the clock hand points to. This
+ * keeps one-off queries from pushing hot items out of the cache.
+ *
+ * Caller must hold shmem lock before calling these functions.
+ */
+static POOL_FREQUENCY_SKETCH *frequency_sketch;
+
+/*
+ * Calculate necessary shared memory size for the frequency sketch.  The
+ * width is the maximum number of cache items rounded up to power of 2.
+ */
+size_t
+pool_shared_memory_frequency_sketch_size(void)
+{
+	uint32		width = 1;
+
+	while (width < pool_config->memqcache_max_num_cache)
+		width <<= 1;
+
+	return offsetof(POOL_FREQUENCY_SKETCH, counters) +
+		POOL_FREQUENCY_SKETCH_DEPTH * width;
+}
+
+/*
+ * Acquire and initialize the frequency sketch on shmem. This should be
+ * called only once from pgpool main process at the process staring up
+ * time.
+ */
+int
+pool_init_frequency_sketch(size_t size)
+{
+	frequency_sketch = pool_shared_memory_create(size);
+	frequency_sketch->width = (size - offsetof(POOL_FREQUENCY_SKETCH, counters)) / POOL_FREQUENCY_SKETCH_DEPTH;
+	return 0;
+}
+
+/*
+ * Returns counter index of the row for the query hash. Each row uses
+ * different 8 hex digits of the md5 hash as its hash value.
+ */
+static uint32
+frequency_sketch_index(POOL_QUERY_HASH * query_hash, int row)
+{
+	char		md5[8 + 1];
+
+	memcpy(md5, query_hash->query_hash + row * 8, 8);
+	md5[8] = '\0';
+	return row * frequency_sketch->width +
+		(strtoul(md5, NULL, 16) & (frequency_sketch->width - 1));
+}
+
+/*
+ * Record an access to the query hash
+ */
+static void
+pool_record_cache_access(POOL_QUERY_HASH * query_hash)
+{
+	uint32		limit;
+	uint32		i;
+
+	for (i = 0; i < POOL_FREQUENCY_SKETCH_DEPTH; i++)
+	{
+		unsigned char *counter = &frequency_sketch->counters[frequency_sketch_index(query_hash, i)];
+
+		if (*counter < POOL_FREQUENCY_SKETCH_MAX_COUNT)
+			(*counter)++;
+	}
+
+	/* Age the sketch so that past popularity fades away */
+	limit = frequency_sketch->width * POOL_FREQUENCY_SKETCH_SAMPLE;
+	if (++frequency_sketch->num_accesses >= limit)
+	{
+		for (i = 0; i < POOL_FREQUENCY_SKETCH_DEPTH * frequency_sketch->width; i++)
+			frequency_sketch->counters[i] >>= 1;
+		frequency_sketch->num_accesses /= 2;
+	}
+}
+
+/*
+ * Returns estimated access frequency of the query hash
+ */
+static int
+pool_estimate_cache_frequency(POOL_QUERY_HASH * query_hash)
+{
+	int			frequency = POOL_FREQUENCY_SKETCH_MAX_COUNT;
+	int			i;
+
+	for (i = 0; i < POOL_FREQUENCY_SKETCH_DEPTH; i++)
+		frequency = Min(frequency, frequency_sketch->counters[frequency_sketch_index(query_hash, i)]);
+
+	return frequency;
+}
+
+/*
+ * Returns necessary space in a block to add a cache item
+ */
+static int
+pool_cache_item_request_size(int size, int num_generations)
+{
+	return size + num_generations * sizeof(POOL_CACHE_TABLE_GENERATION) +
+		sizeof(POOL_CACHE_ITEM_POINTER) + sizeof(POOL_CACHE_ITEM_HEADER);
+}
+
+/*
+ * Returns true if a new cache item of request_size bytes should be
+ * added. If memqcache_admission_filter is off, or the item can be added
+ * without evicting any item, always returns true.
+ */
+static bool
+pool_admit_item_shmem_cache(POOL_QUERY_HASH * query_hash, int request_size)
+{
+	char	   *p;
+	POOL_CACHE_BLOCK_HEADER *bh;
+	POOL_CACHE_ITEM_POINTER *cip;
+	int			frequency;
+	int			victim_frequency = 0;
+	int			i;
+
+	if (!pool_config->memqcache_admission_filter)
+		return true;
+
+	if (is_free_hash_element() && pool_find_block(request_size) != -1)
+		return true;
+
+	frequency = pool_estimate_cache_frequency(query_hash);
+
+	p = block_address(*pool_fsmm_clock_hand);
+	bh = (POOL_CACHE_BLOCK_HEADER *) p;
+
+	for (i = 0; i < bh->num_items; i++)
+	{
+		cip = item_pointer(p, i);
+
+		if (!(POOL_ITEM_DELETED & cip->flags))
+			victim_frequency = Max(victim_frequency,
+								   pool_estimate_cache_frequency(&cip->query_hash));
+	}
+
+	ereport(DEBUG1,
+			(errmsg("memcache admission filter"),
+			 errdetail("frequency: %d victim block: %d victim frequency: %d",
+					   frequency, *pool_fsmm_clock_hand, victim_frequency)));
+
+	return frequency > victim_frequency;
+}
+
+/*
+ * Query cache snapshot modules.
+ *
+ * If memqcache_snapshot_file is set, pgpool main process saves cache
+ * blocks, FSMM, clock hand, table generations and the frequency sketch to
+ * the file at shutdown, after all child processes exited. At the next
+ * start up the file is mapped and copied back to shmem. The hash table is
+ * not saved since it holds pointers to shmem; it is rebuilt from the
+ * items instead, discarding expired items and items using modified
+ * tables. The file is removed after loading so that a snapshot is never
+ * used twice; otherwise a crash after loading would bring back items
+ * invalidated in the meantime.
+ */
+#define POOL_CACHE_SNAPSHOT_MAGIC	0x50475143	/* "PGQC" */
+#define POOL_CACHE_SNAPSHOT_VERSION	2
+
+typedef struct
+{
+	uint32		magic;			/* POOL_CACHE_SNAPSHOT_MAGIC */
+	uint32		version;		/* POOL_CACHE_SNAPSHOT_VERSION */
+	uint32		item_header_size;	/* sizeof(POOL_CACHE_ITEM_HEADER) */
+	int			block_size;		/* memqcache_cache_block_size */
+	int			num_blocks;		/* number of cache blocks */
+	uint32		generations_size;	/* size of table generation array */
+	uint32		sketch_size;	/* size of frequency sketch */
+	int			clock_hand;		/* next victim block */
+	time_t		saved_time;		/* time when the snapshot was saved */
+}			POOL_CACHE_SNAPSHOT_HEADER;
+
+/*
+ * Write data to the snapshot file. Returns false on error.
+ */
+static bool
+write_snapshot_data(int fd, const void *data, size_t size, const char *path)
+{
+	const char *p = data;
+
+	while (size > 0)
+	{
+		ssize_t		rc = write(fd, p, size);
+
+		if (rc < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			ereport(LOG,
+					(errmsg("could not write query cache snapshot file \"%s\"", path),
+					 errdetail("%s", strerror(errno))));
+			return false;
+		}
+		p += rc;
+		size -= rc;
+	}
+	return true;
+}
+
+/*
+ * Save shmem query cache to memqcache_snapshot_file. This should be called
+ * only from pgpool main process after all child processes exited.
+ */
+void
+pool_save_memqcache_snapshot(void)
+{
+	POOL_CACHE_SNAPSHOT_HEADER header;
+	char		tmp_path[POOLMAXPATHLEN + 1];
+	char	   *path = pool_config->memqcache_snapshot_file;
+	int			fd;
+	bool		ok;
 
-	for (i = 0; i < bh->num_items; i++)
+	if (shmem == NULL || path == NULL || *path == '\0')
+		return;
+
+	/* the cache is not consistent until the snapshot is loaded */
+	if (pool_is_memqcache_loading())
+		return;
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+	fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+	if (fd < 0)
 	{
-		cip = item_pointer(p, i);
+		ereport(LOG,
+				(errmsg("could not create query cache snapshot file \"%s\"", tmp_path),
+				 errdetail("%s", strerror(errno))));
+		return;
+	}
 
-		if (!(POOL_ITEM_DELETED & cip->flags))
-		{
-			pool_hash_delete(&cip->query_hash);
-			ereport(DEBUG1,
-					(errmsg("pool_reuse_block: blockid: %d item: %d", reused_block, i)));
-		}
+	memset(&header, 0, sizeof(header));
+	header.magic = POOL_CACHE_SNAPSHOT_MAGIC;
+	header.version = POOL_CACHE_SNAPSHOT_VERSION;
+	header.item_header_size = sizeof(POOL_CACHE_ITEM_HEADER);
+	header.block_size = pool_config->memqcache_cache_block_size;
+	header.num_blocks = pool_get_memqcache_blocks();
+	header.generations_size = pool_shared_memory_table_generation_size();
+	header.sketch_size = pool_shared_memory_frequency_sketch_size();
+	header.clock_hand = *pool_fsmm_clock_hand;
+	header.saved_time = time(NULL);
+
+	ok = write_snapshot_data(fd, &header, sizeof(header), tmp_path) &&
+		write_snapshot_data(fd, shmem, (size_t) header.block_size * header.num_blocks, tmp_path) &&
+		write_snapshot_data(fd, fsmm, pool_shared_memory_fsmm_size(), tmp_path) &&
+		write_snapshot_data(fd, table_generations, header.generations_size, tmp_path) &&
+		write_snapshot_data(fd, frequency_sketch, header.sketch_size, tmp_path);
+
+	if (ok && fsync(fd) != 0)
+	{
+		ereport(LOG,
+				(errmsg("could not fsync query cache snapshot file \"%s\"", tmp_path),
+				 errdetail("%s", strerror(errno))));
+		ok = false;
 	}
+	close(fd);
 
-	pool_init_cache_block(reused_block);
-	pool_update_fsmm(reused_block, POOL_MAX_FREE_SPACE);
+	if (ok && rename(tmp_path, path) != 0)
+	{
+		ereport(LOG,
+				(errmsg("could not rename query cache snapshot file \"%s\" to \"%s\"", tmp_path, path),
+				 errdetail("%s", strerror(errno))));
+		ok = false;
+	}
 
-	(*pool_fsmm_clock_hand)++;
-	if (*pool_fsmm_clock_hand >= maxblock)
-		*pool_fsmm_clock_hand = 0;
+	if (!ok)
+	{
+		unlink(tmp_path);
+		return;
+	}
 
 	ereport(LOG,
-			(errmsg("pool_reuse_block: blockid: %d", reused_block)));
-
-	return reused_block;
+			(errmsg("saved query cache snapshot to \"%s\"", path)));
 }
 
 /*
- * Get block id which has enough space
+ * Check if memqcache_snapshot_file exists. If it does, mark the query cache
+ * as being loaded and return true; the snapshot should then be loaded by
+ * pool_load_memqcache_snapshot() in a separate process so that pgpool can
+ * accept connections meanwhile. This should be called only once from
+ * pgpool main process at the process starting up time after shmem cache is
+ * initialized. If "discard" is true, the snapshot is just removed.
  */
-static POOL_CACHE_BLOCKID pool_get_block(size_t free_space)
+bool
+pool_prepare_memqcache_snapshot(bool discard)
 {
-	int			encode_value;
-	unsigned char *p = pool_fsmm_address();
-	int			i;
-	int			maxblock = pool_get_memqcache_blocks();
-	POOL_CACHE_BLOCK_HEADER *bh;
+	char	   *path = pool_config->memqcache_snapshot_file;
 
-	if (p == NULL)
-	{
-		ereport(WARNING,
-				(errmsg("memcache: getting block: FSMM is not initialized")));
-		return -1;
-	}
+	if (path == NULL || *path == '\0')
+		return false;
 
-	if (free_space > POOL_MAX_FREE_SPACE)
+	if (access(path, F_OK) != 0)
 	{
-		ereport(WARNING,
-				(errmsg("memcache: getting block: invalid free space:%zd", free_space),
-				 errdetail("requested free space: %zd is more than maximum allowed space:%lu", free_space, POOL_MAX_FREE_SPACE)));
-		return -1;
+		if (errno != ENOENT)
+			ereport(LOG,
+					(errmsg("could not access query cache snapshot file \"%s\"", path),
+					 errdetail("%s", strerror(errno))));
+		return false;
 	}
 
-	encode_value = free_space / POOL_FSMM_RATIO;
-
-	for (i = 0; i < maxblock; i++)
+	if (discard)
 	{
-		if (p[i] >= encode_value)
-		{
-			/*
-			 * This block *may" have enough space. We need to make sure it
-			 * actually has enough space.
-			 */
-			bh = (POOL_CACHE_BLOCK_HEADER *) block_address(i);
-			if (bh->free_bytes >= free_space)
-			{
-				return (POOL_CACHE_BLOCKID) i;
-			}
-		}
+		unlink(path);
+		ereport(LOG,
+				(errmsg("discarded query cache snapshot \"%s\"", path)));
+		return false;
 	}
 
 	/*
-	 * No enough space found. Reuse victim block
+	 * Tables modified while pgpool was down cannot be detected. Without
+	 * expiration restored items could return stale results forever.
 	 */
-	return pool_reuse_block();
+	if (pool_config->memqcache_expire == 0)
+	{
+		unlink(path);
+		ereport(LOG,
+				(errmsg("discarded query cache snapshot \"%s\"", path),
+				 errdetail("memqcache_expire is 0, so items cached before the shutdown would never expire")));
+		return false;
+	}
+
+	*memqcache_loading = true;
+	return true;
 }
 
 /*
- * Update free space info for specified block
+ * Load shmem query cache from memqcache_snapshot_file prepared by
+ * pool_prepare_memqcache_snapshot(). Children do not touch the cache
+ * blocks, FSMM, frequency sketch and hash table until loading is done, but
+ * they may invalidate tables concurrently. The table generations bumped
+ * since start up are added to the saved ones so that items using such
+ * tables are found stale.
  */
-static void
-pool_update_fsmm(POOL_CACHE_BLOCKID blockid, size_t free_space)
+void
+pool_load_memqcache_snapshot(void)
 {
-	int			encode_value;
-	char	   *p = pool_fsmm_address();
+	POOL_CACHE_SNAPSHOT_HEADER *header;
+	char	   *path = pool_config->memqcache_snapshot_file;
+	struct stat st;
+	char	   *addr;
+	char	   *p;
+	uint32	   *generations;
+	size_t		cache_size;
+	size_t		fsmm_size;
+	time_t		now;
+	time_t		saved_time;
+	int			fd;
+	int			nblocks;
+	int			num_loaded = 0;
+	int			num_discarded = 0;
+	int			i;
+	int			j;
 
-	if (p == NULL)
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
 	{
-		ereport(WARNING,
-				(errmsg("memcache: updating free space in block: FSMM is not initialized")));
+		ereport(LOG,
+				(errmsg("could not open query cache snapshot file \"%s\"", path),
+				 errdetail("%s", strerror(errno))));
+		pool_finish_memqcache_loading();
 		return;
 	}
 
-	if (blockid >= pool_get_memqcache_blocks())
+	nblocks = pool_get_memqcache_blocks();
+	cache_size = (size_t) pool_config->memqcache_cache_block_size * nblocks;
+	fsmm_size = pool_shared_memory_fsmm_size();
+
+	if (fstat(fd, &st) != 0 ||
+		st.st_size != sizeof(POOL_CACHE_SNAPSHOT_HEADER) + cache_size + fsmm_size +
+		pool_shared_memory_table_generation_size() + pool_shared_memory_frequency_sketch_size())
 	{
-		ereport(WARNING,
-				(errmsg("memcache: updating free space in block: block id:%d in invalid", blockid)));
+		ereport(LOG,
+				(errmsg("discarded query cache snapshot \"%s\"", path),
+				 errdetail("file size does not match current configuration")));
+		close(fd);
+		unlink(path);
+		pool_finish_memqcache_loading();
 		return;
 	}
 
-	if (free_space > POOL_MAX_FREE_SPACE)
+	addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED)
 	{
-		ereport(WARNING,
-				(errmsg("memcache: updating free space in block: invalid free space:%zd", free_space),
-				 errdetail("requested free space: %zd is more than maximum allowed space:%lu", free_space, POOL_MAX_FREE_SPACE)));
+		ereport(LOG,
+				(errmsg("could not map query cache snapshot file \"%s\"", path),
+				 errdetail("%s", strerror(errno))));
+		unlink(path);
+		pool_finish_memqcache_loading();
+		return;
+	}
 
+	header = (POOL_CACHE_SNAPSHOT_HEADER *) addr;
+	if (header->magic != POOL_CACHE_SNAPSHOT_MAGIC ||
+		header->version != POOL_CACHE_SNAPSHOT_VERSION ||
+		header->item_header_size != sizeof(POOL_CACHE_ITEM_HEADER) ||
+		header->block_size != pool_config->memqcache_cache_block_size ||
+		header->num_blocks != nblocks ||
+		header->generations_size != pool_shared_memory_table_generation_size() ||
+		header->sketch_size != pool_shared_memory_frequency_sketch_size() ||
+		header->clock_hand < 0 || header->clock_hand >= nblocks)
+	{
+		ereport(LOG,
+				(errmsg("discarded query cache snapshot \"%s\"", path),
+				 errdetail("snapshot does not match current configuration")));
+		munmap(addr, st.st_size);
+		unlink(path);
+		pool_finish_memqcache_loading();
 		return;
 	}
 
-	encode_value = free_space / POOL_FSMM_RATIO;
+	/* Copy back shmem areas */
+	p = addr + sizeof(POOL_CACHE_SNAPSHOT_HEADER);
+	memcpy(shmem, p, cache_size);
+	p += cache_size;
+	memcpy(fsmm, p, fsmm_size);
+	p += fsmm_size;
+	generations = (uint32 *) p;
+	p += header->generations_size;
+	memcpy(frequency_sketch, p, header->sketch_size);
+	*pool_fsmm_clock_hand = header->clock_hand;
+	saved_time = header->saved_time;
 
-	p[blockid] = encode_value;
+	pool_shmem_lock();
+	for (i = 0; i < POOL_TABLE_GENERATION_SLOTS; i++)
+		table_generations[i] += generations[i];
+	pool_shmem_unlock();
 
-	return;
+	munmap(addr, st.st_size);
+	unlink(path);
+
+	/*
+	 * Rebuild hash table. Expired items, items using modified tables and
+	 * items which cannot be registered to the hash table are deleted. Table
+	 * generations are read without lock here since items are checked again
+	 * when they are looked up.
+	 */
+	now = time(NULL);
+	for (i = 0; i < nblocks; i++)
+	{
+		char	   *block = block_address(i);
+		POOL_CACHE_BLOCK_HEADER *bh = (POOL_CACHE_BLOCK_HEADER *) block;
+		int			num_live = 0;
+
+		if (!(bh->flags & POOL_BLOCK_USED))
+			continue;
+
+		for (j = 0; j < bh->num_items; j++)
+		{
+			POOL_CACHE_ITEM_POINTER *cip = item_pointer(block, j);
+			POOL_CACHE_ITEM_HEADER *cih = item_header(block, j);
+			POOL_CACHEID cacheid;
+
+			if (POOL_ITEM_DELETED & cip->flags)
+				continue;
+
+			cacheid.blockid = i;
+			cacheid.itemid = j;
+
+			if ((cih->expire > 0 && now > cih->timestamp + cih->expire) ||
+				pool_is_cache_item_stale(cih) ||
+				pool_hash_insert(&cip->query_hash, &cacheid, false) < 0)
+			{
+				cip->flags |= POOL_ITEM_DELETED;
+				num_discarded++;
+				continue;
+			}
+			num_live++;
+			num_loaded++;
+		}
+
+		/* Recycle the whole block if no item remains */
+		if (num_live == 0)
+		{
+			bh->flags = 0;
+			pool_init_cache_block(i);
+			pool_update_fsmm(i, POOL_MAX_FREE_SPACE);
+		}
+	}
+
+	pool_finish_memqcache_loading();
+
+	ereport(LOG,
+			(errmsg("loaded query cache snapshot from \"%s\"", path),
+			 errdetail("%d items loaded, %d items discarded, saved %ld seconds ago",
+					   num_loaded, num_discarded, (long) (now - saved_time))));
+}
+
+/*
+ * Make the query cache available to children.
+ */
+static void
+pool_finish_memqcache_loading(void)
+{
+	pool_shmem_lock();
+	*memqcache_loading = false;
+	pool_shmem_unlock();
+}
+
+/*
+ * Called from pgpool main process when the loader process exits. If the
+ * loader did not finish loading, throw away the partially loaded cache.
+ */
+void
+pool_abort_memqcache_loading(void)
+{
+	if (!pool_is_memqcache_loading())
+		return;
+
+	ereport(LOG,
+			(errmsg("query cache snapshot was not loaded completely"),
+			 errdetail("clearing query cache")));
+
+	pool_clear_memory_cache();
+	pool_finish_memqcache_loading();
 }
 
 /*
@@ -2230,7 +3181,8 @@ pool_update_fsmm(POOL_CACHE_BLOCKID blockid, size_t free_space)
  * The cache id is overwritten by the subsequent call to this function.
  * On error returns NULL.
  */
-static POOL_CACHEID * pool_add_item_shmem_cache(POOL_QUERY_HASH * query_hash, char *data, int size, time_t expire)
+static POOL_CACHEID * pool_add_item_shmem_cache(POOL_QUERY_HASH * query_hash, char *data, int size, int raw_length, time_t expire,
+												 int num_generations, POOL_CACHE_TABLE_GENERATION * generations)
 {
 	static POOL_CACHEID cacheid;
 	POOL_CACHE_BLOCKID blockid;
@@ -2252,6 +3204,7 @@ static POOL_CACHEID * pool_add_item_shmem_cache(POOL_QUERY_HASH * query_hash, ch
 	bool		need_pack;
 	char	   *work_buffer;
 	int			index;
+	int			generations_size;
 
 	if (query_hash == NULL)
 	{
@@ -2275,7 +3228,8 @@ static POOL_CACHEID * pool_add_item_shmem_cache(POOL_QUERY_HASH * query_hash, ch
 	}
 
 	/* Add overhead */
-	request_size = size + sizeof(POOL_CACHE_ITEM_POINTER) + sizeof(POOL_CACHE_ITEM_HEADER);
+	generations_size = num_generations * sizeof(POOL_CACHE_TABLE_GENERATION);
+	request_size = pool_cache_item_request_size(size, num_generations);
 
 	/* Get cache block which has enough space */
 	blockid = pool_get_block(request_size);
@@ -2436,7 +3390,10 @@ static POOL_CACHEID * pool_add_item_shmem_cache(POOL_QUERY_HASH * query_hash, ch
 	/* Fill in cache item header */
 	ci.header.timestamp = time(NULL);
 	ci.header.expire = expire;
-	ci.header.total_length = sizeof(POOL_CACHE_ITEM_HEADER) + size;
+	ci.header.num_generations = num_generations;
+	ci.header.num_hits = 0;
+	ci.header.raw_length = raw_length;
+	ci.header.total_length = sizeof(POOL_CACHE_ITEM_HEADER) + generations_size + size;
 
 	/* Calculate item body address */
 	if (bh->num_items == 0)
@@ -2459,8 +3416,15 @@ static POOL_CACHEID * pool_add_item_shmem_cache(POOL_QUERY_HASH * query_hash, ch
 	memcpy(item, &ci, sizeof(POOL_CACHE_ITEM_HEADER));
 	bh->free_bytes -= sizeof(POOL_CACHE_ITEM_HEADER);
 
+	/* Copy table generations */
+	if (num_generations > 0)
+	{
+		memcpy(item + sizeof(POOL_CACHE_ITEM_HEADER), generations, generations_size);
+		bh->free_bytes -= generations_size;
+	}
+
 	/* Copy item body */
-	memcpy(item + sizeof(POOL_CACHE_ITEM_HEADER), data, size);
+	memcpy(item + sizeof(POOL_CACHE_ITEM_HEADER) + generations_size, data, size);
 	bh->free_bytes -= size;
 
 	/* Copy cache item pointer */
@@ -2514,7 +3478,7 @@ static POOL_CACHEID * pool_add_item_shmem_cache(POOL_QUERY_HASH * query_hash, ch
  * Detail is set to *sts. (0: success, 1: not found, -1: error)
  */
 static char *
-pool_get_item_shmem_cache(POOL_QUERY_HASH * query_hash, int *size, int *sts)
+pool_get_item_shmem_cache(POOL_QUERY_HASH * query_hash, int *size, int *raw_length, int *sts)
 {
 	POOL_CACHEID *cacheid;
 	POOL_CACHE_ITEM_HEADER *cih;
@@ -2554,9 +3518,11 @@ pool_get_item_shmem_cache(POOL_QUERY_HASH * query_hash, int *size, int *sts)
 	}
 
 	cih = pool_cache_item_header(cacheid);
+	cih->num_hits++;
 
-	*size = cih->total_length - sizeof(POOL_CACHE_ITEM_HEADER);
-	return (char *) cih + sizeof(POOL_CACHE_ITEM_HEADER);
+	*size = cih->total_length - POOL_CACHE_ITEM_DATA_OFFSET(cih);
+	*raw_length = cih->raw_length;
+	return (char *) cih + POOL_CACHE_ITEM_DATA_OFFSET(cih);
 }
 
 /*
@@ -2594,6 +3560,17 @@ static POOL_CACHEID * pool_find_item_on_shmem_cache(POOL_QUERY_HASH * query_hash
 		}
 	}
 
+	/* Check if any table used by the item has been modified */
+	if (pool_is_cache_item_stale(cih))
+	{
+		ereport(DEBUG1,
+				(errmsg("memcache finding item"),
+				 errdetail("cache is stale: blockid: %d itemid: %d",
+						   c->blockid, c->itemid)));
+		pool_delete_item_shmem_cache(c);
+		return NULL;
+	}
+
 	cacheid.blockid = c->blockid;
 	cacheid.itemid = c->itemid;
 	return &cacheid;
@@ -3360,21 +4337,32 @@ pool_handle_query_cache(POOL_CONNECTION_POOL * backend, char *query, Node *node,
 			if (!pool_is_cache_exceeded())
 			{
 				POOL_TEMP_QUERY_CACHE *cache;
+				char	   *data;
+				size_t		datalen;
+				int			raw_length;
 
 				/*
 				 * If we are not inside a transaction, we can immediately
 				 * register to cache storage.
 				 */
+				cache_buffer = pool_get_current_cache_buffer(&len);
+
+				/* Compress the data before taking the lock */
+				data = cache_buffer;
+				datalen = len;
+				raw_length = 0;
+				if (cache_buffer && session_context->query_context->skip_cache_commit == false)
+					raw_length = pool_compress_cache_data(&data, &datalen);
+
 				/* Register to memcached or shmem */
 				POOL_SETMASK2(&BlockSig, &oldmask);
 				pool_shmem_lock();
 
-				cache_buffer = pool_get_current_cache_buffer(&len);
 				if (cache_buffer)
 				{
 					if (session_context->query_context->skip_cache_commit == false)
 					{
-						if (pool_commit_cache(backend, query, cache_buffer, len, num_oids, oids) != 0)
+						if (pool_commit_cache(backend, query, data, datalen, raw_length, num_oids, oids) != 0)
 						{
 							ereport(WARNING,
 									(errmsg("ReadyForQuery: pool_commit_cache failed")));
@@ -3404,6 +4392,9 @@ pool_handle_query_cache(POOL_CONNECTION_POOL * backend, char *query, Node *node,
 				}
 				pool_shmem_unlock();
 				POOL_SETMASK(&oldmask);
+
+				if (raw_length > 0)
+					pfree(data);
 			}
 
 			/* Count up SELECT stats */
@@ -3469,6 +4460,38 @@ pool_handle_query_cache(POOL_CONNECTION_POOL * backend, char *query, Node *node,
 	else if (is_commit_query(node)) /* Commit? */
 	{
 		int			num_caches;
+		char	  **datas;
+		size_t	   *datalens;
+		int		   *raw_lengths;
+
+		/*--------------------------------------------------------------------
+		 * If we have something in the query cache buffer, that means either:
+		 * - We only had SELECTs in the transaction
+		 * - We had only SELECTs after the last DML
+		 * Thus we can register SELECT results to cache storage.
+		 *
+		 * Get and compress the data before taking the lock.
+		 *--------------------------------------------------------------------
+		 */
+		num_caches = session_context->query_cache_array->num_caches;
+		datas = palloc0(sizeof(char *) * (num_caches + 1));
+		datalens = palloc0(sizeof(size_t) * (num_caches + 1));
+		raw_lengths = palloc0(sizeof(int) * (num_caches + 1));
+		for (i = 0; i < num_caches; i++)
+		{
+			POOL_TEMP_QUERY_CACHE *cache;
+
+			cache = session_context->query_cache_array->caches[i];
+			if (!cache || cache->is_discarded)
+				continue;
+
+			cache_buffer = pool_get_buffer(cache->buffer, &len);
+			datas[i] = cache_buffer;
+			datalens[i] = len;
+			raw_lengths[i] = pool_compress_cache_data(&datas[i], &datalens[i]);
+			if (raw_lengths[i] > 0)
+				pfree(cache_buffer);
+		}
 
 		POOL_SETMASK2(&BlockSig, &oldmask);
 		pool_shmem_lock();
@@ -3480,14 +4503,6 @@ pool_handle_query_cache(POOL_CONNECTION_POOL * backend, char *query, Node *node,
 			pool_invalidate_query_cache(num_oids, oids, true, 0);
 		}
 
-		/*--------------------------------------------------------------------
-		 * If we have something in the query cache buffer, that means either:
-		 * - We only had SELECTs in the transaction
-		 * - We had only SELECTs after the last DML
-		 * Thus we can register SELECT results to cache storage.
-		 *--------------------------------------------------------------------
-		 */
-		num_caches = session_context->query_cache_array->num_caches;
 		for (i = 0; i < num_caches; i++)
 		{
 			POOL_TEMP_QUERY_CACHE *cache;
@@ -3498,21 +4513,27 @@ pool_handle_query_cache(POOL_CONNECTION_POOL * backend, char *query, Node *node,
 
 			num_oids = cache->num_oids;
 			oids = pool_get_buffer(cache->oids, &len);
-			cache_buffer = pool_get_buffer(cache->buffer, &len);
 
-			if (pool_commit_cache(backend, cache->query, cache_buffer, len, num_oids, oids) != 0)
+			if (pool_commit_cache(backend, cache->query, datas[i], datalens[i], raw_lengths[i], num_oids, oids) != 0)
 			{
 				ereport(WARNING,
 						(errmsg("ReadyForQuery: pool_commit_cache failed")));
 			}
 			if (oids)
 				pfree(oids);
-			if (cache_buffer)
-				pfree(cache_buffer);
 		}
 		pool_shmem_unlock();
 		POOL_SETMASK(&oldmask);
 
+		for (i = 0; i < num_caches; i++)
+		{
+			if (datas[i])
+				pfree(datas[i]);
+		}
+		pfree(datas);
+		pfree(datalens);
+		pfree(raw_lengths);
+
 		/* Count up number of SELECT stats */
 		pool_stats_count_up_num_selects(pool_tmp_stats_get_num_selects());
 
@@ -3544,6 +4565,24 @@ pool_handle_query_cache(POOL_CONNECTION_POOL * backend, char *query, Node *node,
 		{
 			int			dboid = session_context->query_context->dboid;
 
+			/*
+			 * In shmem case, bumping the database generation invalidates all
+			 * cache items belonging to the database.
+			 */
+			if (pool_is_shmem_cache())
+			{
+				if (pool_config->memqcache_auto_cache_invalidation)
+				{
+					POOL_SETMASK2(&BlockSig, &oldmask);
+					pool_shmem_lock();
+					pool_bump_table_generation(dboid, 0);
+					pool_shmem_unlock();
+					POOL_SETMASK(&oldmask);
+					pool_reset_memqcache_buffer(true);
+				}
+				return;
+			}
+
 			num_oids = pool_get_dropdb_table_oids(&oids, dboid);
 
 			if (num_oids > 0 && pool_config->memqcache_auto_cache_invalidation)
@@ -4217,6 +5256,73 @@ pool_get_shmem_storage_stats(void)
 	return &mystats;
 }
 
+/*
+ * Get statistics of each live cache item on shmem for SHOW
+ * POOL_CACHE_ENTRIES. Returns palloc'ed array and the number of items is
+ * set to *nrows. Caller must hold shmem lock.
+ */
+POOL_CACHE_ENTRY_STATS *
+pool_get_shmem_cache_entries(int *nrows)
+{
+	POOL_CACHE_ENTRY_STATS *entries;
+	int			array_size = 128;
+	int			nblocks;
+	int			n = 0;
+	int			i;
+	int			j;
+
+	entries = palloc(sizeof(POOL_CACHE_ENTRY_STATS) * array_size);
+
+	if (!pool_config->memory_cache_enabled || !pool_is_shmem_cache())
+	{
+		*nrows = 0;
+		return entries;
+	}
+
+	nblocks = pool_get_memqcache_blocks();
+
+	for (i = 0; i < nblocks; i++)
+	{
+		char	   *p = block_address(i);
+		POOL_CACHE_BLOCK_HEADER *bh = (POOL_CACHE_BLOCK_HEADER *) p;
+
+		if (!(bh->flags & POOL_BLOCK_USED))
+			continue;
+
+		for (j = 0; j < bh->num_items; j++)
+		{
+			POOL_CACHE_ITEM_POINTER *cip = item_pointer(p, j);
+			POOL_CACHE_ITEM_HEADER *cih;
+			POOL_CACHE_ENTRY_STATS *e;
+
+			if (POOL_ITEM_DELETED & cip->flags)
+				continue;
+
+			if (n >= array_size)
+			{
+				array_size *= 2;
+				entries = repalloc(entries, sizeof(POOL_CACHE_ENTRY_STATS) * array_size);
+			}
+
+			cih = item_header(p, j);
+			e = &entries[n++];
+			e->cacheid.blockid = i;
+			e->cacheid.itemid = j;
+			memcpy(e->query_hash, cip->query_hash.query_hash, POOL_MD5_HASHKEYLEN);
+			e->query_hash[POOL_MD5_HASHKEYLEN] = '\0';
+			e->size = cih->total_length + sizeof(POOL_CACHE_ITEM_POINTER);
+			e->raw_size = cih->raw_length;
+			e->num_hits = cih->num_hits;
+			e->frequency = pool_estimate_cache_frequency(&cip->query_hash);
+			e->timestamp = cih->timestamp;
+			e->expire = cih->expire;
+		}
+	}
+
+	*nrows = n;
+	return entries;
+}
+
 /*
  * Inject cached message to the target backend buffer to pretend as if backend
  * actually replies with Data row and Command Complete message.
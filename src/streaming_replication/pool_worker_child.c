@@ -63,6 +63,7 @@
 
 char		remote_ps_data[NI_MAXHOST]; /* used for set_ps_display */
 static POOL_CONNECTION_POOL_SLOT * slots[MAX_NUM_BACKENDS];
+static int	server_version[MAX_NUM_BACKENDS];	/* backend server version cache */
 static volatile sig_atomic_t reload_config_request = 0;
 static volatile sig_atomic_t restart_request = 0;
 
@@ -70,7 +71,11 @@ static void establish_persistent_connection(void);
 static void discard_persistent_connection(void);
 static void check_replication_time_lag(void);
 static void CheckReplicationTimeLagErrorCb(void *arg);
-static unsigned long long int text_to_lsn(char *text);
+static void sample_replication_lag(void);
+static void sample_replication_lag_for(int seconds);
+static void send_lsn_query(int node_id);
+static unsigned long long int read_lsn_result(int node_id);
+static void record_replication_lag(int node_id, uint64 delay);
 static RETSIGTYPE my_signal_handler(int sig);
 static RETSIGTYPE reload_config_handler(int sig);
 static void reload_config(void);
@@ -202,6 +207,25 @@ do_worker_child(void)
 			}
 			PG_END_TRY();
 
+			/*
+			 * Sample replication delay until next check if requested.
+			 * Persistent connections are kept meanwhile.
+			 */
+			if (pool_config->sr_check_sampling_interval > 0)
+			{
+				PG_TRY();
+				{
+					sample_replication_lag_for(pool_config->sr_check_period);
+				}
+				PG_CATCH();
+				{
+					discard_persistent_connection();
+					PG_RE_THROW();
+				}
+				PG_END_TRY();
+				continue;
+			}
+
 			/* Discard persistent connections */
 			discard_persistent_connection();
 		}
@@ -218,10 +242,17 @@ establish_persistent_connection(void)
 {
 	int			i;
 	BackendInfo *bkinfo;
+	MemoryContext oldContext;
 
 	char	   *password = get_pgpool_config_user_password(pool_config->sr_check_user,
 														   pool_config->sr_check_password);
 
+	/*
+	 * The connections may be kept across loop iterations for sampling
+	 * replication delay, so they must survive the per loop memory context.
+	 */
+	oldContext = MemoryContextSwitchTo(TopMemoryContext);
+
 	for (i = 0; i < NUM_BACKENDS; i++)
 	{
 		if (!VALID_BACKEND(i))
@@ -238,6 +269,8 @@ establish_persistent_connection(void)
 		}
 	}
 
+	MemoryContextSwitchTo(oldContext);
+
 	if (password)
 		pfree(password);
 }
@@ -266,9 +299,6 @@ discard_persistent_connection(void)
 static void
 check_replication_time_lag(void)
 {
-	/* backend server version cache */
-	static int	server_version[MAX_NUM_BACKENDS];
-
 	int			i;
 	POOL_SELECT_RESULT *res;
 	POOL_SELECT_RESULT *res_rep;	/* query results of pg_stat_replication */
@@ -430,6 +460,7 @@ check_replication_time_lag(void)
 
 		/* Set standby delay value */
 		bkinfo = pool_get_node_info(i);
+		bkinfo->replay_lsn = lsn[i];
 		lag = (lsn[PRIMARY_NODE_ID] > lsn[i]) ? lsn[PRIMARY_NODE_ID] - lsn[i] : 0;
 
 		if (PRIMARY_NODE_ID == i)
@@ -439,6 +470,7 @@ check_replication_time_lag(void)
 		else
 		{
 			bkinfo->standby_delay = lag;
+			record_replication_lag(i, lag);
 
 			/* Log delay if necessary */
 			if ((pool_config->log_standby_delay == LSD_ALWAYS && lag > 0) ||
@@ -463,9 +495,210 @@ CheckReplicationTimeLagErrorCb(void *arg)
 }
 
 /*
- * Convert logid/recoff style text to 64bit log location (LSN)
+ * Sample replication delay every sr_check_sampling_interval milliseconds
+ * for the given seconds.
+ */
+static void
+sample_replication_lag_for(int seconds)
+{
+	struct timeval start,
+				now;
+
+	gettimeofday(&start, NULL);
+
+	for (;;)
+	{
+		CHECK_REQUEST;
+
+		if (pool_config->sr_check_sampling_interval <= 0)
+		{
+			discard_persistent_connection();
+			break;
+		}
+
+		gettimeofday(&now, NULL);
+		if ((now.tv_sec - start.tv_sec) * 1000L + (now.tv_usec - start.tv_usec) / 1000 >=
+			seconds * 1000L)
+			break;
+
+		sample_replication_lag();
+		usleep(pool_config->sr_check_sampling_interval * 1000L);
+	}
+}
+
+/*
+ * Lightweight version of check_replication_time_lag(). Only WAL locations
+ * are taken using the persistent connections. The queries are sent to all
+ * nodes before reading any result so that they are executed concurrently.
+ */
+static void
+sample_replication_lag(void)
+{
+	unsigned long long int lsn[MAX_NUM_BACKENDS];
+	bool		sent[MAX_NUM_BACKENDS];
+	BackendInfo *bkinfo;
+	uint64		lag;
+	int			i;
+
+	if (NUM_BACKENDS <= 1 || REAL_PRIMARY_NODE_ID < 0)
+		return;
+
+	for (i = 0; i < NUM_BACKENDS; i++)
+	{
+		sent[i] = false;
+		lsn[i] = 0;
+
+		/* Server version is taken by check_replication_time_lag() */
+		if (!VALID_BACKEND(i) || !slots[i] || server_version[i] == 0)
+			continue;
+
+		send_lsn_query(i);
+		sent[i] = true;
+	}
+
+	for (i = 0; i < NUM_BACKENDS; i++)
+	{
+		if (sent[i])
+			lsn[i] = read_lsn_result(i);
+	}
+
+	if (!sent[PRIMARY_NODE_ID] || lsn[PRIMARY_NODE_ID] == 0)
+		return;
+
+	for (i = 0; i < NUM_BACKENDS; i++)
+	{
+		if (!sent[i])
+			continue;
+
+		bkinfo = pool_get_node_info(i);
+		bkinfo->replay_lsn = lsn[i];
+
+		if (i == PRIMARY_NODE_ID)
+			continue;
+
+		lag = (lsn[PRIMARY_NODE_ID] > lsn[i]) ? lsn[PRIMARY_NODE_ID] - lsn[i] : 0;
+		bkinfo->standby_delay = lag;
+		record_replication_lag(i, lag);
+	}
+}
+
+/*
+ * Send the query to get WAL location without waiting for the result.
+ */
+static void
+send_lsn_query(int node_id)
+{
+	POOL_CONNECTION *con = slots[node_id]->con;
+	char	   *query;
+	int			len;
+
+	if (PRIMARY_NODE_ID == node_id)
+	{
+		if (server_version[node_id] >= PG10_SERVER_VERSION)
+			query = "SELECT pg_current_wal_lsn()";
+		else
+			query = "SELECT pg_current_xlog_location()";
+	}
+	else
+	{
+		if (server_version[node_id] >= PG10_SERVER_VERSION)
+			query = "SELECT pg_last_wal_replay_lsn()";
+		else
+			query = "SELECT pg_last_xlog_replay_location()";
+	}
+
+	pool_write(con, "Q", 1);
+	len = htonl(sizeof(len) + strlen(query) + 1);
+	pool_write(con, &len, sizeof(len));
+	pool_write_and_flush(con, query, strlen(query) + 1);
+}
+
+/*
+ * Read the result of send_lsn_query(). Returns 0 if the query failed or
+ * returned NULL.
  */
 static unsigned long long int
+read_lsn_result(int node_id)
+{
+	POOL_CONNECTION *con = slots[node_id]->con;
+	unsigned long long int lsn = 0;
+	char		kind;
+	int			len;
+	char	   *buf;
+	char		text[64];
+	int16		num_fields;
+	int32		col_len;
+
+	for (;;)
+	{
+		pool_read_with_error(con, &kind, sizeof(kind), "reading WAL location");
+		pool_read_with_error(con, &len, sizeof(len), "reading WAL location");
+		len = ntohl(len) - sizeof(len);
+		buf = len > 0 ? pool_read2(con, len) : NULL;
+
+		switch (kind)
+		{
+			case 'D':			/* DataRow */
+				memcpy(&num_fields, buf, sizeof(num_fields));
+				memcpy(&col_len, buf + sizeof(num_fields), sizeof(col_len));
+				col_len = ntohl(col_len);
+				if (ntohs(num_fields) == 1 && col_len > 0 && col_len < sizeof(text))
+				{
+					memcpy(text, buf + sizeof(num_fields) + sizeof(col_len), col_len);
+					text[col_len] = '\0';
+					lsn = text_to_lsn(text);
+				}
+				break;
+
+			case 'E':			/* ErrorResponse */
+				lsn = 0;
+				break;
+
+			case 'Z':			/* ReadyForQuery */
+				return lsn;
+
+			default:
+				break;
+		}
+	}
+}
+
+/*
+ * Add a replication delay sample to the history of the node.
+ */
+static void
+record_replication_lag(int node_id, uint64 delay)
+{
+	ReplicationLagHistory *history = &replication_lag_history[node_id];
+	ReplicationLagSample *sample = &history->samples[history->next];
+
+	gettimeofday(&sample->sample_time, NULL);
+	sample->delay = delay;
+	history->next = (history->next + 1) % REPLICATION_LAG_HISTORY_SIZE;
+}
+
+/*
+ * Return the largest replication delay of the node in the history.
+ */
+uint64
+get_replication_lag_peak(int node_id)
+{
+	ReplicationLagHistory *history = &replication_lag_history[node_id];
+	uint64		peak = 0;
+	int			i;
+
+	for (i = 0; i < REPLICATION_LAG_HISTORY_SIZE; i++)
+	{
+		if (history->samples[i].delay > peak)
+			peak = history->samples[i].delay;
+	}
+	return peak;
+}
+
+/*
+ * Convert logid/recoff style text to 64bit log location (LSN)
+ */
+unsigned long long int
 text_to_lsn(char *text)
 {
 /*
@@ -24,46 +24,79 @@ echo "done."
 echo "log_min_messages = debug1" >> etc/pgpool.conf
 echo "enable_shared_relcache = on" >> etc/pgpool.conf
 echo "relcache_expire = 60" >> etc/pgpool.conf
+echo "log_per_node_statement = on" >> etc/pgpool.conf
+echo "check_unlogged_table = on" >> etc/pgpool.conf
+# send load balanced SELECTs to the standby
+echo "backend_weight0 = 0" >> etc/pgpool.conf
+echo "backend_weight1 = 1" >> etc/pgpool.conf
 
-for mode in shmem memcached
+source ./bashrc.ports
+
+export PGPORT=$PGPOOL_PORT
+
+./startall
+wait_for_pgpool_startup
+
+# initialize tables
+$PGBENCH -i test
+
+$PGBENCH -C -S -c 2 -t 10 test
+
+# SELECTs on an unlogged table are not load balanced. Let child processes
+# cache that t1 is unlogged, then recreate it as a regular table in
+# another child process.
+$PSQL -c "CREATE UNLOGGED TABLE t1(i int)" test
+for i in 1 2 3 4 5 6 7 8 9 10
+do
+	$PSQL -c "SELECT * FROM t1 /* before */" test > /dev/null
+done
+$PSQL -c "DROP TABLE t1" test
+$PSQL -c "CREATE TABLE t1(i int)" test
+# wait for the standby to replay the DDL
+sleep 2
+for i in 1 2 3 4 5 6 7 8 9 10
 do
-	if [ $mode = "shmem" ];then
-		echo "memqcache_method = 'shmem'" >> etc/pgpool.conf
-	elif [ $mode = "memcached" ];then
-		echo "memqcache_method = 'memcached'" >> etc/pgpool.conf
-	fi
-
-	source ./bashrc.ports
-
-	export PGPORT=$PGPOOL_PORT
-
-	./startall
-	wait_for_pgpool_startup
-
-    # initialize tables
-    $PGBENCH -i test
-
-    $PGBENCH -C -S -c 2 -t 10 test
-
-	./shutdownall
-
-	echo "SELECT query don not use query cache"
-	grep "commiting SELECT results to cache storage" log/pgpool.log > /dev/null 2>&1
-	if [ $? != 0 ];then
-		echo "... ok."
-	else
-		echo "... failed."
-		exit 1
-	fi
-
-	echo "relation cache use query cache"
-	grep "commiting relation cache to cache storage" log/pgpool.log > /dev/null 2>&1
-	if [ $? = 0 ];then
-		echo "... ok."
-	else
-		echo "... failed."
-		exit 1
-	fi
+	$PSQL -c "SELECT * FROM t1 /* after */" test > /dev/null
 done
 
+./shutdownall
+
+echo "SELECT query don not use query cache"
+grep "commiting SELECT results to cache storage" log/pgpool.log > /dev/null 2>&1
+if [ $? != 0 ];then
+	echo "... ok."
+else
+	echo "... failed."
+	exit 1
+fi
+
+echo "relation cache is shared among child processes"
+grep "hit shared relation cache" log/pgpool.log > /dev/null 2>&1
+if [ $? = 0 ];then
+	echo "... ok."
+else
+	echo "... failed."
+	exit 1
+fi
+
+echo "SELECT on an unlogged table is sent to primary"
+grep "DB node id: 0 .*/\* before \*/" log/pgpool.log > /dev/null 2>&1 &&
+! grep "DB node id: 1 .*/\* before \*/" log/pgpool.log > /dev/null 2>&1
+if [ $? = 0 ];then
+	echo "... ok."
+else
+	echo "... failed."
+	exit 1
+fi
+
+echo "SELECT on a table recreated by DDL is load balanced"
+grep "DB node id: 1 .*/\* after \*/" log/pgpool.log > /dev/null 2>&1 &&
+! grep "DB node id: 0 .*/\* after \*/" log/pgpool.log > /dev/null 2>&1
+if [ $? = 0 ];then
+	echo "... ok."
+else
+	echo "... failed."
+	exit 1
+fi
+
 exit 0
@@ -0,0 +1,63 @@
+#!/usr/bin/env bash
+#-------------------------------------------------------------------
+# test script for read_your_writes with extended-query protocol.
+# After a write, the WAL location of the primary must be taken before
+# ReadyForQuery is returned, even if the write was done by an extended
+# query or is followed by other messages in the same pipeline.
+#
+source $TESTLIBS
+TESTDIR=testdir
+PSQL=$PGBIN/psql
+WHOAMI=`whoami`
+timeout=30
+num_tests=2
+success_count=0
+
+rm -fr $TESTDIR
+mkdir $TESTDIR
+cd $TESTDIR
+
+# create test environment
+echo -n "creating test environment..."
+$PGPOOL_SETUP -m s -n 2 || exit 1
+echo "done."
+
+source ./bashrc.ports
+
+export PGPORT=$PGPOOL_PORT
+
+echo "read_your_writes = on" >> etc/pgpool.conf
+echo "log_per_node_statement = on" >> etc/pgpool.conf
+
+./startall
+wait_for_pgpool_startup
+
+$PSQL -c "CREATE TABLE t1(i int)" test
+
+cp -r ../tests ./
+
+for i in extended_write pipelined_write
+do
+	echo -n "testing $i ..."
+	start=`wc -l < log/pgpool.log`
+	timeout $timeout $PGPOOL_INSTALL_DIR/bin/pgproto -u $WHOAMI -p $PGPOOL_PORT -d test -f tests/$i.data
+	tail -n +$start log/pgpool.log | grep -E "DB node id: 0 .*pg_current_(wal_lsn|xlog_location)" >/dev/null 2>&1
+	if [ $? = 0 ];then
+		echo "success: write LSN was taken"
+		success_count=$(( success_count + 1 ))
+	else
+		echo "failed: write LSN was not taken"
+	fi
+done
+
+./shutdownall
+
+cd ..
+
+echo "$success_count out of $num_tests successfull";
+
+if test $success_count -eq $num_tests
+then
+    exit 0
+fi
+exit 1
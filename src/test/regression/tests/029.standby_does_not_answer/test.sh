@@ -0,0 +1,73 @@
+#!/usr/bin/env bash
+#-------------------------------------------------------------------
+# test script for primary node verification with a standby which does
+# not answer. The standby must be ignored without crashing pgpool while
+# detach_false_primary checks the connectivity among the nodes.
+#
+source $TESTLIBS
+TESTDIR=testdir
+PSQL=$PGBIN/psql
+export PGDATABASE=test
+
+rm -fr $TESTDIR
+mkdir $TESTDIR
+cd $TESTDIR
+
+version=`$PSQL --version|awk '{print $3}'`
+result=`echo "$version >= 9.6"|bc`
+if [ $result = 0 ];then
+    echo "PostgreSQL version $version is 9.5 or before. Skipping test."
+    exit 0
+fi
+
+# create test environment
+echo -n "creating test environment..."
+$PGPOOL_SETUP -m s -n 3 || exit 1
+echo "done."
+
+source ./bashrc.ports
+
+echo "detach_false_primary = on" >> etc/pgpool.conf
+echo "sr_check_period = 1" >> etc/pgpool.conf
+echo "connect_timeout = 1000" >> etc/pgpool.conf
+echo "health_check_period = 0" >> etc/pgpool.conf
+./startall
+export PGPORT=$PGPOOL_PORT
+wait_for_pgpool_startup
+
+# stop node 2 and its backends without closing the connections
+postmaster=`head -1 data2/postmaster.pid`
+pkill -STOP -P $postmaster
+kill -STOP $postmaster
+
+sleep 10
+
+kill -CONT $postmaster
+pkill -CONT -P $postmaster
+
+grep "did not reply to pg_is_in_recovery() in time" log/pgpool.log
+if [ $? != 0 ];then
+    echo "node 2 was not checked"
+    ./shutdownall
+    exit 1
+fi
+
+grep -i "segmentation fault" log/pgpool.log
+if [ $? = 0 ];then
+    echo "pgpool crashed"
+    ./shutdownall
+    exit 1
+fi
+
+wait_for_pgpool_startup
+$PSQL -c "show pool_nodes" postgres > show_pool_nodes
+primary_node=`grep primary show_pool_nodes|awk '{print $1}'`
+if [ "$primary_node" != 0 ];then
+    echo "primary node is not 0"
+    ./shutdownall
+    exit 1
+fi
+
+./shutdownall
+
+exit 0
@@ -0,0 +1,88 @@
+#!/usr/bin/env bash
+#-------------------------------------------------------------------
+# test script for invalidation of shmem query cache by table generations.
+# A write to a table must invalidate the cached SELECTs using the table,
+# while the cached SELECTs of other tables are still used.
+#
+source $TESTLIBS
+TESTDIR=testdir
+PSQL=$PGBIN/psql
+num_tests=3
+success_count=0
+
+rm -fr $TESTDIR
+mkdir $TESTDIR
+cd $TESTDIR
+
+# create test environment
+echo -n "creating test environment..."
+$PGPOOL_SETUP -m s -n 2 || exit 1
+echo "done."
+
+source ./bashrc.ports
+
+export PGPORT=$PGPOOL_PORT
+
+echo "memory_cache_enabled = on" >> etc/pgpool.conf
+echo "memqcache_method = 'shmem'" >> etc/pgpool.conf
+echo "memqcache_auto_cache_invalidation = on" >> etc/pgpool.conf
+
+./startall
+wait_for_pgpool_startup
+
+$PSQL test <<EOF
+CREATE TABLE t1 (i int);
+CREATE TABLE t2 (i int);
+INSERT INTO t1 VALUES(1);
+INSERT INTO t2 VALUES(1);
+SELECT pg_sleep(2);	-- Sleep for a while to make sure object creations are replicated
+SELECT * FROM t1;
+SELECT * FROM t2;
+EOF
+
+# write to t1 in another session
+$PSQL -c "INSERT INTO t1 VALUES(2)" test
+sleep 2
+
+start=`wc -l < log/pgpool.log`
+$PSQL -t -c "SELECT * FROM t1" test > result_t1
+$PSQL -t -c "SELECT * FROM t2" test > /dev/null
+tail -n +$start log/pgpool.log > log_after_write
+
+echo -n "cached SELECT of the written table is invalidated..."
+grep "fetched from cache. statement: SELECT \* FROM t1" log_after_write > /dev/null 2>&1
+if [ $? != 0 ];then
+	echo "ok."
+	success_count=$(( success_count + 1 ))
+else
+	echo "failed."
+fi
+
+echo -n "SELECT after the write returns the new row..."
+if [ `grep -c "[12]" result_t1` = 2 ];then
+	echo "ok."
+	success_count=$(( success_count + 1 ))
+else
+	echo "failed."
+fi
+
+echo -n "cached SELECT of other table is still used..."
+grep "fetched from cache. statement: SELECT \* FROM t2" log_after_write > /dev/null 2>&1
+if [ $? = 0 ];then
+	echo "ok."
+	success_count=$(( success_count + 1 ))
+else
+	echo "failed."
+fi
+
+./shutdownall
+
+cd ..
+
+echo "$success_count out of $num_tests successfull";
+
+if test $success_count -eq $num_tests
+then
+    exit 0
+fi
+exit 1
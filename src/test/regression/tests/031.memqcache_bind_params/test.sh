@@ -0,0 +1,83 @@
+#!/usr/bin/env bash
+#-------------------------------------------------------------------
+# test script for query cache keys of extended queries. The same
+# statement executed with different bind parameters must not share a
+# cache entry.
+#
+source $TESTLIBS
+TESTDIR=testdir
+PSQL=$PGBIN/psql
+WHOAMI=`whoami`
+timeout=30
+num_tests=2
+success_count=0
+
+rm -fr $TESTDIR
+mkdir $TESTDIR
+cd $TESTDIR
+
+# create test environment
+echo -n "creating test environment..."
+$PGPOOL_SETUP -m s -n 2 || exit 1
+echo "done."
+
+source ./bashrc.ports
+
+export PGPORT=$PGPOOL_PORT
+
+echo "memory_cache_enabled = on" >> etc/pgpool.conf
+echo "memqcache_method = 'shmem'" >> etc/pgpool.conf
+
+./startall
+wait_for_pgpool_startup
+
+$PSQL test <<EOF
+CREATE TABLE t1 (i int);
+INSERT INTO t1 VALUES(1);
+INSERT INTO t1 VALUES(2);
+INSERT INTO t1 VALUES(2);
+SELECT pg_sleep(2);	-- Sleep for a while to make sure object creations are replicated
+EOF
+
+cp -r ../tests ./
+
+timeout $timeout $PGPOOL_INSTALL_DIR/bin/pgproto -u $WHOAMI -p $PGPOOL_PORT -d test -f tests/bind_params.data > pgproto.out 2>&1
+
+cat > expected <<EOF
+<= BE CommandComplete(SELECT 1)
+<= BE CommandComplete(SELECT 2)
+<= BE CommandComplete(SELECT 1)
+<= BE CommandComplete(SELECT 2)
+EOF
+
+echo -n "each bind parameter returns its own result..."
+grep "CommandComplete" pgproto.out > result
+cmp expected result > /dev/null 2>&1
+if [ $? = 0 ];then
+	echo "ok."
+	success_count=$(( success_count + 1 ))
+else
+	echo "failed."
+	cat pgproto.out
+fi
+
+echo -n "results are fetched from cache..."
+grep "fetched from cache" log/pgpool.log > /dev/null 2>&1
+if [ $? = 0 ];then
+	echo "ok."
+	success_count=$(( success_count + 1 ))
+else
+	echo "failed."
+fi
+
+./shutdownall
+
+cd ..
+
+echo "$success_count out of $num_tests successfull";
+
+if test $success_count -eq $num_tests
+then
+    exit 0
+fi
+exit 1
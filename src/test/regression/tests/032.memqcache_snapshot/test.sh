@@ -0,0 +1,104 @@
+#!/usr/bin/env bash
+#-------------------------------------------------------------------
+# test script for memqcache_snapshot_file. The shmem query cache saved at
+# shutdown must be restored at the next start up, except the entries of
+# tables written before the shutdown.
+#
+source $TESTLIBS
+TESTDIR=testdir
+PSQL=$PGBIN/psql
+num_tests=4
+success_count=0
+
+rm -fr $TESTDIR
+mkdir $TESTDIR
+cd $TESTDIR
+
+# create test environment
+echo -n "creating test environment..."
+$PGPOOL_SETUP -m s -n 2 || exit 1
+echo "done."
+
+source ./bashrc.ports
+
+export PGPORT=$PGPOOL_PORT
+
+SNAPSHOT=`pwd`/memqcache.snapshot
+
+echo "memory_cache_enabled = on" >> etc/pgpool.conf
+echo "memqcache_method = 'shmem'" >> etc/pgpool.conf
+echo "memqcache_expire = 600" >> etc/pgpool.conf
+echo "memqcache_snapshot_file = '$SNAPSHOT'" >> etc/pgpool.conf
+
+./startall
+wait_for_pgpool_startup
+
+$PSQL test <<EOF
+CREATE TABLE t1 (i int);
+CREATE TABLE t2 (i int);
+SELECT pg_sleep(2);	-- Sleep for a while to make sure object creations are replicated
+SELECT * FROM t1;
+SELECT * FROM t2;
+INSERT INTO t2 VALUES(1);
+EOF
+
+./shutdownall
+
+echo -n "snapshot is saved at shutdown..."
+if [ -f $SNAPSHOT ];then
+	echo "ok."
+	success_count=$(( success_count + 1 ))
+else
+	echo "failed."
+fi
+
+./startall
+wait_for_pgpool_startup
+
+for i in `seq 1 10`
+do
+	grep "loaded query cache snapshot" log/pgpool.log > /dev/null 2>&1 && break
+	sleep 1
+done
+
+echo -n "snapshot is loaded and removed..."
+grep "loaded query cache snapshot" log/pgpool.log > /dev/null 2>&1
+if [ $? = 0 -a ! -f $SNAPSHOT ];then
+	echo "ok."
+	success_count=$(( success_count + 1 ))
+else
+	echo "failed."
+fi
+
+$PSQL -c "SELECT * FROM t1" test > /dev/null
+$PSQL -c "SELECT * FROM t2" test > /dev/null
+
+echo -n "restored cache entry is used..."
+grep "fetched from cache. statement: SELECT \* FROM t1" log/pgpool.log > /dev/null 2>&1
+if [ $? = 0 ];then
+	echo "ok."
+	success_count=$(( success_count + 1 ))
+else
+	echo "failed."
+fi
+
+echo -n "cache entry of table written before shutdown is not restored..."
+grep "fetched from cache. statement: SELECT \* FROM t2" log/pgpool.log > /dev/null 2>&1
+if [ $? != 0 ];then
+	echo "ok."
+	success_count=$(( success_count + 1 ))
+else
+	echo "failed."
+fi
+
+./shutdownall
+
+cd ..
+
+echo "$success_count out of $num_tests successfull";
+
+if test $success_count -eq $num_tests
+then
+    exit 0
+fi
+exit 1
@@ -0,0 +1,88 @@
+#!/usr/bin/env bash
+#-------------------------------------------------------------------
+# test script for partial restart of child processes on failover.
+# When a standby node fails, only the child processes whose sessions use
+# the node are restarted. Idle child processes and sessions which do not
+# use the node must survive.
+#
+source $TESTLIBS
+TESTDIR=testdir
+PSQL="$PGBIN/psql -X"
+num_tests=3
+success_count=0
+
+rm -fr $TESTDIR
+mkdir $TESTDIR
+cd $TESTDIR
+
+# create test environment
+echo -n "creating test environment..."
+$PGPOOL_SETUP -m s -n 3 || exit 1
+echo "done."
+
+source ./bashrc.ports
+
+export PGPORT=$PGPOOL_PORT
+
+# sessions with application name "keep" use node 0, "use_node2" use node 2
+echo "app_name_redirect_preference_list = 'keep:0,use_node2:2'" >> etc/pgpool.conf
+
+./startall
+wait_for_pgpool_startup
+
+# pids of idle child processes
+ps -eo pid,args | grep -E "wait for (connection request|accept lock)" | grep -v grep | awk '{print $1}' | sort > idle_children
+
+(echo "SELECT 1 AS before_failover;"; sleep 10; echo "SELECT 1 AS after_failover;") | PGAPPNAME=keep $PSQL test > keep.out 2>&1 &
+(echo "SELECT 1 AS before_failover;"; sleep 10; echo "SELECT 1 AS after_failover;") | PGAPPNAME=use_node2 $PSQL test > use_node2.out 2>&1 &
+sleep 2
+
+$PGPOOL_INSTALL_DIR/bin/pcp_detach_node -w -h localhost -p $PCP_PORT -n 2
+wait_for_failover_done
+wait
+
+echo -n "session not using the failed node survives..."
+grep "after_failover" keep.out > /dev/null 2>&1
+if [ $? = 0 ];then
+	echo "ok."
+	success_count=$(( success_count + 1 ))
+else
+	echo "failed."
+	cat keep.out
+fi
+
+echo -n "session using the failed node is terminated..."
+grep "after_failover" use_node2.out > /dev/null 2>&1
+if [ $? != 0 ];then
+	echo "ok."
+	success_count=$(( success_count + 1 ))
+else
+	echo "failed."
+	cat use_node2.out
+fi
+
+echo -n "idle child processes are not restarted..."
+restarted=0
+for pid in `cat idle_children`
+do
+	kill -0 $pid 2>/dev/null || restarted=$(( restarted + 1 ))
+done
+# only the child serving the session using node 2 is restarted
+if [ $restarted -le 1 ];then
+	echo "ok."
+	success_count=$(( success_count + 1 ))
+else
+	echo "failed: $restarted children restarted."
+fi
+
+./shutdownall
+
+cd ..
+
+echo "$success_count out of $num_tests successfull";
+
+if test $success_count -eq $num_tests
+then
+    exit 0
+fi
+exit 1
@@ -0,0 +1,78 @@
+#!/usr/bin/env bash
+#-------------------------------------------------------------------
+# test script for detaching a failed standby node from an idle session.
+# A session whose load balance node is not the failed standby closes its
+# connection to the failed node and goes on using the other nodes.
+#
+source $TESTLIBS
+TESTDIR=testdir
+PSQL="$PGBIN/psql -X"
+num_tests=3
+success_count=0
+
+rm -fr $TESTDIR
+mkdir $TESTDIR
+cd $TESTDIR
+
+# create test environment
+echo -n "creating test environment..."
+$PGPOOL_SETUP -m s -n 3 || exit 1
+echo "done."
+
+source ./bashrc.ports
+
+export PGPORT=$PGPOOL_PORT
+
+# sessions with application name "idle" use node 1
+echo "app_name_redirect_preference_list = 'idle:1'" >> etc/pgpool.conf
+
+./startall
+wait_for_pgpool_startup
+
+# the session is idle while node 2 fails
+(echo "SELECT 1 AS before_failover;"; sleep 10; echo "SELECT 1 AS after_failover;") | PGAPPNAME=idle $PSQL test > idle.out 2>&1 &
+sleep 2
+
+$PGPOOL_INSTALL_DIR/bin/pcp_detach_node -w -h localhost -p $PCP_PORT -n 2
+wait_for_failover_done
+wait
+
+echo -n "failed node is detached from the session..."
+grep "detaching failed backend node 2 from the session" log/pgpool.log > /dev/null 2>&1
+if [ $? = 0 ];then
+	echo "ok."
+	success_count=$(( success_count + 1 ))
+else
+	echo "failed."
+fi
+
+echo -n "session goes on after failover..."
+grep "after_failover" idle.out > /dev/null 2>&1
+if [ $? = 0 ];then
+	echo "ok."
+	success_count=$(( success_count + 1 ))
+else
+	echo "failed."
+	cat idle.out
+fi
+
+echo -n "session still uses its load balance node..."
+grep "DB node id: 1 .*after_failover" log/pgpool.log > /dev/null 2>&1
+if [ $? = 0 ];then
+	echo "ok."
+	success_count=$(( success_count + 1 ))
+else
+	echo "failed."
+fi
+
+./shutdownall
+
+cd ..
+
+echo "$success_count out of $num_tests successfull";
+
+if test $success_count -eq $num_tests
+then
+    exit 0
+fi
+exit 1
@@ -475,8 +475,8 @@ output_nodeinfo_result(PCPResultInfo * pcpResInfo, bool verbose)
 
 	if (verbose)
 	{
-		const char *titles[] = {"Hostname", "Port", "Status", "Weight", "Status Name", "Role", "Replication Delay", "Replication State", "Replication Sync State", "Last Status Change"};
-		const char *types[] = {"s", "d", "d", "f", "s", "s", "lu", "s", "s", "s"};
+		const char *titles[] = {"Hostname", "Port", "Status", "Weight", "Status Name", "Role", "Replication Delay", "Replication State", "Replication Sync State", "Last Status Change", "Health Check Latency", "Health Check Jitter"};
+		const char *types[] = {"s", "d", "d", "f", "s", "s", "lu", "s", "s", "s", ".3f", ".3f"};
 		char *format_string;
 
 		format_string = format_titles(titles, types, sizeof(titles)/sizeof(char *));
@@ -490,11 +490,13 @@ output_nodeinfo_result(PCPResultInfo * pcpResInfo, bool verbose)
 			   backend_info->standby_delay,
 			   backend_info->replication_state,
 			   backend_info->replication_sync_state,
-			   last_status_change);
+			   last_status_change,
+			   backend_info->health_check_latency / 1000.0,
+			   backend_info->health_check_jitter / 1000.0);
 	}
 	else
 	{
-		printf("%s %d %d %f %s %s %lu %s %s %s\n",
+		printf("%s %d %d %f %s %s %lu %s %s %s %.3f %.3f\n",
 			   backend_info->backend_hostname,
 			   backend_info->backend_port,
 			   backend_info->backend_status,
@@ -504,7 +506,9 @@ output_nodeinfo_result(PCPResultInfo * pcpResInfo, bool verbose)
 			   backend_info->standby_delay,
 			   backend_info->replication_state,
 			   backend_info->replication_sync_state,
-			   last_status_change);
+			   last_status_change,
+			   backend_info->health_check_latency / 1000.0,
+			   backend_info->health_check_jitter / 1000.0);
 	}
 }
 
@@ -285,6 +285,21 @@ get_config(int *nrows)
 	StrNCpy(status[i].desc, "# of children initially pre-forked", POOLCONFIG_MAXDESCLEN);
 	i++;
 
+	StrNCpy(status[i].name, "process_management_mode", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->process_management_mode);
+	StrNCpy(status[i].desc, "how to manage the number of children", POOLCONFIG_MAXDESCLEN);
+	i++;
+
+	StrNCpy(status[i].name, "min_spare_children", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->min_spare_children);
+	StrNCpy(status[i].desc, "minimum # of idle children in dynamic mode", POOLCONFIG_MAXDESCLEN);
+	i++;
+
+	StrNCpy(status[i].name, "max_spare_children", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->max_spare_children);
+	StrNCpy(status[i].desc, "maximum # of idle children in dynamic mode", POOLCONFIG_MAXDESCLEN);
+	i++;
+
 	StrNCpy(status[i].name, "listen_backlog_multiplier", POOLCONFIG_MAXNAMELEN);
 	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->listen_backlog_multiplier);
 	StrNCpy(status[i].desc, "determines the size of the queue for pending connections", POOLCONFIG_MAXDESCLEN);
@@ -305,6 +320,11 @@ get_config(int *nrows)
 	StrNCpy(status[i].desc, "max # of connection pool per child", POOLCONFIG_MAXDESCLEN);
 	i++;
 
+	StrNCpy(status[i].name, "prewarm_connections", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->prewarm_connections);
+	StrNCpy(status[i].desc, "# of connection pools opened in advance by idle child", POOLCONFIG_MAXDESCLEN);
+	i++;
+
 	/* - Life time - */
 	StrNCpy(status[i].name, "child_life_time", POOLCONFIG_MAXNAMELEN);
 	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->child_life_time);
@@ -522,6 +542,26 @@ get_config(int *nrows)
 	StrNCpy(status[i].desc, "statement level load balancing", POOLCONFIG_MAXDESCLEN);
 	i++;
 
+	StrNCpy(status[i].name, "read_your_writes", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->read_your_writes);
+	StrNCpy(status[i].desc, "do not load balance to standbys behind the session's writes", POOLCONFIG_MAXDESCLEN);
+	i++;
+
+	StrNCpy(status[i].name, "load_balance_policy", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->load_balance_policy);
+	StrNCpy(status[i].desc, "how to select load balancing node", POOLCONFIG_MAXDESCLEN);
+	i++;
+
+	StrNCpy(status[i].name, "heavy_query_time_threshold", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->heavy_query_time_threshold);
+	StrNCpy(status[i].desc, "execution time in milliseconds from which SELECT is heavy", POOLCONFIG_MAXDESCLEN);
+	i++;
+
+	StrNCpy(status[i].name, "heavy_query_rows_threshold", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->heavy_query_rows_threshold);
+	StrNCpy(status[i].desc, "number of rows from which SELECT is heavy", POOLCONFIG_MAXDESCLEN);
+	i++;
+
 	/* MASTER/SLAVE MODE */
 
 	StrNCpy(status[i].name, "master_slave_mode", POOLCONFIG_MAXNAMELEN);
@@ -540,6 +580,11 @@ get_config(int *nrows)
 	StrNCpy(status[i].desc, "sr check period", POOLCONFIG_MAXDESCLEN);
 	i++;
 
+	StrNCpy(status[i].name, "sr_check_sampling_interval", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->sr_check_sampling_interval);
+	StrNCpy(status[i].desc, "replication delay sampling interval in milliseconds", POOLCONFIG_MAXDESCLEN);
+	i++;
+
 	StrNCpy(status[i].name, "sr_check_user", POOLCONFIG_MAXNAMELEN);
 	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%s", pool_config->sr_check_user);
 	StrNCpy(status[i].desc, "sr check user", POOLCONFIG_MAXDESCLEN);
@@ -560,12 +605,22 @@ get_config(int *nrows)
 	StrNCpy(status[i].desc, "standby delay threshold", POOLCONFIG_MAXDESCLEN);
 	i++;
 
+	StrNCpy(status[i].name, "delay_weight_scale", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, INT64_FORMAT, pool_config->delay_weight_scale);
+	StrNCpy(status[i].desc, "standby delay at which load balance weight is halved", POOLCONFIG_MAXDESCLEN);
+	i++;
+
 	/* - Special commands - */
 	StrNCpy(status[i].name, "follow_master_command", POOLCONFIG_MAXNAMELEN);
 	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%s", pool_config->follow_master_command);
 	StrNCpy(status[i].desc, "follow master command", POOLCONFIG_MAXDESCLEN);
 	i++;
 
+	StrNCpy(status[i].name, "follow_master_parallelism", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->follow_master_parallelism);
+	StrNCpy(status[i].desc, "max number of concurrent follow master commands", POOLCONFIG_MAXDESCLEN);
+	i++;
+
 	StrNCpy(status[i].name, "database_redirect_preference_list", POOLCONFIG_MAXNAMELEN);
 	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%s", pool_config->database_redirect_preference_list);
 	StrNCpy(status[i].desc, "redirect by database name", POOLCONFIG_MAXDESCLEN);
@@ -623,6 +678,21 @@ get_config(int *nrows)
 	StrNCpy(status[i].desc, "connect timeout", POOLCONFIG_MAXDESCLEN);
 	i++;
 
+	StrNCpy(status[i].name, "health_check_mode", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->health_check_mode);
+	StrNCpy(status[i].desc, "one health check process per node or for all nodes", POOLCONFIG_MAXDESCLEN);
+	i++;
+
+	StrNCpy(status[i].name, "health_check_probe_interval", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->health_check_probe_interval);
+	StrNCpy(status[i].desc, "probe interval in milliseconds in multiplexed mode", POOLCONFIG_MAXDESCLEN);
+	i++;
+
+	StrNCpy(status[i].name, "health_check_latency_weight_scale", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->health_check_latency_weight_scale);
+	StrNCpy(status[i].desc, "health check latency in milliseconds halving load balance weight", POOLCONFIG_MAXDESCLEN);
+	i++;
+
 	/* FAILOVER AND FAILBACK */
 
 	StrNCpy(status[i].name, "failover_command", POOLCONFIG_MAXNAMELEN);
@@ -711,7 +781,12 @@ get_config(int *nrows)
 
 	StrNCpy(status[i].name, "enable_shared_relcache", POOLCONFIG_MAXNAMELEN);
 	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->enable_shared_relcache);
-	StrNCpy(status[i].desc, "If true, relation cache stored in memory cache", POOLCONFIG_MAXDESCLEN);
+	StrNCpy(status[i].desc, "If true, relation cache is shared among child processes", POOLCONFIG_MAXDESCLEN);
+	i++;
+
+	StrNCpy(status[i].name, "shared_relcache_size", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->shared_relcache_size);
+	StrNCpy(status[i].desc, "number of shared relation cache entry", POOLCONFIG_MAXDESCLEN);
 	i++;
 
 	StrNCpy(status[i].name, "relcache_query_target", POOLCONFIG_MAXNAMELEN);
@@ -719,6 +794,16 @@ get_config(int *nrows)
 	StrNCpy(status[i].desc, "Target node to send relcache queries", POOLCONFIG_MAXDESCLEN);
 	i++;
 
+	StrNCpy(status[i].name, "huge_pages", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->huge_pages);
+	StrNCpy(status[i].desc, "use huge pages for shared memory", POOLCONFIG_MAXDESCLEN);
+	i++;
+
+	StrNCpy(status[i].name, "shared_memory_numa_policy", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->shared_memory_numa_policy);
+	StrNCpy(status[i].desc, "NUMA memory policy of shared memory", POOLCONFIG_MAXDESCLEN);
+	i++;
+
 	/*
 	 * add for watchdog
 	 */
@@ -909,11 +994,21 @@ get_config(int *nrows)
 	StrNCpy(status[i].desc, "If true, invalidation of query cache is triggered by corresponding DDL/DML/DCL(and memqcache_expire).  If false, it is only triggered  by memqcache_expire.  True by default.", POOLCONFIG_MAXDESCLEN);
 	i++;
 
+	StrNCpy(status[i].name, "memqcache_admission_filter", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->memqcache_admission_filter);
+	StrNCpy(status[i].desc, "If true, a new cache item is admitted only if it is used more frequently than the item to be evicted", POOLCONFIG_MAXDESCLEN);
+	i++;
+
 	StrNCpy(status[i].name, "memqcache_maxcache", POOLCONFIG_MAXNAMELEN);
 	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->memqcache_maxcache);
 	StrNCpy(status[i].desc, "Maximum SELECT result size in bytes", POOLCONFIG_MAXDESCLEN);
 	i++;
 
+	StrNCpy(status[i].name, "memqcache_compress_threshold", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->memqcache_compress_threshold);
+	StrNCpy(status[i].desc, "Minimum SELECT result size in bytes to be compressed in the cache. 0 disables compression", POOLCONFIG_MAXDESCLEN);
+	i++;
+
 	StrNCpy(status[i].name, "memqcache_cache_block_size", POOLCONFIG_MAXNAMELEN);
 	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%d", pool_config->memqcache_cache_block_size);
 	StrNCpy(status[i].desc, "Cache block size in bytes. 8192 by default", POOLCONFIG_MAXDESCLEN);
@@ -924,6 +1019,11 @@ get_config(int *nrows)
 	StrNCpy(status[i].desc, "Tempory work directory to record table oids", POOLCONFIG_MAXDESCLEN);
 	i++;
 
+	StrNCpy(status[i].name, "memqcache_snapshot_file", POOLCONFIG_MAXNAMELEN);
+	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%s", pool_config->memqcache_snapshot_file);
+	StrNCpy(status[i].desc, "File to save shared memory query cache at shutdown", POOLCONFIG_MAXDESCLEN);
+	i++;
+
 	StrNCpy(status[i].name, "memqcache_stats_start_time", POOLCONFIG_MAXNAMELEN);
 	snprintf(status[i].value, POOLCONFIG_MAXVALLEN, "%s", ctime(&pool_get_memqcache_stats()->start_time));
 	StrNCpy(status[i].desc, "Start time of query cache stats", POOLCONFIG_MAXDESCLEN);
@@ -1264,6 +1364,7 @@ get_nodes(int *nrows)
 				 (session_context->load_balance_node_id == i) ? "true" : "false");
 
 		snprintf(nodes[i].delay, POOLCONFIG_MAXWEIGHTLEN, "%d", 0);
+		snprintf(nodes[i].delay_peak, POOLCONFIG_MAXWEIGHTLEN, "%d", 0);
 
 		if (STREAM)
 		{
@@ -1275,6 +1376,7 @@ get_nodes(int *nrows)
 			{
 				snprintf(nodes[i].role, POOLCONFIG_MAXWEIGHTLEN, "%s", "standby");
 				snprintf(nodes[i].delay, POOLCONFIG_MAXWEIGHTLEN, UINT64_FORMAT, bi->standby_delay);
+				snprintf(nodes[i].delay_peak, POOLCONFIG_MAXWEIGHTLEN, UINT64_FORMAT, get_replication_lag_peak(i));
 			}
 		}
 		else
@@ -1305,7 +1407,7 @@ get_nodes(int *nrows)
 void
 nodes_reporting(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend)
 {
-	static char *field_names[] = {"node_id", "hostname", "port", "status", "lb_weight", "role", "select_cnt", "load_balance_node", "replication_delay", "replication_state", "replication_sync_state", "last_status_change"};
+	static char *field_names[] = {"node_id", "hostname", "port", "status", "lb_weight", "role", "select_cnt", "load_balance_node", "replication_delay", "replication_delay_peak", "replication_state", "replication_sync_state", "last_status_change"};
 	short		num_fields = sizeof(field_names) / sizeof(char *);
 	int			i;
 	short		s;
@@ -1373,6 +1475,11 @@ nodes_reporting(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend)
 			pool_write(frontend, &hsize, sizeof(hsize));
 			pool_write(frontend, nodes[i].delay, size);
 
+			size = strlen(nodes[i].delay_peak);
+			hsize = htonl(size + 4);
+			pool_write(frontend, &hsize, sizeof(hsize));
+			pool_write(frontend, nodes[i].delay_peak, size);
+
 			size = strlen(nodes[i].rep_state);
 			hsize = htonl(size + 4);
 			pool_write(frontend, &hsize, sizeof(hsize));
@@ -1405,6 +1512,7 @@ nodes_reporting(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend)
 			len += 4 + strlen(nodes[i].select); /* int32 + data; */
 			len += 4 + strlen(nodes[i].load_balance_node);	/* int32 + data; */
 			len += 4 + strlen(nodes[i].delay);	/* int32 + data; */
+			len += 4 + strlen(nodes[i].delay_peak);	/* int32 + data; */
 			len += 4 + strlen(nodes[i].rep_state);	/* int32 + data; */
 			len += 4 + strlen(nodes[i].rep_sync_state);	/* int32 + data; */
 			len += 4 + strlen(nodes[i].last_status_change); /* int32 + data; */
@@ -1449,6 +1557,10 @@ nodes_reporting(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend)
 			pool_write(frontend, &len, sizeof(len));
 			pool_write(frontend, nodes[i].delay, strlen(nodes[i].delay));
 
+			len = htonl(strlen(nodes[i].delay_peak));
+			pool_write(frontend, &len, sizeof(len));
+			pool_write(frontend, nodes[i].delay_peak, strlen(nodes[i].delay_peak));
+
 			len = htonl(strlen(nodes[i].rep_state));
 			pool_write(frontend, &len, sizeof(len));
 			pool_write(frontend, nodes[i].rep_state, strlen(nodes[i].rep_state));
@@ -1489,7 +1601,9 @@ get_pools(int *nrows)
 	for (child = 0; child < pool_config->num_init_children; child++)
 	{
 		proc_id = process_info[child].pid;
-		pi = pool_get_process_info(proc_id);
+		if (proc_id == 0)
+			continue;			/* empty slot in dynamic mode */
+		pi = &process_info[child];
 
 		for (pool = 0; pool < pool_config->max_pool; pool++)
 		{
@@ -1682,6 +1796,7 @@ get_processes(int *nrows)
 	int			child;
 	int			pool;
 	int			poolBE;
+	int			lines = 0;
 	ProcessInfo *pi = NULL;
 	int			proc_id;
 
@@ -1689,30 +1804,35 @@ get_processes(int *nrows)
 
 	for (child = 0; child < pool_config->num_init_children; child++)
 	{
-		proc_id = process_info[child].pid;
-		pi = pool_get_process_info(proc_id);
+		POOL_REPORT_PROCESSES *p = &processes[lines];
 
-		snprintf(processes[child].pool_pid, POOLCONFIG_MAXCOUNTLEN, "%d", proc_id);
-		strftime(processes[child].start_time, POOLCONFIG_MAXDATELEN, "%Y-%m-%d %H:%M:%S", localtime(&pi->start_time));
-		StrNCpy(processes[child].database, "", POOLCONFIG_MAXIDENTLEN);
-		StrNCpy(processes[child].username, "", POOLCONFIG_MAXIDENTLEN);
-		StrNCpy(processes[child].create_time, "", POOLCONFIG_MAXDATELEN);
-		StrNCpy(processes[child].pool_counter, "", POOLCONFIG_MAXCOUNTLEN);
+		proc_id = process_info[child].pid;
+		if (proc_id == 0)
+			continue;			/* empty slot in dynamic mode */
+		pi = &process_info[child];
+		lines++;
+
+		snprintf(p->pool_pid, POOLCONFIG_MAXCOUNTLEN, "%d", proc_id);
+		strftime(p->start_time, POOLCONFIG_MAXDATELEN, "%Y-%m-%d %H:%M:%S", localtime(&pi->start_time));
+		StrNCpy(p->database, "", POOLCONFIG_MAXIDENTLEN);
+		StrNCpy(p->username, "", POOLCONFIG_MAXIDENTLEN);
+		StrNCpy(p->create_time, "", POOLCONFIG_MAXDATELEN);
+		StrNCpy(p->pool_counter, "", POOLCONFIG_MAXCOUNTLEN);
 
 		for (pool = 0; pool < pool_config->max_pool; pool++)
 		{
 			poolBE = pool * MAX_NUM_BACKENDS;
 			if (pi->connection_info[poolBE].connected && strlen(pi->connection_info[poolBE].database) > 0 && strlen(pi->connection_info[poolBE].user) > 0)
 			{
-				StrNCpy(processes[child].database, pi->connection_info[poolBE].database, POOLCONFIG_MAXIDENTLEN);
-				StrNCpy(processes[child].username, pi->connection_info[poolBE].user, POOLCONFIG_MAXIDENTLEN);
-				strftime(processes[child].create_time, POOLCONFIG_MAXDATELEN, "%Y-%m-%d %H:%M:%S", localtime(&pi->connection_info[poolBE].create_time));
-				snprintf(processes[child].pool_counter, POOLCONFIG_MAXCOUNTLEN, "%d", pi->connection_info[poolBE].counter);
+				StrNCpy(p->database, pi->connection_info[poolBE].database, POOLCONFIG_MAXIDENTLEN);
+				StrNCpy(p->username, pi->connection_info[poolBE].user, POOLCONFIG_MAXIDENTLEN);
+				strftime(p->create_time, POOLCONFIG_MAXDATELEN, "%Y-%m-%d %H:%M:%S", localtime(&pi->connection_info[poolBE].create_time));
+				snprintf(p->pool_counter, POOLCONFIG_MAXCOUNTLEN, "%d", pi->connection_info[poolBE].counter);
 			}
 		}
 	}
 
-	*nrows = child;
+	*nrows = lines;
 
 	return processes;
 }
@@ -2005,3 +2125,224 @@ cache_reporting(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend)
 
 	pfree(strp);
 }
+
+/*
+ * Show each in memory cache entry
+ */
+void
+cache_entries_reporting(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend)
+{
+	static char *field_names[] = {"block_id", "item_id", "query_hash", "bytes", "raw_bytes", "hits", "frequency", "create_time", "expire"};
+	short		num_fields = sizeof(field_names) / sizeof(char *);
+	short		s;
+	int			len;
+	int			size;
+	int			hsize;
+	int			nrows;
+	int			i;
+	int			j;
+	static unsigned char nullmap[2] = {0xff, 0xff};
+	int			nbytes = (num_fields + 7) / 8;
+	pool_sigset_t oldmask;
+	POOL_CACHE_ENTRY_STATS *entries;
+
+#define POOL_CACHE_ENTRY_MAX_STRING_LEN 32
+	char		block_id[POOL_CACHE_ENTRY_MAX_STRING_LEN + 1];
+	char		item_id[POOL_CACHE_ENTRY_MAX_STRING_LEN + 1];
+	char		bytes[POOL_CACHE_ENTRY_MAX_STRING_LEN + 1];
+	char		raw_bytes[POOL_CACHE_ENTRY_MAX_STRING_LEN + 1];
+	char		hits[POOL_CACHE_ENTRY_MAX_STRING_LEN + 1];
+	char		frequency[POOL_CACHE_ENTRY_MAX_STRING_LEN + 1];
+	char		create_time[POOL_CACHE_ENTRY_MAX_STRING_LEN + 1];
+	char		expire[POOL_CACHE_ENTRY_MAX_STRING_LEN + 1];
+	char	   *values[9];
+
+	/*
+	 * Get raw cache entry data
+	 */
+	POOL_SETMASK2(&BlockSig, &oldmask);
+	pool_shmem_lock();
+
+	PG_TRY();
+	{
+		entries = pool_get_shmem_cache_entries(&nrows);
+	}
+	PG_CATCH();
+	{
+		pool_shmem_unlock();
+		POOL_SETMASK(&oldmask);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	pool_shmem_unlock();
+	POOL_SETMASK(&oldmask);
+
+	send_row_description(frontend, backend, num_fields, field_names);
+
+	for (i = 0; i < nrows; i++)
+	{
+		snprintf(block_id, sizeof(block_id), "%d", entries[i].cacheid.blockid);
+		snprintf(item_id, sizeof(item_id), "%d", entries[i].cacheid.itemid);
+		snprintf(bytes, sizeof(bytes), "%u", entries[i].size);
+		snprintf(raw_bytes, sizeof(raw_bytes), "%u", entries[i].raw_size);
+		snprintf(hits, sizeof(hits), "%u", entries[i].num_hits);
+		snprintf(frequency, sizeof(frequency), "%d", entries[i].frequency);
+		strftime(create_time, sizeof(create_time), "%Y-%m-%d %H:%M:%S", localtime(&entries[i].timestamp));
+		snprintf(expire, sizeof(expire), "%d", entries[i].expire);
+
+		values[0] = block_id;
+		values[1] = item_id;
+		values[2] = entries[i].query_hash;
+		values[3] = bytes;
+		values[4] = raw_bytes;
+		values[5] = hits;
+		values[6] = frequency;
+		values[7] = create_time;
+		values[8] = expire;
+
+		if (MAJOR(backend) == PROTO_MAJOR_V2)
+		{
+			pool_write(frontend, "D", 1);
+			pool_write(frontend, nullmap, nbytes);
+
+			for (j = 0; j < num_fields; j++)
+			{
+				size = strlen(values[j]);
+				hsize = htonl(size + 4);
+				pool_write(frontend, &hsize, sizeof(hsize));
+				pool_write(frontend, values[j], size);
+			}
+		}
+		else
+		{
+			pool_write(frontend, "D", 1);
+			len = 6;			/* int32 + int16; */
+			for (j = 0; j < num_fields; j++)
+				len += 4 + strlen(values[j]);	/* int32 + data */
+			len = htonl(len);
+			pool_write(frontend, &len, sizeof(len));
+			s = htons(num_fields);
+			pool_write(frontend, &s, sizeof(s));
+
+			for (j = 0; j < num_fields; j++)
+			{
+				len = htonl(strlen(values[j]));
+				pool_write(frontend, &len, sizeof(len));
+				pool_write(frontend, values[j], strlen(values[j]));
+			}
+		}
+	}
+
+	send_complete_and_ready(frontend, backend, "SELECT", nrows);
+
+	pfree(entries);
+}
+
+/*
+ * Show health check statistics of each backend. Latencies are shown in
+ * milliseconds.
+ */
+void
+health_check_stats_reporting(POOL_CONNECTION * frontend, POOL_CONNECTION_POOL * backend)
+{
+	static char *field_names[] = {"node_id", "hostname", "port", "status", "probes", "failures", "last_probe", "last_latency", "min_latency", "max_latency", "avg_latency", "p50_latency", "p90_latency", "p99_latency", "jitter"};
+	short		num_fields = sizeof(field_names) / sizeof(char *);
+	short		s;
+	int			len;
+	int			size;
+	int			hsize;
+	int			i;
+	int			j;
+	static unsigned char nullmap[2] = {0xff, 0xff};
+	int			nbytes = (num_fields + 7) / 8;
+	HealthCheckStatsSummary summary;
+
+#define POOL_HEALTH_CHECK_STATS_MAX_STRING_LEN 32
+	char		node_id[POOL_HEALTH_CHECK_STATS_MAX_STRING_LEN + 1];
+	char		port[POOL_HEALTH_CHECK_STATS_MAX_STRING_LEN + 1];
+	char		probes[POOL_HEALTH_CHECK_STATS_MAX_STRING_LEN + 1];
+	char		failures[POOL_HEALTH_CHECK_STATS_MAX_STRING_LEN + 1];
+	char		last_probe[POOL_HEALTH_CHECK_STATS_MAX_STRING_LEN + 1];
+	char		latencies[8][POOL_HEALTH_CHECK_STATS_MAX_STRING_LEN + 1];
+	char	   *values[15];
+
+	send_row_description(frontend, backend, num_fields, field_names);
+
+	for (i = 0; i < NUM_BACKENDS; i++)
+	{
+		BackendInfo *bkinfo = pool_get_node_info(i);
+		int64		l[8];
+
+		health_check_stats_summary(i, &summary);
+
+		snprintf(node_id, sizeof(node_id), "%d", i);
+		snprintf(port, sizeof(port), "%d", bkinfo->backend_port);
+		snprintf(probes, sizeof(probes), UINT64_FORMAT, summary.probes);
+		snprintf(failures, sizeof(failures), UINT64_FORMAT, summary.failures);
+		if (summary.last_time == 0)
+			*last_probe = '\0';
+		else
+			strftime(last_probe, sizeof(last_probe), "%Y-%m-%d %H:%M:%S", localtime(&summary.last_time));
+
+		l[0] = summary.last;
+		l[1] = summary.min;
+		l[2] = summary.max;
+		l[3] = summary.avg;
+		l[4] = summary.p50;
+		l[5] = summary.p90;
+		l[6] = summary.p99;
+		l[7] = summary.jitter;
+		for (j = 0; j < 8; j++)
+		{
+			/* no successful probe yet, or the last probe failed */
+			if (summary.nsamples == 0 || l[j] < 0)
+				*latencies[j] = '\0';
+			else
+				snprintf(latencies[j], sizeof(latencies[j]), "%.3f", l[j] / 1000.0);
+		}
+
+		values[0] = node_id;
+		values[1] = bkinfo->backend_hostname;
+		values[2] = port;
+		values[3] = backend_status_to_str(bkinfo);
+		values[4] = probes;
+		values[5] = failures;
+		values[6] = last_probe;
+		for (j = 0; j < 8; j++)
+			values[7 + j] = latencies[j];
+
+		if (MAJOR(backend) == PROTO_MAJOR_V2)
+		{
+			pool_write(frontend, "D", 1);
+			pool_write(frontend, nullmap, nbytes);
+
+			for (j = 0; j < num_fields; j++)
+			{
+				size = strlen(values[j]);
+				hsize = htonl(size + 4);
+				pool_write(frontend, &hsize, sizeof(hsize));
+				pool_write(frontend, values[j], size);
+			}
+		}
+		else
+		{
+			pool_write(frontend, "D", 1);
+			len = 6;			/* int32 + int16; */
+			for (j = 0; j < num_fields; j++)
+				len += 4 + strlen(values[j]);	/* int32 + data */
+			len = htonl(len);
+			pool_write(frontend, &len, sizeof(len));
+			s = htons(num_fields);
+			pool_write(frontend, &s, sizeof(s));
+
+			for (j = 0; j < num_fields; j++)
+			{
+				len = htonl(strlen(values[j]));
+				pool_write(frontend, &len, sizeof(len));
+				pool_write(frontend, values[j], strlen(values[j]));
+			}
+		}
+	}
+
+	send_complete_and_ready(frontend, backend, "SELECT", NUM_BACKENDS);
+}
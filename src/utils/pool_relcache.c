@@ -24,6 +24,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <ctype.h>
 
 #include "pool.h"
 #include "utils/pool_relcache.h"
@@ -33,10 +34,34 @@
 #include "utils/palloc.h"
 #include "utils/memutils.h"
 #include "utils/elog.h"
+#include "auth/md5.h"
+#include "parser/parsenodes.h"
+#include "parser/pg_class.h"
+#include "utils/pool_select_walker.h"
 
 static void SearchRelCacheErrorCb(void *arg);
-static POOL_SELECT_RESULT *query_cache_to_relation_cache(char *data, size_t size);
-static char *relation_cache_to_query_cache(POOL_SELECT_RESULT *res,size_t *size);
+static POOL_SELECT_RESULT *deserialize_select_result(char *data, size_t size);
+static char *serialize_select_result(POOL_SELECT_RESULT *res,size_t *size);
+static char *relcache_intern_dbname(POOL_RELCACHE * relcache, char *dbname, bool create);
+static uint32 relcache_hash(char *dbname, char *relname, int session_id);
+static void relcache_lru_unlink(POOL_RELCACHE * relcache, int index);
+static void relcache_lru_push(POOL_RELCACHE * relcache, int index);
+static void relcache_remove_entry(POOL_RELCACHE * relcache, int index);
+static int	relcache_session_id(POOL_RELCACHE * relcache);
+static PoolRelCache *relcache_lookup(POOL_RELCACHE * relcache, char *dbname, char *table, int session_id, time_t now);
+static void relcache_insert(POOL_RELCACHE * relcache, char *dbname, char *table, int session_id, time_t now, uint32 generation, void *data);
+static int	shared_relcache_nbuckets(void);
+static void shared_relcache_lock(pool_sigset_t *oldmask);
+static void shared_relcache_unlock(pool_sigset_t *oldmask);
+static void shared_relcache_key(char *dbname, char *query, char *key);
+static bool shared_relcache_fetch(char *key, char *data, int *len, time_t now);
+static void shared_relcache_store(char *key, char *dbname, char *relname, char *data, int len, time_t now);
+static void shared_relcache_normalize_relname(char *relname, char *buf);
+static int	shared_relcache_bucket(char *key);
+static int	shared_relcache_find(char *key);
+static void shared_relcache_remove(int index);
+static void shared_relcache_invalidate_object(POOL_CONNECTION_POOL * backend, char *relname);
+static void shared_relcache_invalidate_name_list(POOL_CONNECTION_POOL * backend, List *names);
 
 
 /*
@@ -50,6 +75,8 @@ pool_create_relcache(int cachesize, char *sql,
 	POOL_RELCACHE *p;
 	PoolRelCache *ip;
 	MemoryContext old_context;
+	int			nbuckets;
+	int			i;
 
 	if (cachesize < 0)
 	{
@@ -64,11 +91,26 @@ pool_create_relcache(int cachesize, char *sql,
 	 */
 	old_context = MemoryContextSwitchTo(TopMemoryContext);
 
+	/* Number of hash buckets is the power of 2 not less than cache size */
+	for (nbuckets = 1; nbuckets < cachesize; nbuckets <<= 1)
+		;
+
 	ip = (PoolRelCache *) palloc0(sizeof(PoolRelCache) * cachesize);
 	p = (POOL_RELCACHE *) palloc(sizeof(POOL_RELCACHE));
+	p->buckets = (int *) palloc(sizeof(int) * nbuckets);
 
 	MemoryContextSwitchTo(old_context);
 
+	for (i = 0; i < nbuckets; i++)
+		p->buckets[i] = -1;
+
+	/* Chain all entries into the free list */
+	for (i = 0; i < cachesize; i++)
+	{
+		ip[i].next = (i + 1 < cachesize) ? i + 1 : -1;
+		ip[i].lru_prev = ip[i].lru_next = -1;
+	}
+
 	p->num = cachesize;
 	strlcpy(p->sql, sql, sizeof(p->sql));
 	p->register_func = register_func;
@@ -76,6 +118,10 @@ pool_create_relcache(int cachesize, char *sql,
 	p->cache_is_session_local = issessionlocal;
 	p->no_cache_if_zero = false;
 	p->cache = ip;
+	p->nbuckets = nbuckets;
+	p->free_list = (cachesize > 0) ? 0 : -1;
+	p->lru_head = p->lru_tail = -1;
+	p->dbnames = NULL;
 
 	return p;
 }
@@ -86,16 +132,174 @@ pool_create_relcache(int cachesize, char *sql,
 void
 pool_discard_relcache(POOL_RELCACHE * relcache)
 {
+	PoolRelCacheDbName *d;
 	int			i;
 
 	for (i = 0; i < relcache->num; i++)
 	{
 		(*relcache->unregister_func) (relcache->cache[i].data);
+		if (relcache->cache[i].relname)
+			pfree(relcache->cache[i].relname);
 	}
+
+	while (relcache->dbnames)
+	{
+		d = relcache->dbnames;
+		relcache->dbnames = d->next;
+		pfree(d);
+	}
+	pfree(relcache->buckets);
 	pfree(relcache->cache);
 	pfree(relcache);
 }
 
+/*
+ * Return node id to send queries to fill relcache and set the database name
+ * of the node to *dbname.  If relcache_query_target is
+ * RELQTARGET_LOADL_BALANCE_NODE, we consider load balance node id to be
+ * used to send queries.
+ *
+ * Note that we need to use VALID_BACKEND_RAW, rather than VALID_BACKEND
+ * since pool_is_node_to_be_sent_in_current_query(being called by
+ * VALID_BACKEND) assumes that if query context exists, where_to_send map
+ * is already setup but it's not always the case because
+ * pool_search_relcache is mostly called *before* the where_to_send map is
+ * established.
+ */
+int
+pool_relcache_query_node(POOL_CONNECTION_POOL * backend, char **dbname)
+{
+	POOL_SESSION_CONTEXT *session_context;
+
+	session_context = pool_get_session_context(false);
+
+	if (pool_config->relcache_query_target == RELQTARGET_LOAD_BALANCE_NODE &&
+		session_context && VALID_BACKEND_RAW(session_context->load_balance_node_id) &&
+		backend->slots[session_context->load_balance_node_id])
+	{
+		*dbname = backend->slots[session_context->load_balance_node_id]->sp->database;
+		return session_context->load_balance_node_id;
+	}
+
+	*dbname = MASTER_CONNECTION(backend)->sp->database;
+	return MASTER_NODE_ID;
+}
+
+/*
+ * Return true if relcache has a valid entry for the table. If it's not in
+ * the local cache but in the shared relation cache, it is copied to the
+ * local cache.
+ */
+bool
+pool_relcache_contains(POOL_RELCACHE * relcache, POOL_CONNECTION_POOL * backend, char *table)
+{
+	char	   *dbname;
+	int			session_id;
+	time_t		now;
+	uint32		generation;
+	char		query[1024];
+	char		shared_key[SHARED_RELCACHE_KEYLEN + 1];
+	char		shared_data[SHARED_RELCACHE_DATALEN];
+	int			shared_data_len;
+	POOL_SELECT_RESULT *res;
+	void	   *result;
+
+	session_id = relcache_session_id(relcache);
+	if (session_id < 0)
+		return false;
+
+	pool_relcache_query_node(backend, &dbname);
+	now = time(NULL);
+
+	if (relcache_lookup(relcache, dbname, table, session_id, now))
+		return true;
+
+	if (!pool_config->enable_shared_relcache || relcache->cache_is_session_local ||
+		relcache->num <= 0 || pool_is_ignore_till_sync())
+		return false;
+
+	generation = pool_shared_relcache_generation(dbname);
+	snprintf(query, sizeof(query), relcache->sql, table);
+	shared_relcache_key(dbname, query, shared_key);
+
+	if (!shared_relcache_fetch(shared_key, shared_data, &shared_data_len, now))
+		return false;
+
+	ereport(DEBUG1,
+			(errmsg("hit shared relation cache"),
+			 errdetail("query:%s", query)));
+
+	res = deserialize_select_result(shared_data, shared_data_len);
+	result = (*relcache->register_func) (res);
+	free_select_result(res);
+
+	if (relcache->no_cache_if_zero && !result)
+		return false;
+
+	relcache_insert(relcache, dbname, table, session_id, now, generation, result);
+	return true;
+}
+
+/*
+ * Register the value of the table to relcache, which has been obtained by
+ * other means than relcache->sql, e.g. a query for multiple tables.  value
+ * must be what relcache->sql returns as the single column of the single
+ * row. It is also saved in the shared relation cache.  generation is
+ * pool_shared_relcache_generation() taken before the value was obtained.
+ */
+void
+pool_add_relcache(POOL_RELCACHE * relcache, POOL_CONNECTION_POOL * backend, char *table, char *value,
+				  uint32 generation)
+{
+	char	   *dbname;
+	int			session_id;
+	time_t		now;
+	POOL_SELECT_RESULT res;
+	RowDesc		rowdesc;
+	int			nullflag;
+	void	   *result;
+
+	session_id = relcache_session_id(relcache);
+	pool_relcache_query_node(backend, &dbname);
+	now = time(NULL);
+
+	if (session_id < 0 || pool_is_ignore_till_sync() || value == NULL)
+		return;
+
+	/* Make a query result as relcache->sql would return */
+	rowdesc.num_attrs = 1;
+	rowdesc.attrinfo = NULL;
+	nullflag = strlen(value);
+	res.rowdesc = &rowdesc;
+	res.numrows = 1;
+	res.nullflags = &nullflag;
+	res.data = &value;
+
+	if (pool_config->enable_shared_relcache && !relcache->cache_is_session_local)
+	{
+		char		query[1024];
+		char		shared_key[SHARED_RELCACHE_KEYLEN + 1];
+		char	   *data;
+		size_t		len;
+
+		snprintf(query, sizeof(query), relcache->sql, table);
+		shared_relcache_key(dbname, query, shared_key);
+		data = serialize_select_result(&res, &len);
+		if (len <= SHARED_RELCACHE_DATALEN)
+			shared_relcache_store(shared_key, dbname, table, data, len, now);
+		pfree(data);
+	}
+
+	if (relcache->num <= 0 || relcache_lookup(relcache, dbname, table, session_id, now))
+		return;
+
+	result = (*relcache->register_func) (&res);
+	if (relcache->no_cache_if_zero && !result)
+		return;
+
+	relcache_insert(relcache, dbname, table, session_id, now, generation, result);
+}
+
 /*
  * Search relcache. If found, return user data. Otherwise return 0.
  * If not found in cache, do the query and store the result into cache and return it.
@@ -104,98 +308,74 @@ void *
 pool_search_relcache(POOL_RELCACHE * relcache, POOL_CONNECTION_POOL * backend, char *table)
 {
 	char	   *dbname;
-	int			i;
-	int			maxrefcnt = INT_MAX;
+	PoolRelCache *entry;
 	char		query[1024];
 	POOL_SELECT_RESULT *res = NULL;
-	int			index = 0;
 	int			local_session_id;
 	time_t		now;
 	void		*result;
 	ErrorContextCallback callback;
-    pool_sigset_t oldmask;
-	bool locked;
-	int			query_cache_not_found = 1;
-	char		*query_cache_data = NULL;
-	size_t		query_cache_len;
-	POOL_SESSION_CONTEXT *session_context;
+	bool		shared;
+	char		shared_key[SHARED_RELCACHE_KEYLEN + 1];
+	char		shared_data[SHARED_RELCACHE_DATALEN];
+	int			shared_data_len;
 	int			node_id;
+	uint32		generation;
 
-	session_context = pool_get_session_context(false);
-
-	local_session_id = pool_get_local_session_id();
+	local_session_id = relcache_session_id(relcache);
 	if (local_session_id < 0)
 		return NULL;
 
+	/* Obtain database name and node id to be sent query */
+	node_id = pool_relcache_query_node(backend, &dbname);
+
+	now = time(NULL);
+
 	/*
-	 * Obtain database name and node id to be sent query.  If
-	 * relcache_query_target is RELQTARGET_LOADL_BALANCE_NODE, we consider
-	 * load balance node id to be used to send queries.
-	 * 
-	 * Note that we need to use VALID_BACKEND_RAW, rather than VALID_BACKEND
-	 * since pool_is_node_to_be_sent_in_current_query(being called by
-	 * VALID_BACKEND) assumes that if query context exists, where_to_send map
-	 * is already setup but it's not always the case because
-	 * pool_search_relcache is mostly called *before* the where_to_send map is
-	 * established.
+	 * Take the generation before looking at the catalog, so that DDL done
+	 * while we are querying invalidates the entry.
 	 */
-	if (pool_config->relcache_query_target == RELQTARGET_LOAD_BALANCE_NODE &&
-		session_context && VALID_BACKEND_RAW(session_context->load_balance_node_id) &&
-		backend->slots[session_context->load_balance_node_id])
-	{
-		dbname = backend->slots[session_context->load_balance_node_id]->sp->database;
-		node_id = session_context->load_balance_node_id;
-	}
-	else
+	generation = pool_shared_relcache_generation(dbname);
+
+	/* Look for cache first */
+	entry = relcache_lookup(relcache, dbname, table, local_session_id, now);
+	if (entry)
 	{
-		dbname = MASTER_CONNECTION(backend)->sp->database;
-		node_id = MASTER_NODE_ID;
+		ereport(DEBUG1,
+				(errmsg("hit local relation cache"),
+				errdetail("query:%s", relcache->sql)));
+
+		return entry->data;
 	}
 
-	now = time(NULL);
+	/* Not in cache. Check the system catalog */
+	snprintf(query, sizeof(query), relcache->sql, table);
 
-	/* Look for cache first */
-	for (i = 0; i < relcache->num; i++)
+	/*
+	 * Session local caches hold information only valid in the session, e.g.
+	 * temporary tables, so they are never shared among child processes.
+	 */
+	shared = pool_config->enable_shared_relcache && !relcache->cache_is_session_local;
+
+	if (shared)
 	{
-		/*
-		 * If cache is session local, we need to check session id
-		 */
-		if (relcache->cache_is_session_local)
-		{
-			if (relcache->cache[i].session_id != local_session_id)
-				continue;
-		}
+		shared_relcache_key(dbname, query, shared_key);
 
-		if (strcasecmp(relcache->cache[i].dbname, dbname) == 0 &&
-			strcasecmp(relcache->cache[i].relname, table) == 0)
+		if (shared_relcache_fetch(shared_key, shared_data, &shared_data_len, now))
 		{
-			if (relcache->cache[i].expire > 0)
-			{
-				if (now > relcache->cache[i].expire)
-				{
-					ereport(DEBUG1,
-							(errmsg("searching relcache"),
-							 errdetail("relcache for database:%s table:%s expired. now:%ld expiration time:%ld", dbname, table, now, relcache->cache[i].expire)));
-
-					relcache->cache[i].refcnt = 0;
-					break;
-				}
-			}
-
-			/* Found */
-			if (relcache->cache[i].refcnt < INT_MAX)
-				relcache->cache[i].refcnt++;
-
 			ereport(DEBUG1,
-					(errmsg("hit local relation cache"),
-					errdetail("query:%s", relcache->sql)));
+					(errmsg("hit shared relation cache"),
+					 errdetail("query:%s", query)));
 
-			return relcache->cache[i].data;
+			res = deserialize_select_result(shared_data, shared_data_len);
+			result = (*relcache->register_func) (res);
+			goto done;
 		}
 	}
 
-	/* Not in cache. Check the system catalog */
-	snprintf(query, sizeof(query), relcache->sql, table);
+	ereport(DEBUG1,
+			(errmsg("not hit relation cache"),
+			 errdetail("query:%s", query)));
 
 	per_node_statement_log(backend, node_id, query);
 
@@ -207,130 +387,277 @@ pool_search_relcache(POOL_RELCACHE * relcache, POOL_CONNECTION_POOL * backend, c
 	callback.previous = error_context_stack;
 	error_context_stack = &callback;
 
-	locked = pool_is_shmem_lock();
-	/*
-	 * if enable_shared_relcache is true, search query cache.
-	 */
-    if (pool_config->enable_shared_relcache)
+	do_query(CONNECTION(backend, node_id), query, &res, MAJOR(backend));
+
+	error_context_stack = callback.previous;
+
+	/* Register cache */
+	result = (*relcache->register_func) (res);
+
+	/* Save the result in the shared relation cache */
+	if (shared && !pool_is_ignore_till_sync())
 	{
-		/* if shmem is not locked by this process, get the lock */
-		if (!locked)
-		{
-			POOL_SETMASK2(&BlockSig, &oldmask);
-			pool_shmem_lock();
-		}
-	    PG_TRY();
-		{
-			/* search catalog cache in query cache */
-			query_cache_not_found = pool_fetch_cache(backend, query, &query_cache_data, &query_cache_len);
-		}
-	    PG_CATCH();
-		{
-			pool_shmem_unlock();
-			POOL_SETMASK(&oldmask);
-	        PG_RE_THROW();
-		}
-		PG_END_TRY();
+		char	   *data;
+		size_t		len;
+
+		data = serialize_select_result(res, &len);
+		if (len <= SHARED_RELCACHE_DATALEN)
+			shared_relcache_store(shared_key, dbname, table, data, len, now);
+		pfree(data);
 	}
-	/* If not in query cache or not used, send query for backend. */
-	if (query_cache_not_found)
+
+done:
+	if (relcache->num > 0 && !pool_is_ignore_till_sync() &&
+		(!relcache->no_cache_if_zero || result))
+		relcache_insert(relcache, dbname, table, local_session_id, now, generation, result);
+
+	free_select_result(res);
+	return result;
+}
+
+/*
+ * Return the session id part of the cache key, or -1 if there's no
+ * session.  Session id is a part of the key only if cache is session
+ * local.
+ */
+static int
+relcache_session_id(POOL_RELCACHE * relcache)
+{
+	int			local_session_id;
+
+	local_session_id = pool_get_local_session_id();
+	if (local_session_id < 0)
+		return -1;
+
+	return relcache->cache_is_session_local ? local_session_id : 0;
+}
+
+/*
+ * Look for the cache entry. Returns NULL if not found. An expired entry is
+ * removed and NULL is returned.
+ */
+static PoolRelCache *
+relcache_lookup(POOL_RELCACHE * relcache, char *dbname, char *table, int session_id, time_t now)
+{
+	PoolRelCache *entry;
+	char	   *interned;
+	uint32		hashval;
+	int			index;
+
+	interned = relcache_intern_dbname(relcache, dbname, false);
+	if (!interned || relcache->num <= 0)
+		return NULL;
+
+	hashval = relcache_hash(dbname, table, session_id);
+
+	for (index = relcache->buckets[hashval & (relcache->nbuckets - 1)]; index >= 0; index = entry->next)
 	{
-		ereport(DEBUG1,
-				(errmsg("not hit local relation cache and query cache"),
-				errdetail("query:%s", query)));
-
-		do_query(CONNECTION(backend, node_id), query, &res, MAJOR(backend));
-		/* Register cache */
-		result = (*relcache->register_func) (res);
-		/* save local catalog cache in query cache */
-	    if (pool_config->enable_shared_relcache)
+		entry = &relcache->cache[index];
+
+		if (entry->hashval != hashval ||
+			entry->dbname != interned ||
+			entry->session_id != session_id ||
+			strcasecmp(entry->relname, table) != 0)
+			continue;
+
+		if (entry->expire > 0 && now > entry->expire)
 		{
-			query_cache_data = relation_cache_to_query_cache(res, &query_cache_len);
-			pool_catalog_commit_cache(backend, query, query_cache_data, query_cache_len);
+			ereport(DEBUG1,
+					(errmsg("searching relcache"),
+					 errdetail("relcache for database:%s table:%s expired. now:%ld expiration time:%ld", dbname, table, now, entry->expire)));
+
+			relcache_remove_entry(relcache, index);
+			return NULL;
 		}
-	}
-	else
-	{
-		ereport(DEBUG1,
-				(errmsg("hit query cache"),
-				errdetail("query:%s", query)));
 
-		/* catalog cache found in query_cache, copy local relation cache */
-		res = query_cache_to_relation_cache(query_cache_data,query_cache_len);
-		result = (*relcache->register_func) (res);
-	}
-	/* if shmem is locked by this function, unlock it */
-	if (pool_config->enable_shared_relcache && !locked)
-	{
-		pool_shmem_unlock();
-		POOL_SETMASK(&oldmask);
+		/* DDL may have been done by other process since we cached it */
+		if (entry->generation != pool_shared_relcache_generation(dbname))
+		{
+			ereport(DEBUG1,
+					(errmsg("searching relcache"),
+					 errdetail("relcache for database:%s table:%s invalidated by DDL", dbname, table)));
+
+			relcache_remove_entry(relcache, index);
+			return NULL;
+		}
+
+		/* Found. Move it to the head of LRU list. */
+		relcache_lru_unlink(relcache, index);
+		relcache_lru_push(relcache, index);
+		return entry;
 	}
+	return NULL;
+}
 
-	error_context_stack = callback.previous;
+/*
+ * Register the data to the cache. The caller must make sure that the
+ * table is not in the cache yet. generation is the shared relation cache
+ * generation taken before the data was obtained.
+ */
+static void
+relcache_insert(POOL_RELCACHE * relcache, char *dbname, char *table, int session_id, time_t now, uint32 generation, void *data)
+{
+	PoolRelCache *entry;
+	uint32		hashval;
+	int			bucket;
+	int			index;
+
+	hashval = relcache_hash(dbname, table, session_id);
+	bucket = hashval & (relcache->nbuckets - 1);
 
 	/*
-	 * Look for replacement in cache
+	 * Take a free entry. If there's none, evict the least recently used
+	 * entry.
 	 */
-	for (i = 0; i < relcache->num; i++)
+	if (relcache->free_list < 0)
 	{
 		/*
-		 * If cache is session local, we can discard old cache immediately
+		 * Entries of old sessions in a session local cache are just garbage
+		 * and we can discard them silently.
 		 */
-		if (relcache->cache_is_session_local)
-		{
-			if (relcache->cache[i].session_id != local_session_id)
-			{
-				index = i;
-				relcache->cache[i].refcnt = 0;
-				break;
-			}
-		}
-
-		if (relcache->cache[i].refcnt == 0)
-		{
-			/* Found empty slot */
-			index = i;
-			break;
-		}
-		else if (relcache->cache[i].refcnt < maxrefcnt)
-		{
-			maxrefcnt = relcache->cache[i].refcnt;
-			index = i;
-		}
+		if (!relcache->cache_is_session_local ||
+			relcache->cache[relcache->lru_tail].session_id == session_id)
+			ereport(LOG,
+					(errmsg("searching relcache. cache replacement occured")));
+		relcache_remove_entry(relcache, relcache->lru_tail);
 	}
-
-	if (relcache->cache[index].refcnt != 0)
+	index = relcache->free_list;
+	entry = &relcache->cache[index];
+	relcache->free_list = entry->next;
+
+	entry->dbname = relcache_intern_dbname(relcache, dbname, true);
+	entry->relname = MemoryContextStrdup(TopMemoryContext, table);
+	entry->hashval = hashval;
+	entry->session_id = session_id;
+	if (pool_config->relcache_expire > 0)
 	{
-		ereport(LOG,
-				(errmsg("searching relcache. cache replacement occured")));
+		entry->expire = now + pool_config->relcache_expire;
+	}
+	else
+	{
+		entry->expire = 0;
+	}
+	entry->generation = generation;
+	entry->data = data;
 
+	entry->next = relcache->buckets[bucket];
+	relcache->buckets[bucket] = index;
+	relcache_lru_push(relcache, index);
+}
+
+/*
+ * Return interned database name. If not interned yet and "create" is
+ * true, intern it, otherwise return NULL. There are only a few databases
+ * used by a process, so linear search is good enough.
+ */
+static char *
+relcache_intern_dbname(POOL_RELCACHE * relcache, char *dbname, bool create)
+{
+	PoolRelCacheDbName *d;
+
+	for (d = relcache->dbnames; d; d = d->next)
+	{
+		if (strcasecmp(d->name, dbname) == 0)
+			return d->name;
 	}
 
-	if (!pool_is_ignore_till_sync() && (!relcache->no_cache_if_zero || result))
+	if (!create)
+		return NULL;
+
+	d = MemoryContextAlloc(TopMemoryContext,
+						   offsetof(PoolRelCacheDbName, name) + strlen(dbname) + 1);
+	strcpy(d->name, dbname);
+	d->next = relcache->dbnames;
+	relcache->dbnames = d;
+	return d->name;
+}
+
+/*
+ * Calculate case insensitive hash value of the cache key using FNV-1a.
+ */
+static uint32
+relcache_hash(char *dbname, char *relname, int session_id)
+{
+	uint32		h = 2166136261U;
+	unsigned char *p;
+
+	for (p = (unsigned char *) dbname; *p; p++)
+		h = (h ^ tolower(*p)) * 16777619U;
+	h = (h ^ '\0') * 16777619U;
+	for (p = (unsigned char *) relname; *p; p++)
+		h = (h ^ tolower(*p)) * 16777619U;
+	h = (h ^ (uint32) session_id) * 16777619U;
+
+	return h;
+}
+
+/*
+ * Remove the entry from LRU list.
+ */
+static void
+relcache_lru_unlink(POOL_RELCACHE * relcache, int index)
+{
+	PoolRelCache *entry = &relcache->cache[index];
+
+	if (entry->lru_prev >= 0)
+		relcache->cache[entry->lru_prev].lru_next = entry->lru_next;
+	else
+		relcache->lru_head = entry->lru_next;
+
+	if (entry->lru_next >= 0)
+		relcache->cache[entry->lru_next].lru_prev = entry->lru_prev;
+	else
+		relcache->lru_tail = entry->lru_prev;
+
+	entry->lru_prev = entry->lru_next = -1;
+}
+
+/*
+ * Add the entry to the head of LRU list.
+ */
+static void
+relcache_lru_push(POOL_RELCACHE * relcache, int index)
+{
+	PoolRelCache *entry = &relcache->cache[index];
+
+	entry->lru_prev = -1;
+	entry->lru_next = relcache->lru_head;
+	if (relcache->lru_head >= 0)
+		relcache->cache[relcache->lru_head].lru_prev = index;
+	relcache->lru_head = index;
+	if (relcache->lru_tail < 0)
+		relcache->lru_tail = index;
+}
+
+/*
+ * Unregister the entry data, remove the entry from the hash chain and LRU
+ * list and return it to the free list.
+ */
+static void
+relcache_remove_entry(POOL_RELCACHE * relcache, int index)
+{
+	PoolRelCache *entry = &relcache->cache[index];
+	int		   *p;
+
+	for (p = &relcache->buckets[entry->hashval & (relcache->nbuckets - 1)];
+		 *p >= 0; p = &relcache->cache[*p].next)
 	{
-		strlcpy(relcache->cache[index].dbname, dbname, MAX_ITEM_LENGTH);
-		strlcpy(relcache->cache[index].relname, table, MAX_ITEM_LENGTH);
-		relcache->cache[index].refcnt = 1;
-		relcache->cache[index].session_id = local_session_id;
-		if (pool_config->relcache_expire > 0)
+		if (*p == index)
 		{
-			relcache->cache[index].expire = now + pool_config->relcache_expire;
-		}
-		else
-		{
-			relcache->cache[index].expire = 0;
+			*p = entry->next;
+			break;
 		}
-
-		/*
-		 * Call user defined unregister/register function.
-		 */
-		(*relcache->unregister_func) (relcache->cache[index].data);
-		relcache->cache[index].data = result;
 	}
-	free_select_result(res);
-	if (query_cache_data)
-		pfree(query_cache_data);
-	return result;
+	relcache_lru_unlink(relcache, index);
+
+	(*relcache->unregister_func) (entry->data);
+	pfree(entry->relname);
+	entry->relname = NULL;
+	entry->dbname = NULL;
+	entry->data = NULL;
+
+	entry->next = relcache->free_list;
+	relcache->free_list = index;
 }
 
 static void
@@ -396,8 +723,12 @@ string_unregister_func(void *data)
 	return (void *) 0;
 }
 
+/*
+ * Rebuild query result from the data serialized by
+ * serialize_select_result().
+ */
 static POOL_SELECT_RESULT *
-query_cache_to_relation_cache(char *data, size_t size)
+deserialize_select_result(char *data, size_t size)
 {
 	POOL_SELECT_RESULT *res;
 	char *p;
@@ -443,8 +774,12 @@ query_cache_to_relation_cache(char *data, size_t size)
 	return res;
 }
 
+/*
+ * Serialize query result so that it can be stored in the shared relation
+ * cache. The length of the data is set to *size.
+ */
 static char *
-relation_cache_to_query_cache(POOL_SELECT_RESULT *res,size_t *size)
+serialize_select_result(POOL_SELECT_RESULT *res,size_t *size)
 {
 	char * data;
 	char * p;
@@ -499,3 +834,574 @@ relation_cache_to_query_cache(POOL_SELECT_RESULT *res,size_t *size)
 
 	return data;
 }
+
+/*
+ * Shared relation cache modules.
+ *
+ * Query results of relcache queries are kept in shared memory too, so
+ * that a child process can use catalog information already obtained by
+ * other child processes.  An entry is looked up by md5 hash of the
+ * database name and the query, and remembers the table name so that it
+ * can be invalidated when DDL against the table is detected.  Entries
+ * expire after relcache_expire seconds as local cache entries do.
+ */
+static PoolSharedRelCacheHeader *shared_relcache_header;
+static int *shared_relcache_buckets;
+static PoolSharedRelCacheEntry *shared_relcache_entries;
+
+/*
+ * Objects modified by DDL in the current transaction. The cache entries
+ * of them are invalidated again at the end of transaction because other
+ * child processes may have cached the catalog information before the DDL
+ * is committed.
+ */
+#define MAX_PENDING_INVALIDATIONS	32
+
+typedef struct
+{
+	char		dbname[NAMEDATALEN];
+	char		relname[NAMEDATALEN];
+}			PendingInvalidation;
+
+static PendingInvalidation pending_invalidations[MAX_PENDING_INVALIDATIONS];
+static int	num_pending_invalidations;
+static bool pending_invalidations_overflow;
+static bool pending_function_invalidation;
+
+/*
+ * Return number of hash buckets, which is the power of 2 not less than
+ * shared_relcache_size.
+ */
+static int
+shared_relcache_nbuckets(void)
+{
+	int			nbuckets;
+
+	for (nbuckets = 1; nbuckets < pool_config->shared_relcache_size; nbuckets <<= 1)
+		;
+	return nbuckets;
+}
+
+/*
+ * Return shared memory size for the shared relation cache.
+ */
+size_t
+pool_shared_relcache_size(void)
+{
+	return MAXALIGN(sizeof(PoolSharedRelCacheHeader)) +
+		MAXALIGN(sizeof(int) * shared_relcache_nbuckets()) +
+		sizeof(PoolSharedRelCacheEntry) * pool_config->shared_relcache_size;
+}
+
+/*
+ * Allocate and initialize the shared relation cache. Called by the main
+ * process at startup.
+ */
+void
+pool_init_shared_relcache(void)
+{
+	char	   *p;
+	size_t		size;
+	int			nbuckets;
+	int			i;
+
+	size = pool_shared_relcache_size();
+	nbuckets = shared_relcache_nbuckets();
+
+	ereport(DEBUG1,
+			(errmsg("shared relation cache: %d entries, %zu bytes requested for shared memory",
+					pool_config->shared_relcache_size, size)));
+
+	p = pool_shared_memory_create(size);
+
+	shared_relcache_header = (PoolSharedRelCacheHeader *) p;
+	p += MAXALIGN(sizeof(PoolSharedRelCacheHeader));
+	shared_relcache_buckets = (int *) p;
+	p += MAXALIGN(sizeof(int) * nbuckets);
+	shared_relcache_entries = (PoolSharedRelCacheEntry *) p;
+
+	shared_relcache_header->num_entries = pool_config->shared_relcache_size;
+	shared_relcache_header->nbuckets = nbuckets;
+	shared_relcache_header->clock_hand = 0;
+	memset(shared_relcache_header->generations, 0, sizeof(shared_relcache_header->generations));
+	shared_relcache_header->function_generation = 0;
+
+	for (i = 0; i < nbuckets; i++)
+		shared_relcache_buckets[i] = -1;
+
+	for (i = 0; i < pool_config->shared_relcache_size; i++)
+		shared_relcache_entries[i].next = i + 1;
+	shared_relcache_entries[pool_config->shared_relcache_size - 1].next = -1;
+	shared_relcache_header->free_list = 0;
+}
+
+static void
+shared_relcache_lock(pool_sigset_t *oldmask)
+{
+	POOL_SETMASK2(&BlockSig, oldmask);
+	pool_semaphore_lock(SHARED_RELCACHE_SEM);
+}
+
+static void
+shared_relcache_unlock(pool_sigset_t *oldmask)
+{
+	pool_semaphore_unlock(SHARED_RELCACHE_SEM);
+	POOL_SETMASK(oldmask);
+}
+
+/*
+ * Return the slot of the generation of the database. Databases hashed to
+ * the same slot share the generation, which just invalidates local caches
+ * more than needed.
+ */
+static int
+shared_relcache_generation_slot(char *dbname)
+{
+	return relcache_hash(dbname, "", 0) & (SHARED_RELCACHE_GENERATION_SLOTS - 1);
+}
+
+/*
+ * Return current generation of the database in the shared relation cache,
+ * or 0 if it's not enabled. Local cache entries taken in an older
+ * generation are discarded because other processes may have seen DDL on the
+ * database since then, which only invalidates the shared entries
+ * directly. The lock is not needed to read an aligned 32 bit integer.
+ */
+uint32
+pool_shared_relcache_generation(char *dbname)
+{
+	if (!pool_config->enable_shared_relcache || !shared_relcache_header)
+		return 0;
+
+	return *((volatile uint32 *) &shared_relcache_header->generations[shared_relcache_generation_slot(dbname)]);
+}
+
+/*
+ * Return current generation of functions, or 0 if the shared relation
+ * cache is not enabled. IMMUTABLE function maps loaded in an older
+ * generation are reloaded.
+ */
+uint32
+pool_shared_function_generation(void)
+{
+	if (!pool_config->enable_shared_relcache || !shared_relcache_header)
+		return 0;
+
+	return *((volatile uint32 *) &shared_relcache_header->function_generation);
+}
+
+/*
+ * Let all the processes reload their IMMUTABLE function maps.
+ */
+static void
+shared_relcache_invalidate_functions(void)
+{
+	pool_sigset_t oldmask;
+
+	shared_relcache_lock(&oldmask);
+	shared_relcache_header->function_generation++;
+	shared_relcache_unlock(&oldmask);
+
+	ereport(DEBUG1,
+			(errmsg("invalidated IMMUTABLE function maps")));
+}
+
+/*
+ * Build cache key of the shared relation cache from the database name
+ * and the query.
+ */
+static void
+shared_relcache_key(char *dbname, char *query, char *key)
+{
+	char		buf[NAMEDATALEN + 1024 + 1];
+	int			len;
+
+	len = snprintf(buf, sizeof(buf), "%s:%s", dbname, query);
+	if (len >= sizeof(buf))
+		len = sizeof(buf) - 1;
+	pool_md5_hash(buf, len, key);
+}
+
+/*
+ * Strip schema name and quotes from the table name and downcase it. The
+ * result is stored in buf, which must be NAMEDATALEN bytes long.  Since
+ * quoted names are downcased too, invalidation may hit other tables with
+ * the same name but it's harmless.
+ */
+static void
+shared_relcache_normalize_relname(char *relname, char *buf)
+{
+	char	   *p;
+	int			i;
+
+	p = remove_quotes_and_schema_from_relname(relname);
+	for (i = 0; p[i] && i < NAMEDATALEN - 1; i++)
+		buf[i] = tolower((unsigned char) p[i]);
+	buf[i] = '\0';
+}
+
+static int
+shared_relcache_bucket(char *key)
+{
+	uint32		h = 2166136261u;
+
+	while (*key)
+	{
+		h ^= (unsigned char) *key++;
+		h *= 16777619u;
+	}
+	return h & (shared_relcache_header->nbuckets - 1);
+}
+
+/*
+ * Return index of the entry for the key, or -1 if not found. The caller
+ * must hold the lock.
+ */
+static int
+shared_relcache_find(char *key)
+{
+	int			index;
+
+	for (index = shared_relcache_buckets[shared_relcache_bucket(key)]; index >= 0;
+		 index = shared_relcache_entries[index].next)
+	{
+		if (strcmp(shared_relcache_entries[index].key, key) == 0)
+			return index;
+	}
+	return -1;
+}
+
+/*
+ * Unlink the entry from its hash chain and return it to the free list.
+ * The caller must hold the lock.
+ */
+static void
+shared_relcache_remove(int index)
+{
+	PoolSharedRelCacheEntry *entry = &shared_relcache_entries[index];
+	int		   *p;
+
+	for (p = &shared_relcache_buckets[shared_relcache_bucket(entry->key)]; *p >= 0;
+		 p = &shared_relcache_entries[*p].next)
+	{
+		if (*p == index)
+		{
+			*p = entry->next;
+			break;
+		}
+	}
+
+	entry->key[0] = '\0';
+	entry->next = shared_relcache_header->free_list;
+	shared_relcache_header->free_list = index;
+}
+
+/*
+ * Copy serialized query result of the key into data, which must be
+ * SHARED_RELCACHE_DATALEN bytes long. Returns false if not found.
+ */
+static bool
+shared_relcache_fetch(char *key, char *data, int *len, time_t now)
+{
+	pool_sigset_t oldmask;
+	PoolSharedRelCacheEntry *entry;
+	int			index;
+	bool		found = false;
+
+	shared_relcache_lock(&oldmask);
+
+	index = shared_relcache_find(key);
+	if (index >= 0)
+	{
+		entry = &shared_relcache_entries[index];
+		if (entry->expire > 0 && entry->expire <= now)
+		{
+			/* expired */
+			shared_relcache_remove(index);
+		}
+		else
+		{
+			memcpy(data, entry->data, entry->data_len);
+			*len = entry->data_len;
+			found = true;
+		}
+	}
+
+	shared_relcache_unlock(&oldmask);
+
+	return found;
+}
+
+/*
+ * Store serialized query result. If there's no free entry, evict one in
+ * round robin manner.
+ */
+static void
+shared_relcache_store(char *key, char *dbname, char *relname, char *data, int len, time_t now)
+{
+	pool_sigset_t oldmask;
+	PoolSharedRelCacheEntry *entry;
+	char		normalized[NAMEDATALEN];
+	int			index;
+	int			bucket;
+
+	shared_relcache_normalize_relname(relname, normalized);
+
+	shared_relcache_lock(&oldmask);
+
+	/* Other process may have registered it already */
+	index = shared_relcache_find(key);
+	if (index < 0)
+	{
+		if (shared_relcache_header->free_list < 0)
+		{
+			shared_relcache_remove(shared_relcache_header->clock_hand);
+			shared_relcache_header->clock_hand =
+				(shared_relcache_header->clock_hand + 1) % shared_relcache_header->num_entries;
+		}
+		index = shared_relcache_header->free_list;
+		entry = &shared_relcache_entries[index];
+		shared_relcache_header->free_list = entry->next;
+
+		StrNCpy(entry->key, key, sizeof(entry->key));
+		bucket = shared_relcache_bucket(key);
+		entry->next = shared_relcache_buckets[bucket];
+		shared_relcache_buckets[bucket] = index;
+	}
+	else
+		entry = &shared_relcache_entries[index];
+
+	StrNCpy(entry->dbname, dbname, sizeof(entry->dbname));
+	StrNCpy(entry->relname, normalized, sizeof(entry->relname));
+	entry->expire = pool_config->relcache_expire > 0 ? now + pool_config->relcache_expire : 0;
+	memcpy(entry->data, data, len);
+	entry->data_len = len;
+
+	shared_relcache_unlock(&oldmask);
+}
+
+/*
+ * Invalidate shared relation cache entries of the table in the
+ * database. If relname is NULL, all entries of the database are
+ * invalidated.
+ */
+void
+pool_invalidate_shared_relcache(char *dbname, char *relname)
+{
+	pool_sigset_t oldmask;
+	char		normalized[NAMEDATALEN];
+	int			num_invalidated = 0;
+	int			i;
+
+	if (!pool_config->enable_shared_relcache)
+		return;
+
+	if (relname)
+		shared_relcache_normalize_relname(relname, normalized);
+
+	shared_relcache_lock(&oldmask);
+
+	for (i = 0; i < shared_relcache_header->num_entries; i++)
+	{
+		PoolSharedRelCacheEntry *entry = &shared_relcache_entries[i];
+
+		if (entry->key[0] == '\0' || strcmp(entry->dbname, dbname))
+			continue;
+
+		if (relname && strcmp(entry->relname, normalized))
+			continue;
+
+		shared_relcache_remove(i);
+		num_invalidated++;
+	}
+
+	shared_relcache_header->generations[shared_relcache_generation_slot(dbname)]++;
+
+	shared_relcache_unlock(&oldmask);
+
+	ereport(DEBUG1,
+			(errmsg("invalidated %d shared relation cache entries", num_invalidated),
+			 errdetail("database: \"%s\" table: \"%s\"", dbname, relname ? relname : "*")));
+}
+
+/*
+ * Invalidate shared relation cache entries of the object modified by DDL.
+ * If relname is NULL, all entries of the database are invalidated.  If we
+ * are inside a transaction, remember it to invalidate again at the end of
+ * the transaction.
+ */
+static void
+shared_relcache_invalidate_object(POOL_CONNECTION_POOL * backend, char *relname)
+{
+	char	   *dbname;
+	PendingInvalidation *pending;
+
+	pool_relcache_query_node(backend, &dbname);
+	pool_invalidate_shared_relcache(dbname, relname);
+
+	if (TSTATE(backend, MASTER_NODE_ID) != 'T')
+		return;
+
+	/* Whole database is invalidated at the end of the transaction */
+	if (relname == NULL || num_pending_invalidations >= MAX_PENDING_INVALIDATIONS)
+	{
+		pending_invalidations_overflow = true;
+		return;
+	}
+
+	pending = &pending_invalidations[num_pending_invalidations++];
+	StrNCpy(pending->dbname, dbname, sizeof(pending->dbname));
+	StrNCpy(pending->relname, relname, sizeof(pending->relname));
+}
+
+/*
+ * Invalidate object given by a (possibly qualified) name list.
+ */
+static void
+shared_relcache_invalidate_name_list(POOL_CONNECTION_POOL * backend, List *names)
+{
+	if (names && IsA(llast(names), String))
+		shared_relcache_invalidate_object(backend, strVal(llast(names)));
+}
+
+/*
+ * Called when a statement successfully completed. If the statement is a
+ * DDL which may change the catalog information cached, invalidate the
+ * shared relation cache entries of the objects.
+ */
+void
+pool_shared_relcache_handle_stmt(POOL_CONNECTION_POOL * backend, Node *node)
+{
+	ListCell   *cell;
+
+	if (!pool_config->enable_shared_relcache)
+		return;
+
+	if (pool_is_function_ddl(node))
+	{
+		shared_relcache_invalidate_functions();
+		if (TSTATE(backend, MASTER_NODE_ID) == 'T')
+			pending_function_invalidation = true;
+	}
+
+	if (IsA(node, TransactionStmt))
+	{
+		TransactionStmt *stmt = (TransactionStmt *) node;
+		char	   *dbname;
+		int			i;
+
+		if (stmt->kind != TRANS_STMT_COMMIT && stmt->kind != TRANS_STMT_ROLLBACK &&
+			stmt->kind != TRANS_STMT_PREPARE)
+			return;
+
+		/*
+		 * Other processes may have cached the catalog information before the
+		 * DDL was committed.
+		 */
+		if (stmt->kind == TRANS_STMT_COMMIT || stmt->kind == TRANS_STMT_PREPARE)
+		{
+			if (pending_invalidations_overflow)
+			{
+				pool_relcache_query_node(backend, &dbname);
+				pool_invalidate_shared_relcache(dbname, NULL);
+			}
+			else
+			{
+				for (i = 0; i < num_pending_invalidations; i++)
+					pool_invalidate_shared_relcache(pending_invalidations[i].dbname,
+													pending_invalidations[i].relname);
+			}
+			if (pending_function_invalidation)
+				shared_relcache_invalidate_functions();
+		}
+		num_pending_invalidations = 0;
+		pending_invalidations_overflow = false;
+		pending_function_invalidation = false;
+	}
+	else if (IsA(node, CreateStmt) || IsA(node, CreateForeignTableStmt))
+	{
+		RangeVar   *relation = ((CreateStmt *) node)->relation;
+
+		/*
+		 * Temporary tables are only visible to the session, whose
+		 * information is kept in session local caches.
+		 */
+		if (relation->relpersistence != RELPERSISTENCE_TEMP)
+			shared_relcache_invalidate_object(backend, relation->relname);
+	}
+	else if (IsA(node, AlterTableStmt))
+	{
+		shared_relcache_invalidate_object(backend, ((AlterTableStmt *) node)->relation->relname);
+	}
+	else if (IsA(node, ViewStmt))
+	{
+		RangeVar   *view = ((ViewStmt *) node)->view;
+
+		if (view->relpersistence != RELPERSISTENCE_TEMP)
+			shared_relcache_invalidate_object(backend, view->relname);
+	}
+	else if (IsA(node, CreateTableAsStmt))
+	{
+		RangeVar   *rel = ((CreateTableAsStmt *) node)->into->rel;
+
+		if (rel->relpersistence != RELPERSISTENCE_TEMP)
+			shared_relcache_invalidate_object(backend, rel->relname);
+	}
+	else if (IsA(node, CreateFunctionStmt))
+	{
+		shared_relcache_invalidate_name_list(backend, ((CreateFunctionStmt *) node)->funcname);
+	}
+	else if (IsA(node, AlterFunctionStmt))
+	{
+		shared_relcache_invalidate_name_list(backend, ((AlterFunctionStmt *) node)->func->objname);
+	}
+	else if (IsA(node, RenameStmt))
+	{
+		RenameStmt *stmt = (RenameStmt *) node;
+
+		/* Renaming a schema affects all the objects in it */
+		if (stmt->renameType == OBJECT_SCHEMA)
+			shared_relcache_invalidate_object(backend, NULL);
+		else if (stmt->relation)
+			shared_relcache_invalidate_object(backend, stmt->relation->relname);
+		else if (stmt->object && IsA(stmt->object, ObjectWithArgs))
+			shared_relcache_invalidate_name_list(backend, ((ObjectWithArgs *) stmt->object)->objname);
+
+		/* Negative entries of the new name may have been cached */
+		if (stmt->newname)
+			shared_relcache_invalidate_object(backend, stmt->newname);
+	}
+	else if (IsA(node, AlterObjectSchemaStmt))
+	{
+		AlterObjectSchemaStmt *stmt = (AlterObjectSchemaStmt *) node;
+
+		if (stmt->relation)
+			shared_relcache_invalidate_object(backend, stmt->relation->relname);
+		else if (stmt->object && IsA(stmt->object, ObjectWithArgs))
+			shared_relcache_invalidate_name_list(backend, ((ObjectWithArgs *) stmt->object)->objname);
+	}
+	else if (IsA(node, DropStmt))
+	{
+		DropStmt   *stmt = (DropStmt *) node;
+
+		/*
+		 * Objects dropped by DROP SCHEMA or CASCADE are not known here, so
+		 * invalidate all the entries of the database.
+		 */
+		if (stmt->removeType == OBJECT_SCHEMA || stmt->behavior == DROP_CASCADE)
+		{
+			shared_relcache_invalidate_object(backend, NULL);
+			return;
+		}
+
+		foreach(cell, stmt->objects)
+		{
+			Node	   *object = lfirst(cell);
+
+			if (IsA(object, List))
+				shared_relcache_invalidate_name_list(backend, (List *) object);
+			else if (IsA(object, ObjectWithArgs))
+				shared_relcache_invalidate_name_list(backend, ((ObjectWithArgs *) object)->objname);
+		}
+	}
+}
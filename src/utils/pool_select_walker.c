@@ -23,25 +23,97 @@
 
 #include "pool.h"
 #include "utils/elog.h"
+#include "utils/palloc.h"
+#include "utils/memutils.h"
 #include "pool_config.h"
 #include "utils/pool_select_walker.h"
 #include "utils/pool_relcache.h"
 #include "parser/parsenodes.h"
+#include "parser/stringinfo.h"
 #include "context/pool_session_context.h"
 #include "rewrite/pool_timestamp.h"
 
-static bool function_call_walker(Node *node, void *context);
-static bool system_catalog_walker(Node *node, void *context);
+static bool select_analysis_walker(Node *node, void *context);
+static bool select_analysis_done(SelectContext * ctx);
+static bool is_writing_function(char *fname);
 static bool is_system_catalog(char *table_name);
-static bool temp_table_walker(Node *node, void *context);
-static bool unlogged_table_walker(Node *node, void *context);
-static bool view_walker(Node *node, void *context);
 static bool is_temp_table(char *table_name);
-static bool insertinto_or_locking_clause_walker(Node *node, void *context);
-static bool is_immutable_function(char *fname);
-static bool select_table_walker(Node *node, void *context);
-static bool non_immutable_function_call_walker(Node *node, void *context);
+static bool is_immutable_function(char *schema, char *fname);
 static char *strip_quote(char *str);
+static bool relation_name_walker(Node *node, void *context);
+static void prefetch_relation_info(Node *node, int flags);
+
+/*
+ * Analyze SELECT statement and return the facts specified by "flags"
+ * (bitwise OR of POOL_SELECT_*).  All the requested facts not collected
+ * yet are collected by a single walk over the parse tree.  If "node" is
+ * the parse tree of the current query context, the result is kept in the
+ * query context, so that subsequent calls for the same query do not need
+ * to walk the tree again. Otherwise the result is in static area and is
+ * overwritten by the next call.
+ */
+SelectContext *
+pool_analyze_select_stmt(Node *node, int flags)
+{
+	static SelectContext local_ctx;
+	POOL_SESSION_CONTEXT *session_context;
+	POOL_QUERY_CONTEXT *query_context = NULL;
+	SelectContext *ctx;
+
+	session_context = pool_get_session_context(true);
+	if (session_context)
+		query_context = session_context->query_context;
+
+	if (node && query_context && query_context->parse_tree == node)
+	{
+		if (!query_context->select_analysis)
+			query_context->select_analysis =
+				MemoryContextAlloc(query_context->memory_context, sizeof(SelectContext));
+		ctx = query_context->select_analysis;
+	}
+	else
+		ctx = &local_ctx;
+
+	/* Start over if the result is for other parse tree */
+	if (ctx == &local_ctx || ctx->node != node)
+	{
+		ctx->node = node;
+		ctx->analyzed = 0;
+		ctx->has_system_catalog = false;
+		ctx->has_temp_table = false;
+		ctx->has_unlogged_table = false;
+		ctx->has_view = false;
+		ctx->has_function_call = false;
+		ctx->pg_terminate_backend_pid = 0;
+		ctx->has_non_immutable_function_call = false;
+		ctx->has_insertinto_or_locking_clause = false;
+		ctx->num_oids = 0;
+	}
+
+	flags &= ~ctx->analyzed;
+	if (flags == 0)
+		return ctx;
+
+	if (node && IsA(node, SelectStmt))
+	{
+		prefetch_relation_info(node, flags);
+
+		ctx->requested = flags;
+		raw_expression_tree_walker(node, select_analysis_walker, ctx);
+		ctx->requested = 0;
+	}
+	ctx->analyzed |= flags;
+
+	ereport(DEBUG1,
+			(errmsg("analyzing SELECT statement"),
+			 errdetail("flags: %x system catalog: %d temp table: %d unlogged table: %d view: %d writing function: %d non immutable function: %d insert into or locking clause: %d oids: %d",
+					   flags, ctx->has_system_catalog, ctx->has_temp_table,
+					   ctx->has_unlogged_table, ctx->has_view, ctx->has_function_call,
+					   ctx->has_non_immutable_function_call,
+					   ctx->has_insertinto_or_locking_clause, ctx->num_oids)));
+
+	return ctx;
+}
 
 /*
  * Return true if this SELECT has function calls *and* supposed to
@@ -51,17 +123,10 @@ static char *strip_quote(char *str);
 bool
 pool_has_function_call(Node *node)
 {
-	SelectContext ctx;
-
 	if (!IsA(node, SelectStmt))
 		return false;
 
-	ctx.has_function_call = false;
-	ctx.pg_terminate_backend_pid = -1;
-
-	raw_expression_tree_walker(node, function_call_walker, &ctx);
-
-	return ctx.has_function_call;
+	return pool_analyze_select_stmt(node, POOL_SELECT_FUNCTION_CALL)->has_function_call;
 }
 
 /*
@@ -70,18 +135,10 @@ pool_has_function_call(Node *node)
 int
 pool_get_terminate_backend_pid(Node *node)
 {
-	SelectContext ctx;
-
 	if (!IsA(node, SelectStmt))
 		return false;
 
-	ctx.has_function_call = false;
-	ctx.pg_terminate_backend_pid = 0;
-
-	raw_expression_tree_walker(node, function_call_walker, &ctx);
-
-	return ctx.pg_terminate_backend_pid;
-
+	return pool_analyze_select_stmt(node, POOL_SELECT_TERMINATE_BACKEND)->pg_terminate_backend_pid;
 }
 
 /*
@@ -90,17 +147,10 @@ pool_get_terminate_backend_pid(Node *node)
 bool
 pool_has_system_catalog(Node *node)
 {
-
-	SelectContext ctx;
-
 	if (!IsA(node, SelectStmt))
 		return false;
 
-	ctx.has_system_catalog = false;
-
-	raw_expression_tree_walker(node, system_catalog_walker, &ctx);
-
-	return ctx.has_system_catalog;
+	return pool_analyze_select_stmt(node, POOL_SELECT_SYSTEM_CATALOG)->has_system_catalog;
 }
 
 /*
@@ -109,17 +159,10 @@ pool_has_system_catalog(Node *node)
 bool
 pool_has_temp_table(Node *node)
 {
-
-	SelectContext ctx;
-
 	if (!IsA(node, SelectStmt))
 		return false;
 
-	ctx.has_temp_table = false;
-
-	raw_expression_tree_walker(node, temp_table_walker, &ctx);
-
-	return ctx.has_temp_table;
+	return pool_analyze_select_stmt(node, POOL_SELECT_TEMP_TABLE)->has_temp_table;
 }
 
 /*
@@ -128,17 +171,10 @@ pool_has_temp_table(Node *node)
 bool
 pool_has_unlogged_table(Node *node)
 {
-
-	SelectContext ctx;
-
 	if (!IsA(node, SelectStmt))
 		return false;
 
-	ctx.has_unlogged_table = false;
-
-	raw_expression_tree_walker(node, unlogged_table_walker, &ctx);
-
-	return ctx.has_unlogged_table;
+	return pool_analyze_select_stmt(node, POOL_SELECT_UNLOGGED_TABLE)->has_unlogged_table;
 }
 
 /*
@@ -147,17 +183,10 @@ pool_has_unlogged_table(Node *node)
 bool
 pool_has_view(Node *node)
 {
-
-	SelectContext ctx;
-
 	if (!IsA(node, SelectStmt))
 		return false;
 
-	ctx.has_view = false;
-
-	raw_expression_tree_walker(node, view_walker, &ctx);
-
-	return ctx.has_view;
+	return pool_analyze_select_stmt(node, POOL_SELECT_VIEW)->has_view;
 }
 
 /*
@@ -166,20 +195,10 @@ pool_has_view(Node *node)
 bool
 pool_has_insertinto_or_locking_clause(Node *node)
 {
-	SelectContext ctx;
-
 	if (!IsA(node, SelectStmt))
 		return false;
 
-	ctx.has_insertinto_or_locking_clause = false;
-
-	raw_expression_tree_walker(node, insertinto_or_locking_clause_walker, &ctx);
-
-	ereport(DEBUG1,
-			(errmsg("checking if query has INSERT INTO, FOR SHARE or FOR UPDATE"),
-			 errdetail("result = %d", ctx.has_insertinto_or_locking_clause)));
-
-	return ctx.has_insertinto_or_locking_clause;
+	return pool_analyze_select_stmt(node, POOL_SELECT_INSERTINTO_OR_LOCKING)->has_insertinto_or_locking_clause;
 }
 
 /*
@@ -319,11 +338,10 @@ strip_quote(char *str)
 }
 
 /*
- * Walker function to find a function call which is supposed to write
- * database.
+ * Walker function to collect the facts requested in ctx->requested.
  */
 static bool
-function_call_walker(Node *node, void *context)
+select_analysis_walker(Node *node, void *context)
 {
 	SelectContext *ctx = (SelectContext *) context;
 
@@ -334,6 +352,7 @@ function_call_walker(Node *node, void *context)
 	{
 		FuncCall   *fcall = (FuncCall *) node;
 		char	   *fname;
+		char	   *schema = NULL;
 		int			length = list_length(fcall->funcname);
 
 		if (length > 0)
@@ -344,14 +363,18 @@ function_call_walker(Node *node, void *context)
 			}
 			else
 			{
+				if (length == 2)
+					schema = strVal(linitial(fcall->funcname));
 				fname = strVal(lsecond(fcall->funcname));	/* with schema
 															 * qualification */
 			}
 
 			ereport(DEBUG1,
-					(errmsg("function call walker, function name: \"%s\"", fname)));
+					(errmsg("select analysis walker, function name: \"%s\"", fname)));
 
-			if (ctx->pg_terminate_backend_pid == 0 && strcmp("pg_terminate_backend", fname) == 0)
+			if ((ctx->requested & POOL_SELECT_TERMINATE_BACKEND) &&
+				ctx->pg_terminate_backend_pid == 0 &&
+				strcmp("pg_terminate_backend", fname) == 0)
 			{
 				if (list_length(fcall->args) == 1)
 				{
@@ -367,164 +390,148 @@ function_call_walker(Node *node, void *context)
 				}
 			}
 
-			/*
-			 * Check white list if any.
-			 */
-			if (pool_config->num_white_function_list > 0)
-			{
-				/* Search function in the white list regex patterns */
-				if (pattern_compare(fname, WHITELIST, "white_function_list") == 1)
-				{
-					/*
-					 * If the function is found in the white list, we can
-					 * ignore it
-					 */
-					return raw_expression_tree_walker(node, function_call_walker, context);
-				}
-
-				/*
-				 * Since the function was not found in white list, we have
-				 * found a writing function.
-				 */
+			if ((ctx->requested & POOL_SELECT_FUNCTION_CALL) &&
+				!ctx->has_function_call && is_writing_function(fname))
 				ctx->has_function_call = true;
-				return false;
-			}
 
-			/*
-			 * Check black list if any.
-			 */
-			if (pool_config->num_black_function_list > 0)
-			{
-				/* Search function in the black list regex patterns */
-				if (pattern_compare(fname, BLACKLIST, "black_function_list") == 1)
-				{
-					/* Found. */
-					ctx->has_function_call = true;
-					return false;
-				}
-			}
+			/* Check system catalog if the function is immutable */
+			if ((ctx->requested & POOL_SELECT_NON_IMMUTABLE_FUNCTION) &&
+				!ctx->has_non_immutable_function_call &&
+				is_immutable_function(schema, fname) == false)
+				ctx->has_non_immutable_function_call = true;
 		}
 	}
-	return raw_expression_tree_walker(node, function_call_walker, context);
-}
-
-/*
- * Walker function to find a system catalog
- */
-static bool
-system_catalog_walker(Node *node, void *context)
-{
-	SelectContext *ctx = (SelectContext *) context;
-
-	if (node == NULL)
-		return false;
+	else if (IsA(node, TypeCast))
+	{
+		/* CURRENT_DATE, CURRENT_TIME, LOCALTIMESTAMP, LOCALTIME etc. */
+		TypeCast   *tc = (TypeCast *) node;
 
-	if (IsA(node, RangeVar))
+		if ((ctx->requested & POOL_SELECT_NON_IMMUTABLE_FUNCTION) &&
+			(isSystemType((Node *) tc->typeName, "date") ||
+			 isSystemType((Node *) tc->typeName, "timestamp") ||
+			 isSystemType((Node *) tc->typeName, "timestamptz") ||
+			 isSystemType((Node *) tc->typeName, "time") ||
+			 isSystemType((Node *) tc->typeName, "timetz")))
+			ctx->has_non_immutable_function_call = true;
+	}
+	else if (IsA(node, IntoClause) ||IsA(node, LockingClause))
+	{
+		if (ctx->requested & POOL_SELECT_INSERTINTO_OR_LOCKING)
+			ctx->has_insertinto_or_locking_clause = true;
+	}
+	else if (IsA(node, RangeVar))
 	{
 		RangeVar   *rgv = (RangeVar *) node;
+		char		relname[POOL_NAMEDATALEN * 2 + 1 + 2 * 2 + 1];
+
+		/* make_table_name_from_rangevar() returns static area. Copy it. */
+		strlcpy(relname, make_table_name_from_rangevar(rgv), sizeof(relname));
 
 		ereport(DEBUG1,
-				(errmsg("system catalog walker, checking relation \"%s\"", rgv->relname)));
+				(errmsg("select analysis walker, checking relation \"%s\"", relname)));
 
-		if (is_system_catalog(rgv->relname))
-		{
+		if ((ctx->requested & POOL_SELECT_SYSTEM_CATALOG) &&
+			!ctx->has_system_catalog && is_system_catalog(rgv->relname))
 			ctx->has_system_catalog = true;
-			return false;
-		}
-	}
-	return raw_expression_tree_walker(node, system_catalog_walker, context);
-}
 
-/*
- * Walker function to find a temp table
- */
-static bool
-temp_table_walker(Node *node, void *context)
-{
-	SelectContext *ctx = (SelectContext *) context;
-
-	if (node == NULL)
-		return false;
+		if ((ctx->requested & POOL_SELECT_TEMP_TABLE) &&
+			!ctx->has_temp_table && is_temp_table(rgv->relname))
+			ctx->has_temp_table = true;
 
-	if (IsA(node, RangeVar))
-	{
-		RangeVar   *rgv = (RangeVar *) node;
+		if ((ctx->requested & POOL_SELECT_UNLOGGED_TABLE) &&
+			!ctx->has_unlogged_table && is_unlogged_table(relname))
+			ctx->has_unlogged_table = true;
 
-		ereport(DEBUG1,
-				(errmsg("temporary table walker. checking relation \"%s\"", rgv->relname)));
+		if ((ctx->requested & POOL_SELECT_VIEW) &&
+			!ctx->has_view && is_view(relname))
+			ctx->has_view = true;
 
-		if (is_temp_table(rgv->relname))
+		if ((ctx->requested & POOL_SELECT_TABLE_OIDS) &&
+			ctx->num_oids < POOL_MAX_SELECT_OIDS)
 		{
-			ctx->has_temp_table = true;
-			return false;
+			int			oid = pool_table_name_to_oid(relname);
+
+			if (oid)
+			{
+				int			num_oids = ctx->num_oids++;
+
+				ctx->table_oids[num_oids] = oid;
+				strlcpy(ctx->table_names[num_oids], relname, POOL_NAMEDATALEN);
+
+				ereport(DEBUG1,
+						(errmsg("extracting table oids from SELECT statement"),
+						 errdetail("ctx->table_names[%d] = \"%s\"",
+								   num_oids, ctx->table_names[num_oids])));
+			}
 		}
 	}
-	return raw_expression_tree_walker(node, temp_table_walker, context);
+
+	/* Stop walking if nothing is left to be found */
+	if (select_analysis_done(ctx))
+		return true;
+
+	return raw_expression_tree_walker(node, select_analysis_walker, context);
 }
 
 /*
- * Walker function to find a unlogged table
+ * Return true if all the facts requested have been found and walking
+ * further is useless.
  */
 static bool
-unlogged_table_walker(Node *node, void *context)
+select_analysis_done(SelectContext * ctx)
 {
-	SelectContext *ctx = (SelectContext *) context;
-	char	   *relname;
-
-	if (node == NULL)
-		return false;
-
-	if (IsA(node, RangeVar))
-	{
-		RangeVar   *rgv = (RangeVar *) node;
-
-		relname = make_table_name_from_rangevar(rgv);
-
-		ereport(DEBUG1,
-				(errmsg("unlogged table walker. checking relation \"%s\"", relname)));
-
-		if (is_unlogged_table(relname))
-		{
-			ctx->has_unlogged_table = true;
-			return false;
-		}
-	}
-	return raw_expression_tree_walker(node, unlogged_table_walker, context);
+	int			requested = ctx->requested;
+
+	if (requested & POOL_SELECT_TABLE_OIDS)
+		return ctx->num_oids >= POOL_MAX_SELECT_OIDS;
+
+	return (!(requested & POOL_SELECT_SYSTEM_CATALOG) || ctx->has_system_catalog) &&
+		(!(requested & POOL_SELECT_TEMP_TABLE) || ctx->has_temp_table) &&
+		(!(requested & POOL_SELECT_UNLOGGED_TABLE) || ctx->has_unlogged_table) &&
+		(!(requested & POOL_SELECT_VIEW) || ctx->has_view) &&
+		(!(requested & POOL_SELECT_FUNCTION_CALL) || ctx->has_function_call) &&
+		(!(requested & POOL_SELECT_TERMINATE_BACKEND) || ctx->pg_terminate_backend_pid != 0) &&
+		(!(requested & POOL_SELECT_NON_IMMUTABLE_FUNCTION) || ctx->has_non_immutable_function_call) &&
+		(!(requested & POOL_SELECT_INSERTINTO_OR_LOCKING) || ctx->has_insertinto_or_locking_clause);
 }
 
 /*
- * Walker function to find a view
+ * Return true if the function is supposed to write database.  We check
+ * black/white function list to determine whether the function modifies
+ * database.
  */
 static bool
-view_walker(Node *node, void *context)
+is_writing_function(char *fname)
 {
-	SelectContext *ctx = (SelectContext *) context;
-	char	   *relname;
-
-	if (node == NULL)
-		return false;
-
-	if (IsA(node, RangeVar))
+	/*
+	 * Check white list if any.
+	 */
+	if (pool_config->num_white_function_list > 0)
 	{
-		RangeVar   *rgv = (RangeVar *) node;
-
-		relname = make_table_name_from_rangevar(rgv);
-
-		ereport(DEBUG1,
-				(errmsg("view walker. checking relation \"%s\"", relname)));
+		/*
+		 * If the function is found in the white list, we can ignore it.
+		 * Otherwise we have found a writing function.
+		 */
+		return pattern_compare(fname, WHITELIST, "white_function_list") != 1;
+	}
 
-		if (is_view(relname))
-		{
-			ctx->has_view = true;
-			return false;
-		}
+	/*
+	 * Check black list if any.
+	 */
+	if (pool_config->num_black_function_list > 0)
+	{
+		/* Search function in the black list regex patterns */
+		if (pattern_compare(fname, BLACKLIST, "black_function_list") == 1)
+			return true;
 	}
-	return raw_expression_tree_walker(node, view_walker, context);
+	return false;
 }
 
 /*
  * Determine whether table_name is a system catalog or not.
  */
+static POOL_RELCACHE * system_catalog_relcache;
+
 static bool
 is_system_catalog(char *table_name)
 {
@@ -543,7 +550,6 @@ is_system_catalog(char *table_name)
 #define ISBELONGTOPGCATALOGQUERY3 "SELECT count(*) FROM pg_class AS c, pg_namespace AS n WHERE c.oid = pg_catalog.to_regclass('\"%s\"') AND c.relnamespace = n.oid AND n.nspname = 'pg_catalog'"
 
 	bool		result;
-	static POOL_RELCACHE * relcache;
 	POOL_CONNECTION_POOL *backend;
 
 	if (table_name == NULL)
@@ -564,7 +570,7 @@ is_system_catalog(char *table_name)
 		/*
 		 * If relcache does not exist, create it.
 		 */
-		if (!relcache)
+		if (!system_catalog_relcache)
 		{
 			char	   *query;
 
@@ -583,10 +589,10 @@ is_system_catalog(char *table_name)
 				query = ISBELONGTOPGCATALOGQUERY;
 			}
 
-			relcache = pool_create_relcache(pool_config->relcache_size, query,
-											int_register_func, int_unregister_func,
-											false);
-			if (relcache == NULL)
+			system_catalog_relcache = pool_create_relcache(pool_config->relcache_size, query,
+														   int_register_func, int_unregister_func,
+														   false);
+			if (system_catalog_relcache == NULL)
 			{
 				ereport(WARNING,
 						(errmsg("unable to create relcache, while checking for system catalog")));
@@ -597,7 +603,7 @@ is_system_catalog(char *table_name)
 		/*
 		 * Search relcache.
 		 */
-		result = pool_search_relcache(relcache, backend, table_name) == 0 ? false : true;
+		result = pool_search_relcache(system_catalog_relcache, backend, table_name) == 0 ? false : true;
 		return result;
 	}
 
@@ -727,6 +733,8 @@ discard_temp_table_relcache(void)
 /*
  * Returns true if table_name is an unlogged table.
  */
+static POOL_RELCACHE * unlogged_table_relcache;
+
 bool
 is_unlogged_table(char *table_name)
 {
@@ -746,7 +754,6 @@ is_unlogged_table(char *table_name)
 
 #define ISUNLOGGEDQUERY3 "SELECT count(*) FROM pg_catalog.pg_class AS c WHERE c.oid = pg_catalog.to_regclass('%s') AND c.relpersistence = 'u'"
 
-	static POOL_RELCACHE * relcache;
 	POOL_CONNECTION_POOL *backend;
 	int		major;
 
@@ -787,12 +794,12 @@ is_unlogged_table(char *table_name)
 		/*
 		 * If relcache does not exist, create it.
 		 */
-		if (!relcache)
+		if (!unlogged_table_relcache)
 		{
-			relcache = pool_create_relcache(pool_config->relcache_size, query,
-											int_register_func, int_unregister_func,
-											false);
-			if (relcache == NULL)
+			unlogged_table_relcache = pool_create_relcache(pool_config->relcache_size, query,
+														   int_register_func, int_unregister_func,
+														   false);
+			if (unlogged_table_relcache == NULL)
 			{
 				ereport(WARNING,
 						(errmsg("unable to create relcache, while checking for unlogged table")));
@@ -803,7 +810,7 @@ is_unlogged_table(char *table_name)
 		/*
 		 * Search relcache.
 		 */
-		result = pool_search_relcache(relcache, backend, table_name) == 0 ? false : true;
+		result = pool_search_relcache(unlogged_table_relcache, backend, table_name) == 0 ? false : true;
 		return result;
 	}
 	else
@@ -816,6 +823,8 @@ is_unlogged_table(char *table_name)
  * Returns true if table_name is a view.
  * This function is called by query cache module.
  */
+static POOL_RELCACHE * view_relcache;
+
 bool
 is_view(char *table_name)
 {
@@ -828,7 +837,6 @@ is_view(char *table_name)
 
 #define ISVIEWQUERY3 "SELECT count(*) FROM pg_catalog.pg_class AS c WHERE c.oid = pg_catalog.to_regclass('%s') AND (c.relkind = 'v' OR c.relkind = 'm')"
 
-	static POOL_RELCACHE * relcache;
 	POOL_CONNECTION_POOL *backend;
 	bool		result;
 	char	   *query;
@@ -858,12 +866,12 @@ is_view(char *table_name)
 		query = ISVIEWQUERY;
 	}
 
-	if (!relcache)
+	if (!view_relcache)
 	{
-		relcache = pool_create_relcache(pool_config->relcache_size, query,
-										int_register_func, int_unregister_func,
-										false);
-		if (relcache == NULL)
+		view_relcache = pool_create_relcache(pool_config->relcache_size, query,
+											 int_register_func, int_unregister_func,
+											 false);
+		if (view_relcache == NULL)
 		{
 			ereport(WARNING,
 					(errmsg("unable to create relcache, while checking for view")));
@@ -875,7 +883,7 @@ is_view(char *table_name)
 	/*
 	 * Search relcache.
 	 */
-	result = pool_search_relcache(relcache, backend, table_name) == 0 ? false : true;
+	result = pool_search_relcache(view_relcache, backend, table_name) == 0 ? false : true;
 	return result;
 }
 
@@ -935,140 +943,239 @@ pool_has_to_regclass(void)
 }
 
 /*
- * Walker function to find intoClause or lockingClause.
+ * Return true if this SELECT has non immutable function calls.
  */
-static bool
-insertinto_or_locking_clause_walker(Node *node, void *context)
+bool
+pool_has_non_immutable_function_call(Node *node)
 {
-	SelectContext *ctx = (SelectContext *) context;
-
-	if (node == NULL)
+	if (!IsA(node, SelectStmt))
 		return false;
 
-	if (IsA(node, IntoClause) ||IsA(node, LockingClause))
+	return pool_analyze_select_stmt(node, POOL_SELECT_NON_IMMUTABLE_FUNCTION)->has_non_immutable_function_call;
+}
+
+/*
+ * Map of IMMUTABLE functions in a database. Instead of asking the
+ * system catalog for each function name, all the IMMUTABLE functions are
+ * loaded from pg_proc by a query and looked up by binary search.  The map
+ * is reloaded after relcache_expire seconds, or when function DDL is
+ * executed in this process.  If enable_shared_relcache is on, it is also
+ * reloaded when other processes execute function DDL, which is told by
+ * pool_shared_function_generation().
+ */
+typedef struct
+{
+	char	   *schema;			/* schema name */
+	char	   *name;			/* function name */
+}			ImmutableFunction;
+
+typedef struct ImmutableFunctionMap
+{
+	struct ImmutableFunctionMap *next;	/* map of next database */
+	char	   *dbname;			/* database name */
+	time_t		expire;			/* expiration absolute time in seconds, 0
+								 * means never */
+	uint32		generation;		/* pool_shared_function_generation() when
+								 * loaded */
+	int			nfuncs;			/* number of functions */
+	ImmutableFunction *funcs;	/* functions sorted by name and schema */
+}			ImmutableFunctionMap;
+
+static ImmutableFunctionMap *immutable_function_maps;
+
+static int
+immutable_function_cmp(const void *a, const void *b)
+{
+	const ImmutableFunction *f1 = (const ImmutableFunction *) a;
+	const ImmutableFunction *f2 = (const ImmutableFunction *) b;
+	int			r;
+
+	r = strcmp(f1->name, f2->name);
+	if (r == 0)
+		r = strcmp(f1->schema, f2->schema);
+	return r;
+}
+
+static void
+free_immutable_function_map(ImmutableFunctionMap * map)
+{
+	int			i;
+
+	for (i = 0; i < map->nfuncs; i++)
 	{
-		ctx->has_insertinto_or_locking_clause = true;
-		return false;
+		pfree(map->funcs[i].schema);
+		pfree(map->funcs[i].name);
 	}
-	return raw_expression_tree_walker(node, insertinto_or_locking_clause_walker, ctx);
+	if (map->funcs)
+		pfree(map->funcs);
+	pfree(map->dbname);
+	pfree(map);
 }
 
 /*
- * Return true if this SELECT has non immutable function calls.
+ * Return true if the statement may change IMMUTABLE functions.  Dropping
+ * or renaming a schema and DROP ... CASCADE may drop or move functions
+ * too.
  */
 bool
-pool_has_non_immutable_function_call(Node *node)
+pool_is_function_ddl(Node *node)
 {
-	SelectContext ctx;
+	if (IsA(node, CreateFunctionStmt) || IsA(node, AlterFunctionStmt))
+		return true;
 
-	if (!IsA(node, SelectStmt))
-		return false;
+	if (IsA(node, DropStmt))
+	{
+		DropStmt   *stmt = (DropStmt *) node;
 
-	ctx.has_non_immutable_function_call = false;
+		return stmt->removeType == OBJECT_FUNCTION || stmt->removeType == OBJECT_SCHEMA ||
+			stmt->behavior == DROP_CASCADE;
+	}
 
-	raw_expression_tree_walker(node, non_immutable_function_call_walker, &ctx);
+	if (IsA(node, RenameStmt))
+	{
+		RenameStmt *stmt = (RenameStmt *) node;
 
-	ereport(DEBUG1,
-			(errmsg("checking if SELECT statement contains the IMMUTABLE function call"),
-			 errdetail("result = %d", ctx.has_non_immutable_function_call)));
+		return stmt->renameType == OBJECT_FUNCTION || stmt->renameType == OBJECT_SCHEMA;
+	}
+
+	if (IsA(node, AlterObjectSchemaStmt))
+		return ((AlterObjectSchemaStmt *) node)->objectType == OBJECT_FUNCTION;
 
-	return ctx.has_non_immutable_function_call;
+	return false;
 }
 
 /*
- * Walker function to find non immutable function call.
+ * Discard all the IMMUTABLE function maps. They will be loaded again when
+ * needed.
  */
-static bool
-non_immutable_function_call_walker(Node *node, void *context)
+void
+pool_discard_immutable_function_maps(void)
 {
-	SelectContext *ctx = (SelectContext *) context;
+	ImmutableFunctionMap *map;
 
-	if (node == NULL)
-		return false;
-
-	if (IsA(node, FuncCall))
+	while ((map = immutable_function_maps) != NULL)
 	{
-		FuncCall   *fcall = (FuncCall *) node;
-		char	   *fname;
-		int			length = list_length(fcall->funcname);
+		immutable_function_maps = map->next;
+		free_immutable_function_map(map);
+	}
+}
 
-		if (length > 0)
-		{
-			if (length == 1)	/* no schema qualification? */
-			{
-				fname = strVal(linitial(fcall->funcname));
-			}
-			else
-			{
-				fname = strVal(lsecond(fcall->funcname));	/* with schema
-															 * qualification */
-			}
+/*
+ * Return IMMUTABLE function map of the database to which relcache queries
+ * are sent. Load it from pg_proc if not loaded yet or expired.
+ */
+static ImmutableFunctionMap *
+get_immutable_function_map(void)
+{
+/*
+ * Query to list IMMUTABLE functions
+ */
+#define IMMUTABLE_FUNCTIONS_QUERY "SELECT DISTINCT n.nspname, p.proname FROM pg_catalog.pg_proc AS p JOIN pg_catalog.pg_namespace AS n ON p.pronamespace = n.oid WHERE p.provolatile = 'i'"
+	POOL_CONNECTION_POOL *backend;
+	POOL_SELECT_RESULT *res;
+	ImmutableFunctionMap *map;
+	ImmutableFunctionMap **prev;
+	MemoryContext old_context;
+	char	   *dbname;
+	int			node_id;
+	time_t		now;
+	uint32		generation;
+	int			i;
 
-			ereport(DEBUG1,
-					(errmsg("non immutable function walker. checking function \"%s\"", fname)));
+	backend = pool_get_session_context(false)->backend;
+	node_id = pool_relcache_query_node(backend, &dbname);
+	now = time(NULL);
+	generation = pool_shared_function_generation();
 
-			/* Check system catalog if the function is immutable */
-			if (is_immutable_function(fname) == false)
-			{
-				/* Non immutable function call found */
-				ctx->has_non_immutable_function_call = true;
-				return false;
-			}
-		}
-	}
-	else if (IsA(node, TypeCast))
+	for (prev = &immutable_function_maps; (map = *prev) != NULL; prev = &map->next)
 	{
-		/* CURRENT_DATE, CURRENT_TIME, LOCALTIMESTAMP, LOCALTIME etc. */
-		TypeCast   *tc = (TypeCast *) node;
-
-		if ((isSystemType((Node *) tc->typeName, "date") ||
-			 isSystemType((Node *) tc->typeName, "timestamp") ||
-			 isSystemType((Node *) tc->typeName, "timestamptz") ||
-			 isSystemType((Node *) tc->typeName, "time") ||
-			 isSystemType((Node *) tc->typeName, "timetz")))
+		if (strcmp(map->dbname, dbname) == 0)
 		{
-			ctx->has_non_immutable_function_call = true;
-			return false;
+			if ((map->expire == 0 || map->expire > now) &&
+				map->generation == generation)
+				return map;
+
+			/* expired or functions changed by other process */
+			*prev = map->next;
+			free_immutable_function_map(map);
+			break;
 		}
 	}
 
-	return raw_expression_tree_walker(node, non_immutable_function_call_walker, context);
+	per_node_statement_log(backend, node_id, IMMUTABLE_FUNCTIONS_QUERY);
+	do_query(CONNECTION(backend, node_id), IMMUTABLE_FUNCTIONS_QUERY, &res, MAJOR(backend));
+
+	old_context = MemoryContextSwitchTo(TopMemoryContext);
+
+	map = palloc0(sizeof(ImmutableFunctionMap));
+	map->dbname = pstrdup(dbname);
+	if (pool_config->relcache_expire > 0)
+		map->expire = now + pool_config->relcache_expire;
+	map->generation = generation;
+	if (res->numrows > 0)
+		map->funcs = palloc(sizeof(ImmutableFunction) * res->numrows);
+
+	for (i = 0; i < res->numrows; i++)
+	{
+		if (res->nullflags[i * 2] == -1 || res->nullflags[i * 2 + 1] == -1)
+			continue;
+		map->funcs[map->nfuncs].schema = pstrdup(res->data[i * 2]);
+		map->funcs[map->nfuncs].name = pstrdup(res->data[i * 2 + 1]);
+		map->nfuncs++;
+	}
+
+	MemoryContextSwitchTo(old_context);
+	free_select_result(res);
+
+	qsort(map->funcs, map->nfuncs, sizeof(ImmutableFunction), immutable_function_cmp);
+
+	map->next = immutable_function_maps;
+	immutable_function_maps = map;
+
+	ereport(DEBUG1,
+			(errmsg("loaded IMMUTABLE function map"),
+			 errdetail("database: \"%s\" %d functions", dbname, map->nfuncs)));
+
+	return map;
 }
 
 /*
- * Check if the function is stable.
+ * Check if the function is immutable. If schema is NULL, the function is
+ * regarded as immutable if IMMUTABLE function of the name exists in any
+ * schema.
  */
 static bool
-is_immutable_function(char *fname)
+is_immutable_function(char *schema, char *fname)
 {
-/*
- * Query to know if the function is IMMUTABLE
- */
-#define IS_STABLE_FUNCTION_QUERY "SELECT count(*) FROM pg_catalog.pg_proc AS p WHERE p.proname = '%s' AND p.provolatile = 'i'"
-	bool		result;
-	static POOL_RELCACHE * relcache;
-	POOL_CONNECTION_POOL *backend;
+	ImmutableFunctionMap *map;
+	int			low;
+	int			high;
+	bool		result = false;
 
-	backend = pool_get_session_context(false)->backend;
+	map = get_immutable_function_map();
 
-	if (!relcache)
+	/* Find the first function of the name */
+	low = 0;
+	high = map->nfuncs;
+	while (low < high)
 	{
-		relcache = pool_create_relcache(pool_config->relcache_size, IS_STABLE_FUNCTION_QUERY,
-										int_register_func, int_unregister_func,
-										false);
-		if (relcache == NULL)
+		int			mid = low + (high - low) / 2;
+
+		if (strcmp(map->funcs[mid].name, fname) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	for (; low < map->nfuncs && strcmp(map->funcs[low].name, fname) == 0; low++)
+	{
+		if (schema == NULL || strcmp(map->funcs[low].schema, schema) == 0)
 		{
-			ereport(WARNING,
-					(errmsg("unable to create relcache, while checking if the function is immutable")));
-			return false;
+			result = true;
+			break;
 		}
-		ereport(DEBUG1,
-				(errmsg("checking if the function is IMMUTABLE"),
-				 errdetail("relcache created")));
 	}
 
-	result = (pool_search_relcache(relcache, backend, fname) == 0) ? 0 : 1;
-
 	ereport(DEBUG1,
 			(errmsg("checking if the function is IMMUTABLE"),
 			 errdetail("search result = %d", result)));
@@ -1078,6 +1185,8 @@ is_immutable_function(char *fname)
 /*
  * Convert table_name(possibly including schema name) to oid
  */
+static POOL_RELCACHE * table_oid_relcache;
+
 int
 pool_table_name_to_oid(char *table_name)
 {
@@ -1089,7 +1198,6 @@ pool_table_name_to_oid(char *table_name)
 #define TABLE_TO_OID_QUERY3 "SELECT COALESCE(pg_catalog.to_regclass('%s')::oid, 0)"
 
 	int			oid = 0;
-	static POOL_RELCACHE * relcache;
 	POOL_CONNECTION_POOL *backend;
 	char	   *query;
 
@@ -1119,12 +1227,12 @@ pool_table_name_to_oid(char *table_name)
 	/*
 	 * If relcache does not exist, create it.
 	 */
-	if (!relcache)
+	if (!table_oid_relcache)
 	{
-		relcache = pool_create_relcache(pool_config->relcache_size, query,
-										int_register_func, int_unregister_func,
-										true);
-		if (relcache == NULL)
+		table_oid_relcache = pool_create_relcache(pool_config->relcache_size, query,
+												  int_register_func, int_unregister_func,
+												  true);
+		if (table_oid_relcache == NULL)
 		{
 			ereport(WARNING,
 					(errmsg("unable to create relcache, getting OID from table name")));
@@ -1136,13 +1244,13 @@ pool_table_name_to_oid(char *table_name)
 		 * there's no such a table. In this case we do not want to cache the
 		 * state because the table might be created later in this session.
 		 */
-		relcache->no_cache_if_zero = true;
+		table_oid_relcache->no_cache_if_zero = true;
 	}
 
 	/*
 	 * Search relcache.
 	 */
-	oid = (int) (intptr_t) pool_search_relcache(relcache, backend, table_name);
+	oid = (int) (intptr_t) pool_search_relcache(table_oid_relcache, backend, table_name);
 	return oid;
 }
 
@@ -1154,25 +1262,43 @@ pool_table_name_to_oid(char *table_name)
 int
 pool_extract_table_oids_from_select_stmt(Node *node, SelectContext * ctx)
 {
+	SelectContext *analysis;
+
 	if (!node)
 		return 0;
 	if (!IsA(node, SelectStmt))
 		return 0;
 
-	ctx->num_oids = 0;
-	raw_expression_tree_walker(node, select_table_walker, ctx);
+	analysis = pool_analyze_select_stmt(node, POOL_SELECT_TABLE_OIDS);
+	if (analysis != ctx)
+	{
+		ctx->num_oids = analysis->num_oids;
+		memcpy(ctx->table_oids, analysis->table_oids, sizeof(int) * analysis->num_oids);
+		memcpy(ctx->table_names, analysis->table_names, POOL_NAMEDATALEN * analysis->num_oids);
+	}
 
 	return ctx->num_oids;
 }
 
 /*
- * Walker function to extract table oids from SELECT statement.
+ * Relation names collected by relation_name_walker().
+ */
+typedef struct
+{
+	int			num_relations;	/* number of relations */
+	char		relnames[POOL_MAX_SELECT_OIDS][POOL_NAMEDATALEN];	/* relname of
+																	 * RangeVar */
+	char		table_names[POOL_MAX_SELECT_OIDS][POOL_NAMEDATALEN * 2 + 1 + 2 * 2 + 1];	/* possibly schema
+																					 * qualified names */
+}			RelationNameContext;
+
+/*
+ * Walker function to collect relation names.
  */
 static bool
-select_table_walker(Node *node, void *context)
+relation_name_walker(Node *node, void *context)
 {
-	SelectContext *ctx = (SelectContext *) context;
-	int			num_oids;
+	RelationNameContext *ctx = (RelationNameContext *) context;
 
 	if (node == NULL)
 		return false;
@@ -1181,37 +1307,187 @@ select_table_walker(Node *node, void *context)
 	{
 		RangeVar   *rgv = (RangeVar *) node;
 		char	   *table;
-		int			oid;
+		int			i;
+
+		if (ctx->num_relations >= POOL_MAX_SELECT_OIDS)
+			return true;
+
+		/*
+		 * Names which need escaping are left to the lookups for the
+		 * individual tables.
+		 */
+		if (rgv->relname == NULL || strlen(rgv->relname) >= POOL_NAMEDATALEN ||
+			strpbrk(rgv->relname, "'\\\"") != NULL ||
+			(rgv->schemaname && strpbrk(rgv->schemaname, "'\\\"") != NULL))
+			return raw_expression_tree_walker(node, relation_name_walker, context);
 
 		table = make_table_name_from_rangevar(rgv);
-		oid = pool_table_name_to_oid(table);
 
-		if (oid)
+		for (i = 0; i < ctx->num_relations; i++)
 		{
-			if (POOL_MAX_SELECT_OIDS <= ctx->num_oids)
-			{
-				ereport(DEBUG1,
-						(errmsg("extracting table oids from SELECT statement"),
-						 errdetail("number of oids = %d exceeds the maximum limit = %d",
-								   ctx->num_oids, POOL_MAX_SELECT_OIDS)));
-				return false;
-			}
+			if (strcmp(ctx->table_names[i], table) == 0)
+				break;
+		}
 
-			num_oids = ctx->num_oids++;
+		if (i == ctx->num_relations)
+		{
+			strlcpy(ctx->relnames[i], rgv->relname, sizeof(ctx->relnames[i]));
+			strlcpy(ctx->table_names[i], table, sizeof(ctx->table_names[i]));
+			ctx->num_relations++;
+		}
+	}
 
-			ctx->table_oids[num_oids] = oid;
-			strlcpy(ctx->table_names[num_oids], table, POOL_NAMEDATALEN);
+	return raw_expression_tree_walker(node, relation_name_walker, context);
+}
 
-			ereport(DEBUG1,
-					(errmsg("extracting table oids from SELECT statement"),
-					 errdetail("ctx->table_names[%d] = \"%s\"",
-							   num_oids, ctx->table_names[num_oids])));
+/*
+ * Look up the attributes of all the relations in the SELECT statement
+ * which are not in relcache yet by a single query and register them to
+ * relcache, rather than sending a query for each relation and attribute.
+ * This is done only if the backend has to_regclass(), which does not
+ * throw an error for nonexistent relation.
+ */
+static void
+prefetch_relation_info(Node *node, int flags)
+{
+#define PREFETCH_RELATION_QUERY "SELECT %d, " \
+	"(SELECT count(*) FROM pg_class AS c, pg_namespace AS n WHERE c.oid = pg_catalog.to_regclass('\"%s\"') AND c.relnamespace = n.oid AND n.nspname = 'pg_catalog'), " \
+	"(SELECT count(*) FROM pg_catalog.pg_class AS c, pg_namespace AS n WHERE c.relname = '%s' AND c.relnamespace = n.oid AND n.nspname ~ '^pg_temp_'), " \
+	"(SELECT count(*) FROM pg_catalog.pg_class AS c WHERE c.oid = pg_catalog.to_regclass('%s') AND c.relpersistence = 'u'), " \
+	"(SELECT count(*) FROM pg_catalog.pg_class AS c WHERE c.oid = pg_catalog.to_regclass('%s') AND (c.relkind = 'v' OR c.relkind = 'm')), " \
+	"COALESCE(pg_catalog.to_regclass('%s')::oid, 0)"
+#define PREFETCH_RELATION_NFIELDS 6
+
+	static RelationNameContext ctx;
+	POOL_SESSION_CONTEXT *session_context;
+	POOL_CONNECTION_POOL *backend;
+	POOL_SELECT_RESULT *res;
+	StringInfoData query;
+	bool		check_temp;
+	char	   *dbname;
+	int			node_id;
+	int			num_unresolved = 0;
+	uint32		generation;
+	int			i;
+
+	if (!(flags & (POOL_SELECT_SYSTEM_CATALOG | POOL_SELECT_TEMP_TABLE |
+				   POOL_SELECT_UNLOGGED_TABLE | POOL_SELECT_VIEW |
+				   POOL_SELECT_TABLE_OIDS)))
+		return;
+
+	session_context = pool_get_session_context(true);
+	if (!session_context || !session_context->backend || !pool_has_to_regclass())
+		return;
+	backend = session_context->backend;
+
+	check_temp = pool_config->check_temp_table == CHECK_TEMP_CATALOG ||
+		pool_config->check_temp_table == CHECK_TEMP_ON;
+
+	/* Create relcache if not yet. The queries are same as is_*() use. */
+	if (!system_catalog_relcache)
+		system_catalog_relcache = pool_create_relcache(pool_config->relcache_size, ISBELONGTOPGCATALOGQUERY3,
+													   int_register_func, int_unregister_func,
+													   false);
+	if (check_temp && !is_temp_table_relcache)
+		is_temp_table_relcache = pool_create_relcache(pool_config->relcache_size, ISTEMPQUERY83,
+													  int_register_func, int_unregister_func,
+													  true);
+	if (!unlogged_table_relcache)
+		unlogged_table_relcache = pool_create_relcache(pool_config->relcache_size, ISUNLOGGEDQUERY3,
+													   int_register_func, int_unregister_func,
+													   false);
+	if (!view_relcache)
+		view_relcache = pool_create_relcache(pool_config->relcache_size, ISVIEWQUERY3,
+											 int_register_func, int_unregister_func,
+											 false);
+	if (!table_oid_relcache)
+	{
+		table_oid_relcache = pool_create_relcache(pool_config->relcache_size, TABLE_TO_OID_QUERY3,
+												  int_register_func, int_unregister_func,
+												  true);
+		if (table_oid_relcache)
+			table_oid_relcache->no_cache_if_zero = true;
+	}
+
+	if (!system_catalog_relcache || (check_temp && !is_temp_table_relcache) ||
+		!unlogged_table_relcache || !view_relcache || !table_oid_relcache)
+		return;
+
+	ctx.num_relations = 0;
+	raw_expression_tree_walker(node, relation_name_walker, &ctx);
+
+	initStringInfo(&query);
+
+	/* Take it before looking at the catalog. See pool_search_relcache(). */
+	node_id = pool_relcache_query_node(backend, &dbname);
+	generation = pool_shared_relcache_generation(dbname);
+
+	/*
+	 * Relations found in the local or shared relation cache are not asked
+	 * to the backend. pool_relcache_contains() copies shared entries to the
+	 * local cache.
+	 */
+	for (i = 0; i < ctx.num_relations; i++)
+	{
+		char	   *relname = ctx.relnames[i];
+		char	   *table = ctx.table_names[i];
+
+		if (((flags & POOL_SELECT_SYSTEM_CATALOG) &&
+			 !pool_relcache_contains(system_catalog_relcache, backend, relname)) ||
+			((flags & POOL_SELECT_TEMP_TABLE) && check_temp &&
+			 !pool_relcache_contains(is_temp_table_relcache, backend, relname)) ||
+			((flags & POOL_SELECT_UNLOGGED_TABLE) &&
+			 !pool_relcache_contains(unlogged_table_relcache, backend, table)) ||
+			((flags & POOL_SELECT_VIEW) &&
+			 !pool_relcache_contains(view_relcache, backend, table)) ||
+			((flags & POOL_SELECT_TABLE_OIDS) &&
+			 !pool_relcache_contains(table_oid_relcache, backend, table)))
+		{
+			if (num_unresolved++ > 0)
+				appendStringInfoString(&query, " UNION ALL ");
+			appendStringInfo(&query, PREFETCH_RELATION_QUERY,
+							 i, relname, relname, table, table, table);
 		}
 	}
 
-	return raw_expression_tree_walker(node, select_table_walker, context);
-}
+	/* Nothing to gain for a single relation */
+	if (num_unresolved < 2)
+	{
+		pfree(query.data);
+		return;
+	}
+
+	ereport(DEBUG1,
+			(errmsg("prefetching relation info"),
+			 errdetail("database:%s number of relations:%d", dbname, num_unresolved)));
+
+	per_node_statement_log(backend, node_id, query.data);
+	do_query(CONNECTION(backend, node_id), query.data, &res, MAJOR(backend));
+	pfree(query.data);
+
+	for (i = 0; i < res->numrows; i++)
+	{
+		char	  **data = &res->data[i * PREFETCH_RELATION_NFIELDS];
+		int			index = atoi(data[0]);
+
+		if (index < 0 || index >= ctx.num_relations)
+			continue;
 
+		/* Also saved in the shared relation cache for other processes */
+		pool_add_relcache(system_catalog_relcache, backend, ctx.relnames[index],
+						  data[1], generation);
+		if (check_temp)
+			pool_add_relcache(is_temp_table_relcache, backend, ctx.relnames[index],
+							  data[2], generation);
+		pool_add_relcache(unlogged_table_relcache, backend, ctx.table_names[index],
+						  data[3], generation);
+		pool_add_relcache(view_relcache, backend, ctx.table_names[index],
+						  data[4], generation);
+		pool_add_relcache(table_oid_relcache, backend, ctx.table_names[index],
+						  data[5], generation);
+	}
+	free_select_result(res);
+}
 
 /*
  * makeRangeVarFromNameList
@@ -21,10 +21,17 @@
  *
  */
 #include "pool.h"
+#include "pool_config.h"
 #include "utils/elog.h"
 #include <errno.h>
+#include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <sys/shm.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 #include "utils/pool_ipc.h"
 
@@ -35,13 +42,27 @@
 #define PG_SHMAT_FLAGS			0
 #endif
 
+/* default size of a huge page if it cannot be obtained from the kernel */
+#define DEFAULT_HUGE_PAGE_SIZE	(2 * 1024 * 1024)
+
+/* memory policies of mbind(2), see <numaif.h> */
+#define POOL_MPOL_INTERLEAVE	3
+#define POOL_MPOL_LOCAL			4
+
 static void IpcMemoryDetach(int status, Datum shmaddr);
 static void IpcMemoryDelete(int status, Datum shmId);
+static void *pool_huge_shared_memory_create(size_t size);
+static size_t get_huge_page_size(void);
+static void set_shared_memory_numa_policy(void *addr, size_t size);
 
 
 /*
  * Create a shared memory segment of the given size and initialize.  Also,
  * register an on_shmem_exit callback to release the storage.
+ *
+ * A new segment is zero-filled by the kernel and its pages are allocated on
+ * first touch, so callers must not clear it again; doing so only makes us
+ * fault in the whole segment at start up.
  */
 void *
 pool_shared_memory_create(size_t size)
@@ -49,6 +70,21 @@ pool_shared_memory_create(size_t size)
 	int			shmid;
 	void	   *memAddress;
 
+	/*
+	 * Large segments such as the query cache and con_info are backed by huge
+	 * pages if possible to reduce TLB misses.  Small segments are always
+	 * created as ordinary SysV shared memory since a huge page for each of
+	 * them would waste most of it.
+	 */
+	if ((pool_config->huge_pages == HUGE_PAGES_ON ||
+		 pool_config->huge_pages == HUGE_PAGES_TRY) &&
+		size >= get_huge_page_size())
+	{
+		memAddress = pool_huge_shared_memory_create(size);
+		if (memAddress != NULL)
+			return memAddress;
+	}
+
 	/* Try to create new segment */
 	shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | IPC_EXCL | IPCProtection);
 
@@ -72,9 +108,134 @@ pool_shared_memory_create(size_t size)
 	/* Register on-exit routine to detach new segment before deleting */
 	on_shmem_exit(IpcMemoryDetach, (Datum) memAddress);
 
+	set_shared_memory_numa_policy(memAddress, size);
+
 	return memAddress;
 }
 
+/*
+ * Create a shared memory segment backed by huge pages. The segment is an
+ * anonymous shared mapping, which is inherited by the children forked
+ * afterwards and released by the kernel when the last process using it
+ * exits, so no on_shmem_exit callback is needed. Returns NULL if huge pages
+ * are not available and huge_pages is "try".
+ */
+static void *
+pool_huge_shared_memory_create(size_t size)
+{
+#ifdef MAP_HUGETLB
+	size_t		huge_page_size = get_huge_page_size();
+	void	   *memAddress;
+
+	/* the size of a huge page mapping must be a multiple of huge page size */
+	size = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+
+	memAddress = mmap(NULL, size, PROT_READ | PROT_WRITE,
+					  MAP_SHARED | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (memAddress == MAP_FAILED)
+	{
+		if (pool_config->huge_pages == HUGE_PAGES_ON)
+			ereport(FATAL,
+					(errmsg("could not create shared memory for request size: %zu", size),
+					 errdetail("mmap with huge pages failed with error \"%s\"", strerror(errno)),
+					 errhint("Set huge_pages to \"try\" or \"off\", or reserve more huge pages by vm.nr_hugepages.")));
+
+		ereport(DEBUG1,
+				(errmsg("could not create shared memory with huge pages for request size: %zu", size),
+				 errdetail("mmap failed with error \"%s\", falling back to ordinary shared memory", strerror(errno))));
+		return NULL;
+	}
+
+	ereport(DEBUG1,
+			(errmsg("created shared memory with huge pages for request size: %zu", size)));
+
+	/*
+	 * mbind(2) on a part of a huge page mapping would split it, which is not
+	 * allowed. Apply the policy to the whole rounded up mapping.
+	 */
+	set_shared_memory_numa_policy(memAddress, size);
+
+	return memAddress;
+#else
+	if (pool_config->huge_pages == HUGE_PAGES_ON)
+		ereport(FATAL,
+				(errmsg("huge pages are not supported on this platform")));
+	return NULL;
+#endif
+}
+
+/*
+ * Returns the default huge page size of the system.
+ */
+static size_t
+get_huge_page_size(void)
+{
+	static size_t huge_page_size = 0;
+#ifdef __linux__
+	FILE	   *fp;
+	char		buf[128];
+	unsigned int sz;
+#endif
+
+	if (huge_page_size > 0)
+		return huge_page_size;
+
+	huge_page_size = DEFAULT_HUGE_PAGE_SIZE;
+
+#ifdef __linux__
+	fp = fopen("/proc/meminfo", "r");
+	if (fp)
+	{
+		while (fgets(buf, sizeof(buf), fp))
+		{
+			if (sscanf(buf, "Hugepagesize: %u kB", &sz) == 1)
+			{
+				if (sz > 0)
+					huge_page_size = (size_t) sz * 1024;
+				break;
+			}
+		}
+		fclose(fp);
+	}
+#endif
+
+	return huge_page_size;
+}
+
+/*
+ * Apply shared_memory_numa_policy to a newly created segment. Since no
+ * page of the segment has been touched yet, the policy decides where all
+ * of its pages are allocated. By default the pages are allocated on the
+ * NUMA node of the process touching them first.
+ */
+static void
+set_shared_memory_numa_policy(void *addr, size_t size)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+	unsigned long nodemask = ~0UL;
+	int			mode;
+
+	if (pool_config->shared_memory_numa_policy == SHMEM_NUMA_INTERLEAVE)
+		mode = POOL_MPOL_INTERLEAVE;
+	else if (pool_config->shared_memory_numa_policy == SHMEM_NUMA_LOCAL)
+		mode = POOL_MPOL_LOCAL;
+	else
+		return;
+
+	/* mbind(2) needs a page aligned range */
+	size += (uintptr_t) addr % getpagesize();
+	addr = (char *) addr - (uintptr_t) addr % getpagesize();
+
+	if (syscall(SYS_mbind, addr, size, mode,
+				mode == POOL_MPOL_INTERLEAVE ? &nodemask : NULL,
+				mode == POOL_MPOL_INTERLEAVE ? sizeof(nodemask) * 8 : 0,
+				0) != 0)
+		ereport(LOG,
+				(errmsg("could not set NUMA memory policy of shared memory"),
+				 errdetail("mbind failed with error \"%s\"", strerror(errno))));
+#endif
+}
+
 /*
  * Removes a shared memory segment from process' address spaceq (called as
  * an on_shmem_exit callback, hence funny argument list)
@@ -68,9 +68,6 @@ static bool initialize_ecdh(SSL_CTX *context);
 
 #include <arpa/inet.h>			/* for htonl() */
 
-/* Major/minor codes to negotiate SSL prior to startup packet */
-#define NEGOTIATE_SSL_CODE ( 1234<<16 | 5679 )
-
 /* enum flag for differentiating server->client vs client->server SSL */
 enum ssl_conn_type
 {
@@ -88,20 +85,46 @@ static void perror_ssl(const char *context);
  */
 void
 pool_ssl_negotiate_clientserver(POOL_CONNECTION * cp)
+{
+	if (pool_ssl_request_clientserver(cp))
+		pool_ssl_complete_clientserver(cp);
+}
+
+/*
+ * Send SSL request to PostgreSQL backend. Returns true if the request was
+ * sent, in which case the caller must call pool_ssl_complete_clientserver()
+ * before sending anything else to the backend. Splitting the negotiation
+ * allows to send the requests to all backends before waiting for any of
+ * the responses.
+ */
+bool
+pool_ssl_request_clientserver(POOL_CONNECTION * cp)
 {
 	int			ssl_packet[2] = {htonl(sizeof(int) * 2), htonl(NEGOTIATE_SSL_CODE)};
-	char		server_response;
 
 	cp->ssl_active = -1;
 
 	if ((!pool_config->ssl) || init_ssl_ctx(cp, ssl_conn_clientserver))
-		return;
+		return false;
 
 	ereport(DEBUG1,
 			(errmsg("attempting to negotiate a secure connection"),
 			 errdetail("sending client->server SSL request")));
 	pool_write_and_flush(cp, ssl_packet, sizeof(int) * 2);
 
+	return true;
+}
+
+/*
+ * Read the response to the SSL request sent by
+ * pool_ssl_request_clientserver() and do SSL handshake if the backend
+ * accepted it.
+ */
+void
+pool_ssl_complete_clientserver(POOL_CONNECTION * cp)
+{
+	char		server_response;
+
 	if (pool_read(cp, &server_response, 1) < 0)
 	{
 		ereport(WARNING,
@@ -887,6 +910,19 @@ pool_ssl_negotiate_clientserver(POOL_CONNECTION * cp)
 	cp->ssl_active = -1;
 }
 
+bool
+pool_ssl_request_clientserver(POOL_CONNECTION * cp)
+{
+	pool_ssl_negotiate_clientserver(cp);
+	return false;
+}
+
+void
+pool_ssl_complete_clientserver(POOL_CONNECTION * cp)
+{
+	return;
+}
+
 void
 pool_ssl_close(POOL_CONNECTION * cp)
 {
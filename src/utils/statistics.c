@@ -18,9 +18,12 @@
 
 #include <unistd.h>
 #include <string.h>
+#include <ctype.h>
 
 #include "pool.h"
+#include "pool_config.h"
 #include "parser/nodes.h"
+#include "utils/palloc.h"
 
 /*
  * Per backend node stat area in shared memory
@@ -33,9 +36,46 @@ typedef struct
 	uint64		delete_cnt;		/* number of DELETE queries issued */
 	uint64		ddl_cnt;		/* number of DDL queries issued */
 	uint64		other_cnt;		/* number of any other queries issued */
+	double		latency;		/* moving average of query response time in
+								 * micro seconds */
 }			PER_NODE_STAT;
 
+/*
+ * Per child process stat area in shared memory. Since each child process
+ * processes queries one by one, a child has at most one query waiting for
+ * response per backend node.  Keeping the flags per child, rather than a
+ * shared counter, lets us update them without locking.
+ */
+typedef struct
+{
+	bool		outstanding[MAX_NUM_BACKENDS];	/* true if waiting for response */
+}			PER_CHILD_STAT;
+
+/* Weight of the newest sample in the moving average of latency */
+#define LATENCY_SMOOTHING_FACTOR	0.1
+
+/*
+ * Cost of SELECT queries in shared memory, used to route heavy queries to
+ * ANALYTICS nodes.  Queries are identified by the fingerprint of the
+ * query string with literals replaced. Slots are direct mapped by the
+ * fingerprint and a slot is taken over by a colliding query.
+ */
+typedef struct
+{
+	uint64		fingerprint;	/* query fingerprint, 0 if unused */
+	double		time;			/* moving average of execution time in
+								 * micro seconds */
+	double		rows;			/* moving average of number of rows */
+}			QUERY_COST_STAT;
+
+#define NUM_QUERY_COST_STATS	4096
+
+/* Weight of the newest sample in the moving average of query cost */
+#define COST_SMOOTHING_FACTOR	0.2
+
 static volatile PER_NODE_STAT *per_node_stat;
+static volatile PER_CHILD_STAT *per_child_stat;
+static volatile QUERY_COST_STAT *query_cost_stat;
 
 /*
  * Return shared memory size necessary for this module
@@ -48,6 +88,12 @@ stat_shared_memory_size(void)
 	/* query counter area */
 	size = MAXALIGN(MAX_NUM_BACKENDS * sizeof(PER_NODE_STAT));
 
+	/* outstanding query area */
+	size += MAXALIGN(pool_config->num_init_children * sizeof(PER_CHILD_STAT));
+
+	/* query cost area */
+	size += MAXALIGN(NUM_QUERY_COST_STATS * sizeof(QUERY_COST_STAT));
+
 	return size;
 }
 
@@ -59,6 +105,10 @@ void
 stat_set_stat_area(void *address)
 {
 	per_node_stat = (PER_NODE_STAT *) address;
+	per_child_stat = (PER_CHILD_STAT *) ((char *) address +
+										 MAXALIGN(MAX_NUM_BACKENDS * sizeof(PER_NODE_STAT)));
+	query_cost_stat = (QUERY_COST_STAT *) ((char *) per_child_stat +
+										   MAXALIGN(pool_config->num_init_children * sizeof(PER_CHILD_STAT)));
 }
 
 /*
@@ -101,3 +151,230 @@ stat_get_select_count(int backend_node_id)
 {
 	return per_node_stat[backend_node_id].select_cnt;
 }
+
+/*
+ * Remember that a query has been sent to the backend node and we are
+ * waiting for the response.
+ */
+void
+stat_query_sent(int backend_node_id)
+{
+	if (processType != PT_CHILD)
+		return;
+
+	per_child_stat[my_proc_id].outstanding[backend_node_id] = true;
+}
+
+/*
+ * Called when the response of the query sent at "sent_time" arrived.
+ * Updates moving average of the response time of the backend node.
+ */
+void
+stat_query_responded(int backend_node_id, struct timeval *sent_time)
+{
+	struct timeval now;
+	double		elapsed;
+
+	if (processType != PT_CHILD)
+		return;
+
+	per_child_stat[my_proc_id].outstanding[backend_node_id] = false;
+
+	gettimeofday(&now, NULL);
+	elapsed = (now.tv_sec - sent_time->tv_sec) * 1000000.0 +
+		(now.tv_usec - sent_time->tv_usec);
+	if (elapsed < 0)
+		return;
+
+	/*
+	 * Concurrent updates by other child processes may be lost, which is
+	 * acceptable for a moving average.
+	 */
+	if (per_node_stat[backend_node_id].latency == 0.0)
+		per_node_stat[backend_node_id].latency = elapsed;
+	else
+		per_node_stat[backend_node_id].latency +=
+			LATENCY_SMOOTHING_FACTOR * (elapsed - per_node_stat[backend_node_id].latency);
+}
+
+/*
+ * Forget queries of this process waiting for response. Called when the
+ * session ends, since the query may have been aborted by an error.
+ */
+void
+stat_reset_outstanding_queries(void)
+{
+	if (processType != PT_CHILD)
+		return;
+
+	memset((void *) &per_child_stat[my_proc_id], 0, sizeof(PER_CHILD_STAT));
+}
+
+/*
+ * Return number of queries waiting for response of the backend node.
+ */
+int
+stat_get_outstanding_queries(int backend_node_id)
+{
+	int			i;
+	int			count = 0;
+
+	for (i = 0; i < pool_config->num_init_children; i++)
+	{
+		if (per_child_stat[i].outstanding[backend_node_id])
+			count++;
+	}
+	return count;
+}
+
+/*
+ * Return moving average of query response time of the backend node in
+ * micro seconds. 0 means no query has been measured yet.
+ */
+double
+stat_get_query_latency(int backend_node_id)
+{
+	return per_node_stat[backend_node_id].latency;
+}
+
+/*
+ * Return fingerprint of the query. Literals are replaced with '?', a list
+ * of literals is treated as one literal, white spaces are squashed and
+ * keywords and identifiers are down cased, so that queries differing only
+ * in constants have the same fingerprint.
+ */
+uint64
+stat_query_fingerprint(const char *query)
+{
+	uint64		h = 14695981039346656037ULL;
+	const char *p = query;
+	char	   *buf;
+	int			len = 0;
+	int			i;
+
+	buf = palloc(strlen(query) + 1);
+
+	while (*p)
+	{
+		char		prev = len > 0 ? buf[len - 1] : ' ';
+
+		if (isspace((unsigned char) *p))
+		{
+			/* squash white spaces */
+			if (prev != ' ')
+				buf[len++] = ' ';
+			p++;
+		}
+		else if (*p == '\'' ||
+				 ((*p == 'E' || *p == 'e') && p[1] == '\'' && !isalnum((unsigned char) prev)))
+		{
+			/* string literal */
+			if (*p != '\'')
+				p++;
+			for (p++; *p; p++)
+			{
+				if (*p == '\\' && p[1])
+					p++;
+				else if (*p == '\'')
+				{
+					if (p[1] != '\'')
+						break;
+					p++;
+				}
+			}
+			if (*p)
+				p++;
+			goto literal;
+		}
+		else if (isdigit((unsigned char) *p) && !isalnum((unsigned char) prev) &&
+				 prev != '_' && prev != '$')
+		{
+			/* numeric literal */
+			while (isalnum((unsigned char) *p) || *p == '.')
+				p++;
+			goto literal;
+		}
+		else if (*p == '"')
+		{
+			/* quoted identifier is kept as is */
+			do
+			{
+				buf[len++] = *p++;
+			} while (*p && *p != '"');
+			if (*p)
+				buf[len++] = *p++;
+		}
+		else
+			buf[len++] = tolower((unsigned char) *p++);
+		continue;
+
+literal:
+		/* a list of literals "?, ?, ?" is squashed into "?" */
+		while (len > 0 && buf[len - 1] == ' ')
+			len--;
+		if (len >= 2 && buf[len - 1] == ',' && buf[len - 2] == '?')
+			len--;
+		else
+		{
+			if (prev == ' ')
+				buf[len++] = ' ';
+			buf[len++] = '?';
+		}
+	}
+
+	for (i = 0; i < len; i++)
+		h = (h ^ (unsigned char) buf[i]) * 1099511628211ULL;
+	pfree(buf);
+
+	return h ? h : 1;
+}
+
+/*
+ * Record execution time in micro seconds and number of rows of the query.
+ * Concurrent updates by other child processes may be lost, which is
+ * acceptable for an estimation.
+ */
+void
+stat_record_query_cost(uint64 fingerprint, double time, uint64 rows)
+{
+	volatile QUERY_COST_STAT *stat;
+
+	stat = &query_cost_stat[fingerprint % NUM_QUERY_COST_STATS];
+
+	if (stat->fingerprint != fingerprint)
+	{
+		stat->fingerprint = fingerprint;
+		stat->time = time;
+		stat->rows = rows;
+		return;
+	}
+
+	stat->time += COST_SMOOTHING_FACTOR * (time - stat->time);
+	stat->rows += COST_SMOOTHING_FACTOR * ((double) rows - stat->rows);
+}
+
+/*
+ * Return true if the query has been heavy according to
+ * heavy_query_time_threshold and heavy_query_rows_threshold.  Queries
+ * never recorded are regarded as light.
+ */
+bool
+stat_is_heavy_query(uint64 fingerprint)
+{
+	volatile QUERY_COST_STAT *stat;
+
+	stat = &query_cost_stat[fingerprint % NUM_QUERY_COST_STATS];
+
+	if (stat->fingerprint != fingerprint)
+		return false;
+
+	if (pool_config->heavy_query_time_threshold > 0 &&
+		stat->time >= pool_config->heavy_query_time_threshold * 1000.0)
+		return true;
+
+	if (pool_config->heavy_query_rows_threshold > 0 &&
+		stat->rows >= pool_config->heavy_query_rows_threshold)
+		return true;
+
+	return false;
+}